@@ -0,0 +1,177 @@
+#include <examples/ace/logging/logrecord.pb.h>
+
+#include <muduo/base/Atomic.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/ProcessInfo.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/protobuf/ProtobufCodecLite.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+// load generator of server.cc, every connection sends records as fast as
+// the server takes them, sustained records/sec is printed.
+
+namespace logging
+{
+extern const char logtag[] = "LOG0";
+typedef ProtobufCodecLiteT<LogRecord, logtag> Codec;
+
+const int kRecordsPerFill = 1000;
+const size_t kHighWaterMark = 1024 * 1024;
+
+AtomicInt64 g_records;
+
+class BenchClient : noncopyable
+{
+ public:
+  BenchClient(EventLoop* loop, const InetAddress& serverAddr,
+              const string& name, const string& tenant)
+    : client_(loop, serverAddr, name),
+      tenant_(tenant),
+      codec_(std::bind(&BenchClient::onMessage, this, _1, _2, _3)),
+      seq_(0)
+  {
+    client_.setConnectionCallback(
+        std::bind(&BenchClient::onConnection, this, _1));
+    client_.setWriteCompleteCallback(
+        std::bind(&BenchClient::onWriteComplete, this, _1));
+  }
+
+  void connect()
+  {
+    client_.connect();
+  }
+
+  void disconnect()
+  {
+    client_.disconnect();
+  }
+
+ private:
+  void onConnection(const TcpConnectionPtr& conn)
+  {
+    if (conn->connected())
+    {
+      conn->setTcpNoDelay(true);
+      LogRecord record;
+      LogRecord_Heartbeat* hb = record.mutable_heartbeat();
+      hb->set_hostname(ProcessInfo::hostname().c_str());
+      hb->set_process_name(ProcessInfo::procname().c_str());
+      hb->set_process_id(ProcessInfo::pid());
+      hb->set_process_start_time(ProcessInfo::startTime().microSecondsSinceEpoch());
+      hb->set_username(ProcessInfo::username().c_str());
+      hb->set_tenant(tenant_.c_str());
+      record.set_level(2);
+      record.set_thread_id(CurrentThread::tid());
+      record.set_timestamp(Timestamp::now().microSecondsSinceEpoch());
+      record.set_message("Heartbeat");
+      codec_.send(conn, record);
+      fill(conn);
+    }
+  }
+
+  void onWriteComplete(const TcpConnectionPtr& conn)
+  {
+    fill(conn);
+  }
+
+  void fill(const TcpConnectionPtr& conn)
+  {
+    if (!conn->connected() || conn->outputBuffer()->readableBytes() > kHighWaterMark)
+    {
+      return;
+    }
+    char message[128];
+    for (int i = 0; i < kRecordsPerFill; ++i)
+    {
+      int n = snprintf(message, sizeof message,
+                       "%s request %" PRId64 " served in 42 us", tenant_.c_str(), seq_++);
+      record_.set_level(2);
+      record_.set_thread_id(CurrentThread::tid());
+      record_.set_timestamp(Timestamp::now().microSecondsSinceEpoch());
+      record_.set_message(message, n);
+      codec_.send(conn, record_);
+    }
+    g_records.add(kRecordsPerFill);
+  }
+
+  void onMessage(const TcpConnectionPtr&, const MessagePtr&, Timestamp)
+  {
+  }
+
+  TcpClient client_;
+  const string tenant_;
+  Codec codec_;
+  LogRecord record_;
+  int64_t seq_;
+};
+
+}  // namespace logging
+
+int64_t g_lastRecords = 0;
+int g_seconds = 0;
+int g_elapsed = 0;
+EventLoop* g_loop = NULL;
+
+void printRate()
+{
+  int64_t records = logging::g_records.get();
+  printf("%d records/s %" PRId64 "\n", ++g_elapsed, records - g_lastRecords);
+  g_lastRecords = records;
+  if (g_elapsed >= g_seconds)
+  {
+    g_loop->quit();
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    printf("usage: %s server_ip server_port [connections [seconds [tenants]]]\n", argv[0]);
+    return 0;
+  }
+  Logger::setLogLevel(Logger::WARN);
+  uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
+  InetAddress serverAddr(argv[1], port);
+  int connections = argc > 3 ? atoi(argv[3]) : 4;
+  g_seconds = argc > 4 ? atoi(argv[4]) : 10;
+  int tenants = argc > 5 ? atoi(argv[5]) : connections;
+
+  EventLoop loop;
+  g_loop = &loop;
+  EventLoopThreadPool threadPool(&loop, "bench");
+  threadPool.setThreadNum(connections < 4 ? connections : 4);
+  threadPool.start();
+
+  std::vector<std::unique_ptr<logging::BenchClient>> clients;
+  for (int i = 0; i < connections; ++i)
+  {
+    char name[32], tenant[32];
+    snprintf(name, sizeof name, "bench%d", i);
+    snprintf(tenant, sizeof tenant, "tenant%d", i % tenants);
+    clients.emplace_back(new logging::BenchClient(threadPool.getNextLoop(),
+                                                  serverAddr, name, tenant));
+    clients.back()->connect();
+  }
+
+  Timestamp start(Timestamp::now());
+  loop.runEvery(1.0, printRate);
+  loop.loop();
+  double seconds = timeDifference(Timestamp::now(), start);
+  printf("%d connections, %.0f records/s sustained\n",
+         connections, static_cast<double>(logging::g_records.get()) / seconds);
+
+  for (auto& client : clients)
+  {
+    client->disconnect();
+  }
+  CurrentThread::sleepUsec(500*1000);  // wait for disconnect, see client.cc
+  google::protobuf::ShutdownProtobufLibrary();
+}
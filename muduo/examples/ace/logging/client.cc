@@ -25,8 +25,9 @@ typedef ProtobufCodecLiteT<LogRecord, logtag> Codec;
 class LogClient : noncopyable
 {
  public:
-  LogClient(EventLoop* loop, const InetAddress& serverAddr)
+  LogClient(EventLoop* loop, const InetAddress& serverAddr, const string& tenant)
     : client_(loop, serverAddr, "LogClient"),
+      tenant_(tenant),
       codec_(std::bind(&LogClient::onMessage, this, _1, _2, _3))
   {
     client_.setConnectionCallback(
@@ -77,6 +78,10 @@ class LogClient : noncopyable
       hb->set_process_id(ProcessInfo::pid());
       hb->set_process_start_time(ProcessInfo::startTime().microSecondsSinceEpoch());
       hb->set_username(ProcessInfo::username().c_str());
+      if (!tenant_.empty())
+      {
+        hb->set_tenant(tenant_.c_str());
+      }
       updateLogRecord("Heartbeat");
       codec_.send(connection_, logRecord_);
       logRecord_.clear_heartbeat();
@@ -107,6 +112,7 @@ class LogClient : noncopyable
   }
 
   TcpClient client_;
+  const string tenant_;
   Codec codec_;
   MutexLock mutex_;
   LogRecord logRecord_ GUARDED_BY(mutex_);
@@ -119,7 +125,7 @@ int main(int argc, char* argv[])
 {
   if (argc < 3)
   {
-    printf("usage: %s server_ip server_port\n", argv[0]);
+    printf("usage: %s server_ip server_port [tenant]\n", argv[0]);
   }
   else
   {
@@ -127,7 +133,8 @@ int main(int argc, char* argv[])
     uint16_t port = static_cast<uint16_t>(atoi(argv[2]));
     InetAddress serverAddr(argv[1], port);
 
-    logging::LogClient client(loopThread.startLoop(), serverAddr);
+    string tenant = argc > 3 ? argv[3] : "";
+    logging::LogClient client(loopThread.startLoop(), serverAddr, tenant);
     client.connect();
     std::string line;
     while (std::getline(std::cin, line))
@@ -1,95 +1,347 @@
 #include <examples/ace/logging/logrecord.pb.h>
 
-#include <muduo/base/Atomic.h>
-#include <muduo/base/FileUtil.h>
+#include <muduo/base/FutexBlockingQueue.h>
+#include <muduo/base/LockFreeQueue.h>
+#include <muduo/base/LogFile.h>
 #include <muduo/base/Logging.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/Thread.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/TcpServer.h>
 #include <muduo/net/protobuf/ProtobufCodecLite.h>
 
+#include <atomic>
+#include <map>
+#include <vector>
+
 #include <stdio.h>
 
 using namespace muduo;
 using namespace muduo::net;
 
+// Central collector: sessions are spread over io threads, records are
+// formatted to text lines on the io thread and handed in batches, lock free,
+// to the writer thread of their tenant, which appends them to LogFile of the
+// tenant. io threads never touch disk, a batch is dropped and counted when
+// its writer falls behind.
+
 namespace logging
 {
 extern const char logtag[] = "LOG0";
-typedef ProtobufCodecLiteT<LogRecord, logtag> Codec;
+
+const int kFlushSeconds = 1;
+const size_t kMaxBatchSize = 256 * 1024;
+
+// text lines of one tenant, empty tenant asks writer to flush.
+struct Batch
+{
+  string tenant;
+  string data;
+  int records;
+
+  Batch() : records(0) { }
+};
+typedef std::unique_ptr<Batch> BatchPtr;
+
+// one shard of tenants, owns their files.
+class Writer : noncopyable
+{
+ public:
+  Writer(const string& dir, off_t rollSize, size_t queueSize, int id)
+    : dir_(dir),
+      rollSize_(rollSize),
+      queue_(queueSize),
+      thread_(std::bind(&Writer::threadFunc, this), "Writer" + std::to_string(id))
+  {
+    thread_.start();
+  }
+
+  ~Writer()
+  {
+    queue_.put(BatchPtr());  // stop
+    thread_.join();
+  }
+
+  // never blocks, false if queue is full.
+  bool post(BatchPtr batch)
+  {
+    return queue_.tryPut(std::move(batch));
+  }
+
+  size_t queueSize() const { return queue_.size(); }
+
+ private:
+  void threadFunc()
+  {
+    const size_t kMaxTake = 64;
+    BatchPtr batches[kMaxTake];
+    bool running = true;
+    while (running)
+    {
+      size_t n = queue_.takeBatch(batches, kMaxTake);
+      for (size_t i = 0; i < n; ++i)
+      {
+        if (!batches[i])
+        {
+          running = false;
+        }
+        else if (batches[i]->tenant.empty())
+        {
+          flushAll();
+        }
+        else
+        {
+          file(batches[i]->tenant)->append(batches[i]->data.data(),
+                                           static_cast<int>(batches[i]->data.size()));
+        }
+        batches[i].reset();
+      }
+    }
+    flushAll();
+  }
+
+  LogFile* file(const string& tenant)
+  {
+    std::unique_ptr<LogFile>& file = files_[tenant];
+    if (!file)
+    {
+      file.reset(new LogFile(tenant, dir_, rollSize_, false, kFlushSeconds));
+    }
+    return file.get();
+  }
+
+  void flushAll()
+  {
+    for (auto& it : files_)
+    {
+      it.second->flush();
+    }
+  }
+
+  const string dir_;
+  const off_t rollSize_;
+  FutexBlockingQueue<MpmcQueue<BatchPtr>> queue_;
+  Thread thread_;
+  std::map<string, std::unique_ptr<LogFile>> files_;  // in thread_
+};
+
+// file names come from clients.
+string sanitizeTenant(const string& name)
+{
+  string tenant(name, 0, 64);
+  for (char& c : tenant)
+  {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.')
+    {
+      c = '_';
+    }
+  }
+  if (tenant.empty() || tenant[0] == '.')
+  {
+    tenant.insert(0, "t");
+  }
+  return tenant;
+}
 
 class Session : noncopyable
 {
  public:
-  explicit Session(const TcpConnectionPtr& conn)
-    : codec_(std::bind(&Session::onMessage, this, _1, _2, _3)),
-      file_(getFileName(conn))
+  Session(const TcpConnectionPtr& conn, std::vector<std::unique_ptr<Writer>>* writers)
+    : name_(conn->name()),
+      codec_(&LogRecord::default_instance(), logtag,
+             std::bind(&Session::onUnexpected, this, _1, _2, _3),
+             std::bind(&Session::onRawMessage, this, _1, _2, _3)),
+      writers_(writers),
+      writer_(NULL),
+      lastSecond_(0),
+      records_(0),
+      bytes_(0),
+      dropped_(0),
+      lastRecords_(0),
+      lastBytes_(0)
   {
+    setTenant(conn->peerAddress().toIp(), conn->peerAddress().toIp());
     conn->setMessageCallback(
-        std::bind(&Codec::onMessage, &codec_, _1, _2, _3));
+        std::bind(&Session::onMessage, this, _1, _2, _3));
+  }
+
+  ~Session()
+  {
+    flushBatch();
+  }
+
+  const string& name() const { return name_; }
+  string tenant() const
+  {
+    MutexLockGuard lock(mutex_);
+    return tenant_;
+  }
+
+  // records/s and bytes/s since last call, by the stats timer only.
+  void rates(double seconds, double* records, double* bytes, int64_t* dropped)
+  {
+    int64_t r = records_.load(std::memory_order_relaxed);
+    int64_t b = bytes_.load(std::memory_order_relaxed);
+    *records = static_cast<double>(r - lastRecords_) / seconds;
+    *bytes = static_cast<double>(b - lastBytes_) / seconds;
+    *dropped = dropped_.load(std::memory_order_relaxed);
+    lastRecords_ = r;
+    lastBytes_ = b;
   }
 
  private:
+  // a read may carry many records, they go to the writer as one batch.
+  void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp receiveTime)
+  {
+    codec_.onMessage(conn, buf, receiveTime);
+    flushBatch();
+  }
 
-  // FIXME: duplicate code LogFile
-  // or use LogFile instead
-  string getFileName(const TcpConnectionPtr& conn)
+  // parses into record_, no message is allocated per record.
+  bool onRawMessage(const TcpConnectionPtr&, StringPiece raw, Timestamp)
   {
-    string filename;
-    filename += conn->peerAddress().toIp();
+    const int headerLen = ProtobufCodecLite::kHeaderLen;
+    if (codec_.parse(raw.data() + headerLen, raw.size() - headerLen, &record_)
+        != ProtobufCodecLite::kNoError)
+    {
+      return true;  // codec reports the error
+    }
+    if (record_.has_heartbeat())
+    {
+      const LogRecord::Heartbeat& hb = record_.heartbeat();
+      char origin[256];
+      snprintf(origin, sizeof origin, "%s:%d", hb.hostname().c_str(), hb.process_id());
+      flushBatch();
+      setTenant(hb.has_tenant() ? hb.tenant() : hb.hostname(), origin);
+    }
+    appendRecord(record_);
+    records_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(raw.size(), std::memory_order_relaxed);
+    if (batch_->data.size() >= kMaxBatchSize)
+    {
+      flushBatch();
+    }
+    return false;
+  }
 
-    char timebuf[32];
-    struct tm tm;
-    time_t now = time(NULL);
-    gmtime_r(&now, &tm); // FIXME: localtime_r ?
-    strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S.", &tm);
-    filename += timebuf;
+  void onUnexpected(const TcpConnectionPtr&, const MessagePtr&, Timestamp)
+  {
+  }
 
-    char buf[32];
-    snprintf(buf, sizeof buf, "%d", globalCount_.incrementAndGet());
-    filename += buf;
+  void setTenant(const string& name, const string& origin)
+  {
+    string tenant(sanitizeTenant(name));
+    {
+    MutexLockGuard lock(mutex_);
+    tenant_ = tenant;
+    }
+    origin_ = origin;
+    writer_ = (*writers_)[std::hash<string>()(tenant) % writers_->size()].get();
+    newBatch(tenant);
+  }
 
-    filename += ".log";
-    LOG_INFO << "Session of " << conn->name() << " file " << filename;
-    return filename;
+  void newBatch(const string& tenant)
+  {
+    batch_.reset(new Batch);
+    batch_->tenant = tenant;
+    batch_->data.reserve(kMaxBatchSize + 4096);
   }
 
-  void onMessage(const TcpConnectionPtr& conn,
-                 const MessagePtr& message,
-                 Timestamp time)
+  void flushBatch()
   {
-    LogRecord* logRecord = muduo::down_cast<LogRecord*>(message.get());
-    if (logRecord->has_heartbeat())
+    if (batch_ && batch_->records > 0)
     {
-      // FIXME ?
+      string tenant(batch_->tenant);
+      int records = batch_->records;
+      if (!writer_->post(std::move(batch_)))
+      {
+        dropped_.fetch_add(records, std::memory_order_relaxed);
+      }
+      newBatch(tenant);
     }
-    const char* sep = "==========\n";
-    std::string str = logRecord->DebugString();
-    file_.append(str.c_str(), str.size());
-    file_.append(sep, strlen(sep));
-    LOG_DEBUG << str;
   }
 
-  Codec codec_;
-  FileUtil::AppendFile file_;
-  static AtomicInt32 globalCount_;
+  // 20180101 12:00:00.123456 1234 INFO  message - host:pid
+  void appendRecord(const LogRecord& record)
+  {
+    static const char* const kLevelNames[] =
+    {
+      "TRACE ", "DEBUG ", "INFO  ", "WARN  ", "ERROR ", "FATAL ",
+    };
+    int64_t us = record.timestamp();
+    time_t seconds = static_cast<time_t>(us / Timestamp::kMicroSecondsPerSecond);
+    if (seconds != lastSecond_)
+    {
+      lastSecond_ = seconds;
+      struct tm tm;
+      gmtime_r(&seconds, &tm);
+      strftime(second_, sizeof second_, "%Y%m%d %H:%M:%S", &tm);
+    }
+    int level = record.level();
+    char head[128];
+    int n = snprintf(head, sizeof head, "%s.%06d %d %s", second_,
+                     static_cast<int>(us % Timestamp::kMicroSecondsPerSecond),
+                     record.thread_id(),
+                     level >= 0 && level < 6 ? kLevelNames[level] : "?     ");
+    string& data = batch_->data;
+    data.append(head, static_cast<size_t>(n));
+    const string& message = record.message();
+    size_t len = message.size();
+    while (len > 0 && message[len - 1] == '\n')
+    {
+      --len;
+    }
+    data.append(message, 0, len);
+    data.append(" - ");
+    data.append(origin_);
+    data.push_back('\n');
+    ++batch_->records;
+  }
+
+  const string name_;
+  ProtobufCodecLite codec_;
+  LogRecord record_;
+  std::vector<std::unique_ptr<Writer>>* writers_;
+  // below are in io thread
+  Writer* writer_;
+  string origin_;
+  BatchPtr batch_;
+  time_t lastSecond_;
+  char second_[32];
+
+  mutable MutexLock mutex_;
+  string tenant_ GUARDED_BY(mutex_);
+
+  std::atomic<int64_t> records_;
+  std::atomic<int64_t> bytes_;
+  std::atomic<int64_t> dropped_;
+  // by stats timer
+  int64_t lastRecords_;
+  int64_t lastBytes_;
 };
 typedef std::shared_ptr<Session> SessionPtr;
 
-AtomicInt32 Session::globalCount_;
-
 class LogServer : noncopyable
 {
  public:
-  LogServer(EventLoop* loop, const InetAddress& listenAddr, int numThreads)
+  LogServer(EventLoop* loop, const InetAddress& listenAddr, int numThreads,
+            int numWriters, const string& dir, double statsSeconds)
     : loop_(loop),
-      server_(loop_, listenAddr, "AceLoggingServer")
+      server_(loop_, listenAddr, "AceLoggingServer"),
+      statsSeconds_(statsSeconds)
   {
+    for (int i = 0; i < numWriters; ++i)
+    {
+      writers_.emplace_back(new Writer(dir, 1024*1024*1024, 4096, i));
+    }
     server_.setConnectionCallback(
         std::bind(&LogServer::onConnection, this, _1));
     if (numThreads > 1)
     {
       server_.setThreadNum(numThreads);
     }
+    loop_->runEvery(kFlushSeconds, std::bind(&LogServer::flushWriters, this));
+    loop_->runEvery(statsSeconds_, std::bind(&LogServer::printStats, this));
   }
 
   void start()
@@ -102,30 +354,94 @@ class LogServer : noncopyable
   {
     if (conn->connected())
     {
-      SessionPtr session(new Session(conn));
+      SessionPtr session(new Session(conn, &writers_));
       conn->setContext(session);
+      MutexLockGuard lock(mutex_);
+      sessions_[conn->name()] = session;
     }
     else
     {
       conn->setContext(SessionPtr());
+      MutexLockGuard lock(mutex_);
+      sessions_.erase(conn->name());
     }
   }
 
+  void flushWriters()
+  {
+    for (auto& writer : writers_)
+    {
+      writer->post(BatchPtr(new Batch));
+    }
+  }
+
+  // per client ingest rate
+  void printStats()
+  {
+    std::vector<SessionPtr> sessions;
+    {
+    MutexLockGuard lock(mutex_);
+    for (auto& it : sessions_)
+    {
+      SessionPtr session(it.second.lock());
+      if (session)
+      {
+        sessions.push_back(session);
+      }
+    }
+    }
+    double totalRecords = 0, totalBytes = 0;
+    for (const SessionPtr& session : sessions)
+    {
+      double records = 0, bytes = 0;
+      int64_t dropped = 0;
+      session->rates(statsSeconds_, &records, &bytes, &dropped);
+      totalRecords += records;
+      totalBytes += bytes;
+      if (records > 0 || dropped > 0)
+      {
+        LOG_INFO << session->name() << " tenant " << session->tenant()
+                 << " records/s " << records
+                 << " KiB/s " << bytes / 1024
+                 << " dropped " << dropped;
+      }
+    }
+    size_t queued = 0;
+    for (auto& writer : writers_)
+    {
+      queued += writer->queueSize();
+    }
+    LOG_INFO << sessions.size() << " clients, records/s " << totalRecords
+             << " MiB/s " << totalBytes / 1024 / 1024
+             << " queued batches " << queued;
+  }
+
   EventLoop* loop_;
+  // writers outlive sessions, which may be destroyed in io threads.
+  std::vector<std::unique_ptr<Writer>> writers_;
   TcpServer server_;
+  const double statsSeconds_;
+  MutexLock mutex_;
+  std::map<string, std::weak_ptr<Session>> sessions_ GUARDED_BY(mutex_);
 };
 
 }  // namespace logging
 
 int main(int argc, char* argv[])
 {
+  if (argc > 1 && argv[1][0] == '-')
+  {
+    printf("usage: %s [port [io_threads [writer_threads [dir]]]]\n", argv[0]);
+    return 0;
+  }
   EventLoop loop;
   int port = argc > 1 ? atoi(argv[1]) : 50000;
   LOG_INFO << "Listen on port " << port;
   InetAddress listenAddr(static_cast<uint16_t>(port));
   int numThreads = argc > 2 ? atoi(argv[2]) : 1;
-  logging::LogServer server(&loop, listenAddr, numThreads);
+  int numWriters = argc > 3 ? atoi(argv[3]) : 2;
+  string dir = argc > 4 ? argv[4] : "";
+  logging::LogServer server(&loop, listenAddr, numThreads, numWriters, dir, 5.0);
   server.start();
   loop.loop();
-
 }
@@ -0,0 +1,76 @@
+#include <muduo/base/BinaryLogging.h>
+
+#include <vector>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace muduo;
+
+// decodes one binary log file written by AsyncLogging in kBinary mode,
+// text goes to stdout.
+bool decode(FILE* fp, const char* name)
+{
+  BinaryLogDecoder decoder(false);
+  std::vector<char> buf(1024 * 1024);
+  size_t len = 0;
+  string text;
+  int64_t offset = 0;
+  size_t n = 0;
+  while ((n = ::fread(buf.data() + len, 1, buf.size() - len, fp)) > 0)
+  {
+    len += n;
+    size_t pos = 0;
+    int entry = 0;
+    while ((entry = decoder.decodeEntry(buf.data() + pos, len - pos, &text)) > 0)
+    {
+      pos += static_cast<size_t>(entry);
+    }
+    if (entry < 0)
+    {
+      fprintf(stderr, "%s: corrupt entry at offset %" PRId64 "\n", name, offset + static_cast<int64_t>(pos));
+      fwrite(text.data(), 1, text.size(), stdout);
+      return false;
+    }
+    fwrite(text.data(), 1, text.size(), stdout);
+    text.clear();
+    offset += static_cast<int64_t>(pos);
+    memmove(buf.data(), buf.data() + pos, len - pos);
+    len -= pos;
+    if (len == buf.size())
+    {
+      // an entry larger than the buffer
+      buf.resize(buf.size() * 2);
+    }
+  }
+  if (len > 0)
+  {
+    fprintf(stderr, "%s: truncated entry at offset %" PRId64 "\n", name, offset);
+    return false;
+  }
+  return true;
+}
+
+// usage: binarylog_decode [file ...]
+int main(int argc, char* argv[])
+{
+  bool ok = true;
+  if (argc < 2)
+  {
+    ok = decode(stdin, "stdin");
+  }
+  for (int i = 1; i < argc; ++i)
+  {
+    FILE* fp = ::fopen(argv[i], "rb");
+    if (fp == NULL)
+    {
+      perror(argv[i]);
+      ok = false;
+      continue;
+    }
+    ok = decode(fp, argv[i]) && ok;
+    ::fclose(fp);
+  }
+  return ok ? 0 : 1;
+}
@@ -2,6 +2,7 @@
 #define MUDUO_EXAMPLES_MEMCACHED_SERVER_ITEM_H
 
 #include <muduo/base/Atomic.h>
+#include <muduo/base/ObjectPool.h>
 #include <muduo/base/StringPiece.h>
 #include <muduo/base/Types.h>
 
@@ -40,7 +41,7 @@ class Item : muduo::noncopyable
                           int valuelen,
                           uint64_t casArg)
   {
-    return std::make_shared<Item>(keyArg, flagsArg, exptimeArg, valuelen, casArg);
+    return muduo::makeShared<Item>(keyArg, flagsArg, exptimeArg, valuelen, casArg);
     //return ItemPtr(new Item(keyArg, flagsArg, exptimeArg, valuelen, casArg));
   }
 
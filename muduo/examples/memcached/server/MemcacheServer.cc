@@ -2,6 +2,7 @@
 
 #include <muduo/base/Atomic.h>
 #include <muduo/base/Logging.h>
+#include <muduo/base/ShardedCounter.h>
 #include <muduo/net/EventLoop.h>
 
 using namespace muduo;
@@ -14,8 +15,25 @@ MemcacheServer::Options::Options()
   memZero(this, sizeof(*this));
 }
 
+// updated in io threads without mutex_, see Inspector /stats/counters/memcached
 struct MemcacheServer::Stats
 {
+  ShardedGauge currConnections;
+  ShardedCounter totalConnections;
+  ShardedCounter cmdGet;
+  ShardedCounter cmdSet;
+  ShardedCounter getHits;
+  ShardedCounter deleteHits;
+
+  Stats()
+    : currConnections("memcached.curr_connections"),
+      totalConnections("memcached.total_connections"),
+      cmdGet("memcached.cmd_get"),
+      cmdSet("memcached.cmd_set"),
+      getHits("memcached.get_hits"),
+      deleteHits("memcached.delete_hits")
+  {
+  }
 };
 
 MemcacheServer::MemcacheServer(muduo::net::EventLoop* loop, const Options& options)
@@ -44,6 +62,7 @@ void MemcacheServer::stop()
 bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy policy, bool* exists)
 {
   assert(item->neededBytes() == 0);
+  stats_->cmdSet.increment();
   MutexLock& mutex = shards_[item->hash() % kShards].mutex;
   ItemMap& items = shards_[item->hash() % kShards].items;
   MutexLockGuard lock(mutex);
@@ -51,7 +70,7 @@ bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy pol
   *exists = it != items.end();
   if (policy == Item::kSet)
   {
-    item->setCas(g_cas.incrementAndGet());
+    item->setCas(g_cas.incrementAndGetRelaxed());
     if (*exists)
     {
       items.erase(it);
@@ -68,7 +87,7 @@ bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy pol
       }
       else
       {
-        item->setCas(g_cas.incrementAndGet());
+        item->setCas(g_cas.incrementAndGetRelaxed());
         items.insert(item);
       }
     }
@@ -76,7 +95,7 @@ bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy pol
     {
       if (*exists)
       {
-        item->setCas(g_cas.incrementAndGet());
+        item->setCas(g_cas.incrementAndGetRelaxed());
         items.erase(it);
         items.insert(item);
       }
@@ -95,7 +114,7 @@ bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy pol
                                        oldItem->flags(),
                                        oldItem->rel_exptime(),
                                        newLen,
-                                       g_cas.incrementAndGet()));
+                                       g_cas.incrementAndGetRelaxed()));
         if (policy == Item::kAppend)
         {
           newItem->append(oldItem->value(), oldItem->valueLength() - 2);
@@ -120,7 +139,7 @@ bool MemcacheServer::storeItem(const ItemPtr& item, const Item::UpdatePolicy pol
     {
       if (*exists && (*it)->cas() == item->cas())
       {
-        item->setCas(g_cas.incrementAndGet());
+        item->setCas(g_cas.incrementAndGetRelaxed());
         items.erase(it);
         items.insert(item);
       }
@@ -141,9 +160,15 @@ ConstItemPtr MemcacheServer::getItem(const ConstItemPtr& key) const
 {
   MutexLock& mutex = shards_[key->hash() % kShards].mutex;
   const ItemMap& items = shards_[key->hash() % kShards].items;
+  stats_->cmdGet.increment();
   MutexLockGuard lock(mutex);
   ItemMap::const_iterator it = items.find(key);
-  return it != items.end() ? *it : ConstItemPtr();
+  if (it == items.end())
+  {
+    return ConstItemPtr();
+  }
+  stats_->getHits.increment();
+  return *it;
 }
 
 bool MemcacheServer::deleteItem(const ConstItemPtr& key)
@@ -151,7 +176,12 @@ bool MemcacheServer::deleteItem(const ConstItemPtr& key)
   MutexLock& mutex = shards_[key->hash() % kShards].mutex;
   ItemMap& items = shards_[key->hash() % kShards].items;
   MutexLockGuard lock(mutex);
-  return items.erase(key) == 1;
+  bool deleted = items.erase(key) == 1;
+  if (deleted)
+  {
+    stats_->deleteHits.increment();
+  }
+  return deleted;
 }
 
 void MemcacheServer::onConnection(const TcpConnectionPtr& conn)
@@ -159,6 +189,8 @@ void MemcacheServer::onConnection(const TcpConnectionPtr& conn)
   if (conn->connected())
   {
     SessionPtr session(new Session(this, conn));
+    stats_->currConnections.increment();
+    stats_->totalConnections.increment();
     MutexLockGuard lock(mutex_);
     assert(sessions_.find(conn->name()) == sessions_.end());
     sessions_[conn->name()] = session;
@@ -166,6 +198,7 @@ void MemcacheServer::onConnection(const TcpConnectionPtr& conn)
   }
   else
   {
+    stats_->currConnections.decrement();
     MutexLockGuard lock(mutex_);
     assert(sessions_.find(conn->name()) != sessions_.end());
     sessions_.erase(conn->name());
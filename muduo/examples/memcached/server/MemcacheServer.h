@@ -72,6 +72,11 @@ class MemcacheServer : muduo::noncopyable
   {
     ItemMap items;
     mutable muduo::MutexLock mutex;
+
+    MapWithLock()
+      : mutex("MemcacheServer::shard")
+    {
+    }
   };
 
   const static int kShards = 4096;
@@ -81,7 +86,7 @@ class MemcacheServer : muduo::noncopyable
   // NOT guarded by mutex_, but here because server_ has to destructs before
   // sessions_
   muduo::net::TcpServer server_;
-  std::unique_ptr<Stats> stats_ PT_GUARDED_BY(mutex_);
+  std::unique_ptr<Stats> stats_;  // sharded, no lock needed
 };
 
 #endif  // MUDUO_EXAMPLES_MEMCACHED_SERVER_MEMCACHESERVER_H
@@ -0,0 +1,31 @@
+#include <muduo/base/MappedRingLog.h>
+
+#include <stdio.h>
+
+using namespace muduo;
+
+void output(const char* line, int len)
+{
+  fwrite(line, 1, static_cast<size_t>(len), stdout);
+}
+
+// usage: ringlog_dump file ...
+// prints lines left in ring files written by MappedRingLog, oldest first.
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s file ...\n", argv[0]);
+    return 1;
+  }
+  bool ok = true;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (MappedRingLog::readFile(argv[i], output) < 0)
+    {
+      fprintf(stderr, "%s: not a ring log\n", argv[i]);
+      ok = false;
+    }
+  }
+  return ok ? 0 : 1;
+}
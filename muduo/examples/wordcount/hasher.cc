@@ -1,4 +1,5 @@
 #include <muduo/base/CountDownLatch.h>
+#include <muduo/base/FileUtil.h>
 #include <muduo/base/Logging.h>
 #include <muduo/net/EventLoopThread.h>
 #include <muduo/net/TcpClient.h>
@@ -7,9 +8,9 @@
 
 #include <examples/wordcount/hash.h>
 
-#include <fstream>
 #include <iostream>
 
+#include <ctype.h>
 #include <stdio.h>
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -180,25 +181,44 @@ WordCountSender::WordCountSender(const std::string& receivers)
   }
 }
 
+// words are separated by white spaces, as by std::istream.
+void countWords(StringPiece line, WordCountMap* wordcounts)
+{
+  const char* p = line.begin();
+  while (p < line.end())
+  {
+    while (p < line.end() && isspace(*p))
+      ++p;
+    const char* word = p;
+    while (p < line.end() && !isspace(*p))
+      ++p;
+    if (p > word)
+    {
+      (*wordcounts)[string(word, p)] += 1;
+    }
+  }
+}
+
 void WordCountSender::processFile(const char* filename)
 {
   LOG_INFO << "processFile " << filename;
   WordCountMap wordcounts;
-  // FIXME: use mmap to read file
-  std::ifstream in(filename);
-  string word;
+  // mmap-ed, lines are not copied.
+  FileUtil::RecordReader reader(filename);
+  if (reader.error())
+  {
+    LOG_ERROR << "cannot open " << filename << ": " << strerror_tl(reader.error());
+  }
+  StringPiece line;
   // FIXME: make local hash optional.
   std::hash<string> hash;
-  while (in)
+  bool more = true;
+  while (more)
   {
     wordcounts.clear();
-    while (in >> word)
+    while (wordcounts.size() <= kMaxHashSize && (more = reader.next(&line)))
     {
-      wordcounts[word] += 1;
-      if (wordcounts.size() > kMaxHashSize)
-      {
-        break;
-      }
+      countWords(line, &wordcounts);
     }
 
     LOG_INFO << "send " << wordcounts.size() << " records";
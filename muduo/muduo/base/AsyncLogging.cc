@@ -4,56 +4,403 @@
 // Author: Shuo Chen (chenshuo at chenshuo dot com)
 
 #include <muduo/base/AsyncLogging.h>
-#include <muduo/base/LogFile.h>
+#include <muduo/base/BinaryLogging.h>
 #include <muduo/base/Timestamp.h>
 
+#include <algorithm>
+
 #include <stdio.h>
+#include <string.h>
 
 using namespace muduo;
 
+namespace
+{
+
+const size_t kMaxScratch = 64 * 1024;
+
+class FileSink : public LogSink
+{
+private:
+  LogFile file_;
+
+public:
+  FileSink(const string& basename,
+           const string& storedpath,
+           off_t rollSize,
+           const LogFile::Options& options)
+    : file_(basename, storedpath, rollSize, options, false)
+  {
+  }
+
+  void append(const char* data, size_t len) override
+  {
+    file_.append(data, static_cast<int>(len));
+  }
+  void flush() override { file_.flush(); }
+  int rollCount() const override { return file_.rollCount(); }
+};
+
+}  // namespace
+
+LogSink::~LogSink() = default;
+
+/// single producer single consumer byte ring, written by its own thread and
+/// harvested by the background thread.
+struct AsyncLogging::Staging : noncopyable
+{
+  static const size_t kMask = kStagingSize - 1;
+
+  std::atomic<size_t> tail;  ///< bytes appended, producer.
+  size_t cachedHead;         ///< producer copy of head.
+  char pad0[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+  std::atomic<size_t> head;  ///< bytes harvested, background thread.
+  std::atomic<bool> abandoned;  ///< producer thread exited.
+  char pad1[64 - sizeof(std::atomic<size_t>) - sizeof(std::atomic<bool>)];
+
+  char data[kStagingSize];
+
+  Staging()
+    : tail(0),
+      cachedHead(0),
+      head(0),
+      abandoned(false)
+  {
+    static_assert((kStagingSize & kMask) == 0, "kStagingSize must be power of 2");
+  }
+
+  /// Appends header and body as a whole, or nothing.
+  bool tryAppend(const char* header, size_t headerLen, const char* body, size_t bodyLen)
+  {
+    size_t len = headerLen + bodyLen;
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (kStagingSize - (t - cachedHead) < len)
+    {
+      cachedHead = head.load(std::memory_order_acquire);
+      if (kStagingSize - (t - cachedHead) < len)
+      {
+        return false;
+      }
+    }
+    copyIn(t, header, headerLen);
+    copyIn(t + headerLen, body, bodyLen);
+    tail.store(t + len, std::memory_order_release);
+    return true;
+  }
+
+  /// Producer only.
+  bool halfFull()
+  {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - cachedHead > kStagingSize / 2)
+    {
+      cachedHead = head.load(std::memory_order_acquire);
+    }
+    return t - cachedHead > kStagingSize / 2;
+  }
+
+  void copyIn(size_t pos, const char* src, size_t len)
+  {
+    size_t begin = pos & kMask;
+    size_t first = std::min(len, kStagingSize - begin);
+    memcpy(data + begin, src, first);
+    memcpy(data, src + first, len - first);
+  }
+
+  void copyOut(size_t pos, char* dst, size_t len) const
+  {
+    size_t begin = pos & kMask;
+    size_t first = std::min(len, kStagingSize - begin);
+    memcpy(dst, data + begin, first);
+    memcpy(dst + first, data, len - first);
+  }
+};
+
 AsyncLogging::AsyncLogging(const string& basename,
                            const string& storedpath,
                            off_t rollSize,
                            int flushInterval)
-  : flushInterval_(flushInterval),
-    running_(false),
-    basename_(basename),
+  : basename_(basename),
     storedpath_(storedpath),
     rollSize_(rollSize),
+    flushInterval_(flushInterval),
+    mode_(kText),
+    fileOptions_(),
+    mutex_("AsyncLogging"),
+    cond_(mutex_),
+    wakeup_(false),
+    running_(false),
     thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"),
     latch_(1),
-    mutex_(),
-    cond_(mutex_),
     currentBuffer_(new Buffer),
     nextBuffer_(new Buffer),
-    buffers_()
+    buffers_(),
+    rollCount_(0)
 {
   currentBuffer_->bzero();
   nextBuffer_->bzero();
   buffers_.reserve(16);
+  MCHECK(pthread_key_create(&stagingKey_, &AsyncLogging::abandonStaging));
+}
+
+AsyncLogging::~AsyncLogging()
+{
+  if (running_)
+  {
+    stop();
+  }
+  // while mutex_ and buffers are alive, the sink may log on its way out,
+  // e.g. net::LogShipper, with Logger output to this.
+  sink_.reset();
+  MCHECK(pthread_key_delete(stagingKey_));
 }
 
 void AsyncLogging::append(const char* logline, int len)
+{
+  if (mode_ == kText)
+  {
+    appendEntry(NULL, 0, logline, static_cast<size_t>(len));
+  }
+  else
+  {
+    char header[BinaryLogger::kEntryHeaderSize];
+    BinaryLogger::makeEntryHeader(BinaryLogger::kTextEntry, len, header);
+    appendEntry(header, sizeof header, logline, static_cast<size_t>(len));
+  }
+}
+
+void AsyncLogging::appendBinary(const char* record, int len)
+{
+  if (mode_ == kText)
+  {
+    string line;
+    BinaryLogger::formatRecord(record, len, &line);
+    appendEntry(NULL, 0, line.data(), line.size());
+  }
+  else
+  {
+    char header[BinaryLogger::kEntryHeaderSize];
+    BinaryLogger::makeEntryHeader(BinaryLogger::kRecordEntry, len, header);
+    appendEntry(header, sizeof header, record, static_cast<size_t>(len));
+  }
+}
+
+void AsyncLogging::appendEntry(const char* header, size_t headerLen,
+                               const char* body, size_t bodyLen)
+{
+  Staging* staging = currentStaging();
+  if (staging->tryAppend(header, headerLen, body, bodyLen))
+  {
+    // wake up the background thread once per harvest, not once per line.
+    if (staging->halfFull()
+        && !wakeup_.load(std::memory_order_relaxed)
+        && !wakeup_.exchange(true))
+    {
+      muduo::MutexLockGuard lock(mutex_);
+      cond_.notify();
+    }
+  }
+  else
+  {
+    appendLocked(staging, header, headerLen, body, bodyLen);
+  }
+}
+
+AsyncLogging::Staging* AsyncLogging::currentStaging()
+{
+  Staging* staging = static_cast<Staging*>(pthread_getspecific(stagingKey_));
+  if (staging == NULL)
+  {
+    std::unique_ptr<Staging> newStaging(new Staging);
+    staging = newStaging.get();
+    {
+    muduo::MutexLockGuard lock(mutex_);
+    stagings_.push_back(std::move(newStaging));
+    }
+    MCHECK(pthread_setspecific(stagingKey_, staging));
+  }
+  return staging;
+}
+
+void AsyncLogging::abandonStaging(void* staging)
+{
+  static_cast<Staging*>(staging)->abandoned.store(true, std::memory_order_release);
+}
+
+void AsyncLogging::appendLocked(Staging* staging, const char* header, size_t headerLen,
+                                const char* body, size_t bodyLen)
 {
   muduo::MutexLockGuard lock(mutex_);
-  if (currentBuffer_->avail() > len)
+  // keeps lines of this thread in order.
+  drainLocked(staging);
+  if (implicit_cast<size_t>(currentBuffer_->avail()) <= headerLen + bodyLen)
+  {
+    nextBufferLocked();
+  }
+  if (headerLen > 0)
+  {
+    currentBuffer_->append(header, headerLen);
+  }
+  currentBuffer_->append(body, bodyLen);
+  if (!buffers_.empty())
+  {
+    cond_.notify();
+  }
+}
+
+void AsyncLogging::nextBufferLocked()
+{
+  mutex_.assertLocked();
+  buffers_.push_back(std::move(currentBuffer_));
+  if (nextBuffer_)
   {
-    currentBuffer_->append(logline, len);
+    currentBuffer_ = std::move(nextBuffer_);
   }
   else
   {
-    buffers_.push_back(std::move(currentBuffer_));
+    currentBuffer_.reset(new Buffer); // Rarely happens
+  }
+}
+
+void AsyncLogging::drainLocked(Staging* staging)
+{
+  mutex_.assertLocked();
+  size_t head = staging->head.load(std::memory_order_relaxed);
+  size_t tail = staging->tail.load(std::memory_order_acquire);
+  while (head != tail)
+  {
+    size_t len = 0;
+    if (mode_ == kText)
+    {
+      if (currentBuffer_->avail() == 0)
+      {
+        nextBufferLocked();
+      }
+      len = std::min(tail - head, static_cast<size_t>(currentBuffer_->avail()));
+    }
+    else
+    {
+      // entries never straddle buffers, so every buffer decodes alone.
+      char header[BinaryLogger::kEntryHeaderSize];
+      staging->copyOut(head, header, sizeof header);
+      uint32_t size = 0;
+      memcpy(&size, header + 1, sizeof size);
+      len = sizeof header + size;
+      if (implicit_cast<size_t>(currentBuffer_->avail()) <= len)
+      {
+        nextBufferLocked();
+      }
+    }
+    staging->copyOut(head, currentBuffer_->current(), len);
+    currentBuffer_->add(len);
+    head += len;
+  }
+  staging->head.store(head, std::memory_order_release);
+}
 
-    if (nextBuffer_)
+void AsyncLogging::harvestLocked()
+{
+  mutex_.assertLocked();
+  size_t i = 0;
+  while (i < stagings_.size())
+  {
+    Staging* staging = stagings_[i].get();
+    // read before draining, so an abandoned staging is drained for good.
+    bool abandoned = staging->abandoned.load(std::memory_order_acquire);
+    drainLocked(staging);
+    if (abandoned)
     {
-      currentBuffer_ = std::move(nextBuffer_);
+      stagings_[i] = std::move(stagings_.back());
+      stagings_.pop_back();
     }
     else
     {
-      currentBuffer_.reset(new Buffer); // Rarely happens
+      ++i;
     }
-    currentBuffer_->append(logline, len);
-    cond_.notify();
+  }
+}
+
+void AsyncLogging::writeBuffer(const char* data, size_t len, LogSink* output)
+{
+  if (mode_ == kText)
+  {
+    output->append(data, static_cast<int>(len));
+  }
+  else if (mode_ == kDeferred)
+  {
+    scratch_.clear();
+    const char* end = data + len;
+    while (data < end)
+    {
+      int n = decoder_->decodeEntry(data, static_cast<size_t>(end - data), &scratch_);
+      if (n <= 0)
+      {
+        break;
+      }
+      data += n;
+      if (scratch_.size() > kMaxScratch)
+      {
+        appendToFile(scratch_.data(), scratch_.size(), output);
+        scratch_.clear();
+      }
+    }
+    appendToFile(scratch_.data(), scratch_.size(), output);
+  }
+  else
+  {
+    writeBinary(data, len, output);
+  }
+}
+
+void AsyncLogging::writeBinary(const char* data, size_t len, LogSink* output)
+{
+  const char* run = data;
+  const char* end = data + len;
+  while (end - data >= BinaryLogger::kEntryHeaderSize)
+  {
+    uint32_t size = 0;
+    memcpy(&size, data + 1, sizeof size);
+    size_t entryLen = BinaryLogger::kEntryHeaderSize + size;
+    uint32_t id = 0;
+    if (data[0] == BinaryLogger::kRecordEntry && size >= sizeof id)
+    {
+      memcpy(&id, data + BinaryLogger::kEntryHeaderSize, sizeof id);
+      const BinaryLogSite* site = NULL;
+      if ((id >= sitesWritten_.size() || !sitesWritten_[id])
+          && (site = BinaryLogger::site(id)) != NULL)
+      {
+        appendToFile(run, static_cast<size_t>(data - run), output);
+        // site entry and its first record go to the same file.
+        scratch_.clear();
+        BinaryLogger::appendSiteEntry(*site, &scratch_);
+        scratch_.append(data, entryLen);
+        if (id >= sitesWritten_.size())
+        {
+          sitesWritten_.resize(id + 1);
+        }
+        sitesWritten_[id] = true;
+        appendToFile(scratch_.data(), scratch_.size(), output);
+        run = data + entryLen;
+      }
+    }
+    data += entryLen;
+  }
+  appendToFile(run, static_cast<size_t>(end - run), output);
+}
+
+void AsyncLogging::appendToFile(const char* data, size_t len, LogSink* output)
+{
+  if (len == 0)
+  {
+    return;
+  }
+  output->append(data, len);
+  if (output->rollCount() != rollCount_)
+  {
+    // a new file, it needs its own site entries.
+    rollCount_ = output->rollCount();
+    sitesWritten_.assign(sitesWritten_.size(), false);
   }
 }
 
@@ -61,7 +408,17 @@ void AsyncLogging::threadFunc()
 {
   assert(running_ == true);
   latch_.countDown();
-  LogFile output(basename_, storedpath_, rollSize_, false);
+  std::unique_ptr<LogSink> file;
+  if (!sink_)
+  {
+    file.reset(new FileSink(basename_, storedpath_, rollSize_, fileOptions_));
+  }
+  LogSink* output = sink_ ? sink_.get() : file.get();
+  rollCount_ = output->rollCount();
+  if (mode_ == kDeferred)
+  {
+    decoder_.reset(new BinaryLogDecoder(true));
+  }
   BufferPtr newBuffer1(new Buffer);
   BufferPtr newBuffer2(new Buffer);
   newBuffer1->bzero();
@@ -76,10 +433,12 @@ void AsyncLogging::threadFunc()
 
     {
       muduo::MutexLockGuard lock(mutex_);
-      if (buffers_.empty())  // unusual usage!
+      if (buffers_.empty() && !wakeup_)  // unusual usage!
       {
         cond_.waitForSeconds(flushInterval_);
       }
+      wakeup_ = false;
+      harvestLocked();
       buffers_.push_back(std::move(currentBuffer_));
       currentBuffer_ = std::move(newBuffer1);
       buffersToWrite.swap(buffers_);
@@ -98,14 +457,22 @@ void AsyncLogging::threadFunc()
                Timestamp::now().toFormattedString().c_str(),
                buffersToWrite.size()-2);
       fputs(buf, stderr);
-      output.append(buf, static_cast<int>(strlen(buf)));
+      scratch_.clear();
+      if (mode_ == kBinary)
+      {
+        char header[BinaryLogger::kEntryHeaderSize];
+        BinaryLogger::makeEntryHeader(BinaryLogger::kTextEntry, strlen(buf), header);
+        scratch_.append(header, sizeof header);
+      }
+      scratch_.append(buf);
+      appendToFile(scratch_.data(), scratch_.size(), output);
       buffersToWrite.erase(buffersToWrite.begin()+2, buffersToWrite.end());
     }
 
     for (const auto& buffer : buffersToWrite)
     {
       // FIXME: use unbuffered stdio FILE ? or use ::writev ?
-      output.append(buffer->data(), buffer->length());
+      writeBuffer(buffer->data(), static_cast<size_t>(buffer->length()), output);
     }
 
     if (buffersToWrite.size() > 2)
@@ -131,8 +498,21 @@ void AsyncLogging::threadFunc()
     }
 
     buffersToWrite.clear();
-    output.flush();
+    output->flush();
   }
-  output.flush();
-}
 
+  // lines appended since the last round, written out of mutex_, as the
+  // sink may log.
+  {
+    muduo::MutexLockGuard lock(mutex_);
+    harvestLocked();
+    buffers_.push_back(std::move(currentBuffer_));
+    currentBuffer_ = std::move(newBuffer1);
+    buffersToWrite.swap(buffers_);
+  }
+  for (const auto& buffer : buffersToWrite)
+  {
+    writeBuffer(buffer->data(), static_cast<size_t>(buffer->length()), output);
+  }
+  output->flush();
+}
@@ -9,6 +9,7 @@
 #include <muduo/base/BlockingQueue.h>
 #include <muduo/base/BoundedBlockingQueue.h>
 #include <muduo/base/CountDownLatch.h>
+#include <muduo/base/LogFile.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/LogStream.h>
@@ -16,25 +17,80 @@
 #include <atomic>
 #include <vector>
 
+#include <pthread.h>
+
 namespace muduo
 {
 
+class BinaryLogDecoder;
+
+/**
+ * - LogSink
+ * where the AsyncLogging thread writes, a LogFile by default.
+ * used by that thread only.
+ */
+class LogSink : noncopyable
+{
+public:
+  virtual ~LogSink();
+
+  virtual void append(const char* data, size_t len) = 0;
+  virtual void flush() = 0;
+  // changes when a new stream is started, e.g. a new file,
+  // in kBinary mode site entries are written again.
+  virtual int rollCount() const = 0;
+};
+
+/** class AsyncLogging
+ * - Brief:
+ *    log lines are written to file by a background thread.
+ *    1) every thread appends to its own staging ring, lock free, the
+ *       background thread drains all rings into the double buffers every
+ *       flushInterval_ seconds, or earlier once a ring is half full.
+ *    2) when its ring is full (or the line is larger than the ring), a thread
+ *       drains its own ring and appends to the double buffers, under mutex_.
+ *    Lines of one thread keep their order, lines of different threads are
+ *    grouped by thread within one harvest.
+ *    In kDeferred and kBinary mode every line (or binary record) is framed
+ *    as a BinaryLogger entry, kDeferred formats records in the background
+ *    thread, kBinary writes entries as is, plus site entries so that every
+ *    file can be decoded alone.
+ */
 class AsyncLogging : noncopyable
 {
+public:
+  static const size_t kStagingSize = 256 * 1024;  ///< per thread, power of 2.
+
+  enum Mode
+  {
+    kText,      ///< text lines only, appendBinary() formats at once.
+    kDeferred,  ///< binary records are formatted by background thread.
+    kBinary,    ///< binary log file, see examples/binarylog.
+  };
+
 private:
   typedef muduo::detail::FixedBuffer<muduo::detail::kLargeBuffer> Buffer;
   typedef std::vector<std::unique_ptr<Buffer>> BufferVector;
   typedef BufferVector::value_type BufferPtr;
 
+  struct Staging;
+
 private:
   const string basename_;
   const string storedpath_;
   const off_t rollSize_;
   const int flushInterval_;
     ///> every flushInterval_ seconds flush buffer to file.
+  Mode mode_;
+  LogFile::Options fileOptions_;
+  std::unique_ptr<LogSink> sink_;
+    // replaces LogFile if set.
 
+  muduo::MutexLock mutex_;
   muduo::Condition cond_ /*GUARDED_BY(mutex_)*/;
     // notify thread to write log to file.
+  std::atomic<bool> wakeup_;
+    // a staging ring is half full, set by producer before notify.
 
   std::atomic<bool> running_;
     // thread is running.
@@ -59,7 +115,17 @@ private:
   BufferVector buffers_ /*GUARDED_BY(mutex_)*/;
     // foreground vector buffers
 
-  muduo::MutexLock mutex_;
+  pthread_key_t stagingKey_;
+    // Staging of current thread, marked abandoned on thread exit.
+  std::vector<std::unique_ptr<Staging>> stagings_ /*GUARDED_BY(mutex_)*/;
+    // all staging rings, reclaimed when abandoned and drained.
+
+  ///> used by background thread only, for kDeferred and kBinary mode.
+  std::unique_ptr<BinaryLogDecoder> decoder_;
+  std::vector<bool> sitesWritten_;
+    // site entry is written to current file.
+  int rollCount_;
+  string scratch_;
 
 public:
 
@@ -67,11 +133,21 @@ public:
                const string& storedpath,
                off_t rollSize,
                int flushInterval = 3);
-  ~AsyncLogging() { if (running_) stop(); }
+  ~AsyncLogging();
+
+  /// Must be called before start().
+  void setMode(Mode mode) { mode_ = mode; }
+  /// Must be called before start(), sink of the LogFile.
+  void setFileOptions(const LogFile::Options& options) { fileOptions_ = options; }
+  /// Must be called before start(), written to instead of a LogFile,
+  /// e.g. net::LogShipper.
+  void setSink(std::unique_ptr<LogSink> sink) { sink_ = std::move(sink); }
 
   // write log to file
-  // notify thread while \m currentBuffer_ is full.
+  // notify thread while staging ring is half full or \m currentBuffer_ is full.
   void append(const char* logline, int len);
+  // record is made by BinaryLogger, see BinaryLogger::setOutput().
+  void appendBinary(const char* record, int len);
   void start()
   {
     running_ = true;
@@ -86,12 +162,28 @@ public:
   }
 
 private:
+  Staging* currentStaging();
+  void appendEntry(const char* header, size_t headerLen, const char* body, size_t bodyLen);
+  void appendLocked(Staging* staging, const char* header, size_t headerLen,
+                    const char* body, size_t bodyLen);
+  // push \m currentBuffer_ to \m buffers_, take a new one.
+  void nextBufferLocked();
+  // move bytes of staging ring to \m currentBuffer_.
+  void drainLocked(Staging* staging);
+  // drain all staging rings, reclaims abandoned ones.
+  void harvestLocked();
+  static void abandonStaging(void* staging);
+  // write content of a foreground buffer to file, by mode_.
+  void writeBuffer(const char* data, size_t len, LogSink* output);
+  void writeBinary(const char* data, size_t len, LogSink* output);
+  void appendToFile(const char* data, size_t len, LogSink* output);
+
   // write log to file
   /**
    * -
    * 1st: create LogFile object and background buffers.
    * 2st: write log to file.
-   *    1) wait for write log.
+   *    1) wait for write log, drain staging rings.
    *    2) foreground buffer to background buffer, reset foreground buffer.
    *    3) drop logs when log is large than 25.
    *    4) write logs to file (buffer).
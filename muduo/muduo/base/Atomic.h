@@ -86,6 +86,28 @@ public:
     // in gcc >= 4.7: __atomic_exchange_n(&value, newValue, __ATOMIC_SEQ_CST)
     return __sync_lock_test_and_set(&value_, newValue);
   }
+
+  // relaxed ones order nothing else, e.g. for stats and ids.
+
+  T getRelaxed()
+  {
+    return __atomic_load_n(&value_, __ATOMIC_RELAXED);
+  }
+
+  T getAndAddRelaxed(T x)
+  {
+    return __atomic_fetch_add(&value_, x, __ATOMIC_RELAXED);
+  }
+
+  T incrementAndGetRelaxed()
+  {
+    return getAndAddRelaxed(1) + 1;
+  }
+
+  void addRelaxed(T x)
+  {
+    getAndAddRelaxed(x);
+  }
 };
 }  // namespace detail
 
@@ -0,0 +1,564 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/BinaryLogging.h>
+
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Mutex.h>
+
+#include <algorithm>
+
+#include <stdio.h>
+#include <string.h>
+
+namespace muduo
+{
+
+// defined in Logging.cc
+extern Logger::OutputFunc g_output;
+extern const char* LogLevelName[Logger::NUM_LOG_LEVELS];
+
+}  // namespace muduo
+
+using namespace muduo;
+
+namespace
+{
+
+// a corrupt site entry must not make us allocate gigabytes.
+const uint32_t kMaxSiteId = 1024 * 1024;
+
+MutexLock g_sitesMutex;
+std::vector<const BinaryLogSite*> g_sites /*GUARDED_BY(g_sitesMutex)*/;
+
+void defaultBinaryOutput(const char* record, int len)
+{
+  string line;
+  BinaryLogger::formatRecord(record, len, &line);
+  g_output(line.data(), static_cast<int>(line.size()));
+}
+
+BinaryLogger::OutputFunc g_binaryOutput = defaultBinaryOutput;
+
+template<typename T>
+void get(const char** p, T* v)
+{
+  memcpy(v, *p, sizeof *v);
+  *p += sizeof *v;
+}
+
+template<typename T>
+void put(string* out, T v)
+{
+  out->append(reinterpret_cast<const char*>(&v), sizeof v);
+}
+
+// snprintf appended to out.
+template<typename T>
+void appendf(string* out, const char* fmt, T v)
+{
+  char buf[64];
+  int n = snprintf(buf, sizeof buf, fmt, v);
+  if (n < 0)
+  {
+    return;
+  }
+  if (static_cast<size_t>(n) < sizeof buf)
+  {
+    out->append(buf, static_cast<size_t>(n));
+  }
+  else
+  {
+    size_t old = out->size();
+    out->resize(old + static_cast<size_t>(n) + 1);
+    snprintf(&(*out)[old], static_cast<size_t>(n) + 1, fmt, v);
+    out->resize(old + static_cast<size_t>(n));
+  }
+}
+
+struct Arg
+{
+  BinaryLogger::ArgType type;
+  union
+  {
+    int64_t i;
+    uint64_t u;
+    double d;
+  };
+  const char* str;
+  uint32_t strLen;
+};
+
+// Returns false if record ends in the middle of an argument.
+bool getArg(const char** p, const char* end, Arg* arg)
+{
+  uint8_t type = 0;
+  get(p, &type);
+  arg->type = static_cast<BinaryLogger::ArgType>(type);
+  if (arg->type == BinaryLogger::kString)
+  {
+    if (end - *p < 4)
+    {
+      return false;
+    }
+    get(p, &arg->strLen);
+    if (static_cast<size_t>(end - *p) < arg->strLen)
+    {
+      return false;
+    }
+    arg->str = *p;
+    *p += arg->strLen;
+    return true;
+  }
+  if (end - *p < 8 || type < BinaryLogger::kInt64 || type > BinaryLogger::kTimestamp)
+  {
+    return false;
+  }
+  get(p, &arg->u);
+  return true;
+}
+
+// Formats arg as %s would, for conversions that do not fit its type.
+string naturalString(const Arg& arg)
+{
+  string str;
+  switch (arg.type)
+  {
+    case BinaryLogger::kInt64:
+      appendf(&str, "%lld", static_cast<long long>(arg.i));
+      break;
+    case BinaryLogger::kUint64:
+      appendf(&str, "%llu", static_cast<unsigned long long>(arg.u));
+      break;
+    case BinaryLogger::kDouble:
+      appendf(&str, "%.12g", arg.d);
+      break;
+    case BinaryLogger::kString:
+      str.assign(arg.str, arg.strLen);
+      break;
+    case BinaryLogger::kPointer:
+      appendf(&str, "0x%llx", static_cast<unsigned long long>(arg.u));
+      break;
+    case BinaryLogger::kTimestamp:
+      str = Timestamp(arg.i).toFormattedString();
+      break;
+  }
+  return str;
+}
+
+// spec is "%[flags][width][.precision]", without length modifier and conversion.
+void formatArg(const string& spec, char conv, const Arg& arg, string* out)
+{
+  bool isInteger = strchr("diouxXc", conv) != NULL;
+  bool isFloat = strchr("eEfFgGaA", conv) != NULL;
+  string fmt(spec);
+  if (isInteger && (arg.type == BinaryLogger::kInt64 || arg.type == BinaryLogger::kTimestamp))
+  {
+    if (conv == 'c')
+    {
+      appendf(out, (fmt += 'c').c_str(), static_cast<int>(arg.i));
+    }
+    else if (conv == 'd' || conv == 'i')
+    {
+      appendf(out, (fmt += "lld").c_str(), static_cast<long long>(arg.i));
+    }
+    else
+    {
+      appendf(out, ((fmt += "ll") += conv).c_str(), static_cast<unsigned long long>(arg.i));
+    }
+  }
+  else if (isInteger && (arg.type == BinaryLogger::kUint64 || arg.type == BinaryLogger::kPointer))
+  {
+    if (conv == 'c')
+    {
+      appendf(out, (fmt += 'c').c_str(), static_cast<int>(arg.u));
+    }
+    else
+    {
+      appendf(out, ((fmt += "ll") += (conv == 'd' || conv == 'i' ? 'u' : conv)).c_str(),
+              static_cast<unsigned long long>(arg.u));
+    }
+  }
+  else if (isInteger && arg.type == BinaryLogger::kDouble)
+  {
+    appendf(out, (fmt += "lld").c_str(), static_cast<long long>(arg.d));
+  }
+  else if (isFloat && arg.type == BinaryLogger::kDouble)
+  {
+    appendf(out, (fmt += conv).c_str(), arg.d);
+  }
+  else if (isFloat && arg.type == BinaryLogger::kInt64)
+  {
+    appendf(out, (fmt += conv).c_str(), static_cast<double>(arg.i));
+  }
+  else if (isFloat && arg.type == BinaryLogger::kUint64)
+  {
+    appendf(out, (fmt += conv).c_str(), static_cast<double>(arg.u));
+  }
+  else if (conv == 'p' && arg.type == BinaryLogger::kPointer)
+  {
+    appendf(out, (fmt += 'p').c_str(), reinterpret_cast<const void*>(static_cast<uintptr_t>(arg.u)));
+  }
+  else
+  {
+    appendf(out, (fmt += 's').c_str(), naturalString(arg).c_str());
+  }
+}
+
+}  // namespace
+
+const BinaryLogSite* BinaryLogger::registerSite(Logger::LogLevel level,
+                                                const char* file,
+                                                int line,
+                                                const char* format)
+{
+  BinaryLogSite* site = new BinaryLogSite;
+  const char* slash = strrchr(file, '/');
+  site->level = level;
+  site->line = line;
+  site->file = slash ? slash + 1 : file;
+  site->format = format;
+  MutexLockGuard lock(g_sitesMutex);
+  site->id = static_cast<uint32_t>(g_sites.size());
+  g_sites.push_back(site);
+  return site;
+}
+
+const BinaryLogSite* BinaryLogger::site(uint32_t id)
+{
+  MutexLockGuard lock(g_sitesMutex);
+  return id < g_sites.size() ? g_sites[id] : NULL;
+}
+
+void BinaryLogger::setOutput(OutputFunc out)
+{
+  g_binaryOutput = out;
+}
+
+void BinaryLogger::output(const char* record, int len)
+{
+  g_binaryOutput(record, len);
+}
+
+void BinaryLogger::makeEntryHeader(EntryKind kind, size_t len, char* header)
+{
+  uint32_t len32 = static_cast<uint32_t>(len);
+  header[0] = static_cast<char>(kind);
+  memcpy(header + 1, &len32, sizeof len32);
+}
+
+void BinaryLogger::appendSiteEntry(const BinaryLogSite& site, string* out)
+{
+  string payload;
+  put(&payload, site.id);
+  put(&payload, static_cast<uint8_t>(site.level));
+  put(&payload, static_cast<int32_t>(site.line));
+  uint16_t fileLen = static_cast<uint16_t>(std::min<size_t>(strlen(site.file), UINT16_MAX));
+  put(&payload, fileLen);
+  payload.append(site.file, fileLen);
+  uint16_t formatLen = static_cast<uint16_t>(std::min<size_t>(strlen(site.format), UINT16_MAX));
+  put(&payload, formatLen);
+  payload.append(site.format, formatLen);
+
+  char header[kEntryHeaderSize];
+  makeEntryHeader(kSiteEntry, payload.size(), header);
+  out->append(header, sizeof header);
+  out->append(payload);
+}
+
+void BinaryLogger::formatRecord(const char* record, int len, string* out)
+{
+  BinaryLogDecoder decoder(true);
+  if (!decoder.formatRecord(record, static_cast<size_t>(len), out))
+  {
+    out->append("corrupt binary log record\n");
+  }
+}
+
+detail::RecordBuilder::RecordBuilder(const BinaryLogSite* site)
+  : cur_(buf_)
+{
+  uint32_t id = site->id;
+  int64_t now = Timestamp::now().microSecondsSinceEpoch();
+  int32_t tid = CurrentThread::tid();
+  memcpy(cur_, &id, sizeof id);
+  memcpy(cur_ + 4, &now, sizeof now);
+  memcpy(cur_ + 12, &tid, sizeof tid);
+  cur_ += BinaryLogger::kRecordHeaderSize;
+}
+
+void detail::RecordBuilder::add(const void* v)
+{
+  uint64_t u = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(v));
+  addFixed(BinaryLogger::kPointer, &u, sizeof u);
+}
+
+void detail::RecordBuilder::add(Timestamp v)
+{
+  int64_t i = v.microSecondsSinceEpoch();
+  addFixed(BinaryLogger::kTimestamp, &i, sizeof i);
+}
+
+void detail::RecordBuilder::addFixed(BinaryLogger::ArgType type, const void* v, size_t len)
+{
+  // arguments that do not fit are dropped, format shows them as missing.
+  if (avail() >= 1 + len)
+  {
+    *cur_++ = static_cast<char>(type);
+    memcpy(cur_, v, len);
+    cur_ += len;
+  }
+}
+
+void detail::RecordBuilder::addString(const char* str, size_t len)
+{
+  if (avail() >= 1 + sizeof(uint32_t))
+  {
+    len = std::min(len, avail() - 1 - sizeof(uint32_t));
+    uint32_t len32 = static_cast<uint32_t>(len);
+    *cur_++ = static_cast<char>(BinaryLogger::kString);
+    memcpy(cur_, &len32, sizeof len32);
+    memcpy(cur_ + sizeof len32, str, len);
+    cur_ += sizeof len32 + len;
+  }
+}
+
+struct BinaryLogDecoder::OwnedSite
+{
+  BinaryLogSite site;
+  string file;
+  string format;
+};
+
+BinaryLogDecoder::BinaryLogDecoder(bool useRegistry)
+  : useRegistry_(useRegistry),
+    lastSecond_(0),
+    timeLength_(0)
+{
+}
+
+BinaryLogDecoder::~BinaryLogDecoder() = default;
+
+int BinaryLogDecoder::decodeEntry(const char* data, size_t len, string* out)
+{
+  if (len < BinaryLogger::kEntryHeaderSize)
+  {
+    return 0;
+  }
+  uint32_t size = 0;
+  memcpy(&size, data + 1, sizeof size);
+  if (len - BinaryLogger::kEntryHeaderSize < size)
+  {
+    return 0;
+  }
+  const char* payload = data + BinaryLogger::kEntryHeaderSize;
+  switch (data[0])
+  {
+    case BinaryLogger::kTextEntry:
+      out->append(payload, size);
+      break;
+    case BinaryLogger::kRecordEntry:
+      if (!formatRecord(payload, size, out))
+      {
+        out->append("corrupt binary log record\n");
+      }
+      break;
+    case BinaryLogger::kSiteEntry:
+      if (!addSite(payload, size))
+      {
+        return -1;
+      }
+      break;
+    default:
+      return -1;
+  }
+  return static_cast<int>(BinaryLogger::kEntryHeaderSize + size);
+}
+
+bool BinaryLogDecoder::formatRecord(const char* record, size_t len, string* out)
+{
+  if (len < BinaryLogger::kRecordHeaderSize)
+  {
+    return false;
+  }
+  const char* p = record;
+  const char* end = record + len;
+  uint32_t id = 0;
+  int64_t microSecondsSinceEpoch = 0;
+  int32_t tid = 0;
+  get(&p, &id);
+  get(&p, &microSecondsSinceEpoch);
+  get(&p, &tid);
+  const BinaryLogSite* site = findSite(id);
+  if (site == NULL || site->level < 0 || site->level >= Logger::NUM_LOG_LEVELS)
+  {
+    return false;
+  }
+
+  formatTime(microSecondsSinceEpoch, out);
+  appendf(out, "%5d ", tid);
+  out->append(LogLevelName[site->level], 6);
+
+  const char* f = site->format;
+  string spec;
+  while (*f)
+  {
+    if (*f != '%')
+    {
+      const char* percent = strchr(f, '%');
+      size_t n = percent ? static_cast<size_t>(percent - f) : strlen(f);
+      out->append(f, n);
+      f += n;
+      continue;
+    }
+    if (f[1] == '%')
+    {
+      out->push_back('%');
+      f += 2;
+      continue;
+    }
+
+    // %[flags][width][.precision][length]conversion
+    const char* start = f++;
+    f += strspn(f, "-+ #0");
+    f += strspn(f, "0123456789");
+    if (*f == '.')
+    {
+      ++f;
+      f += strspn(f, "0123456789");
+    }
+    spec.assign(start, f);
+    f += strspn(f, "hlLqjzt");
+    char conv = *f;
+    if (conv == '\0' || strchr("diouxXceEfFgGaAsp", conv) == NULL)
+    {
+      // '*' width, %n or broken spec, print as is.
+      out->append(start, conv ? f + 1 - start : f - start);
+      f += conv ? 1 : 0;
+      continue;
+    }
+    ++f;
+
+    Arg arg;
+    if (p < end && getArg(&p, end, &arg))
+    {
+      formatArg(spec, conv, arg, out);
+    }
+    else
+    {
+      p = end;
+      out->append(start, f);
+    }
+  }
+
+  // extra arguments are not lost.
+  Arg arg;
+  while (p < end && getArg(&p, end, &arg))
+  {
+    out->push_back(' ');
+    out->append(naturalString(arg));
+  }
+
+  out->append(" - ");
+  out->append(site->file);
+  out->push_back(':');
+  appendf(out, "%d", site->line);
+  out->push_back('\n');
+  return true;
+}
+
+const BinaryLogSite* BinaryLogDecoder::findSite(uint32_t id)
+{
+  if (id < sites_.size() && sites_[id])
+  {
+    return sites_[id];
+  }
+  if (!useRegistry_)
+  {
+    return NULL;
+  }
+  const BinaryLogSite* site = BinaryLogger::site(id);
+  if (site)
+  {
+    if (id >= sites_.size())
+    {
+      sites_.resize(id + 1);
+    }
+    sites_[id] = site;
+  }
+  return site;
+}
+
+bool BinaryLogDecoder::addSite(const char* payload, size_t len)
+{
+  const char* p = payload;
+  const char* end = payload + len;
+  std::unique_ptr<OwnedSite> owned(new OwnedSite);
+  uint8_t level = 0;
+  int32_t line = 0;
+  uint16_t fileLen = 0;
+  uint16_t formatLen = 0;
+  if (len < 4 + 1 + 4 + 2)
+  {
+    return false;
+  }
+  get(&p, &owned->site.id);
+  get(&p, &level);
+  get(&p, &line);
+  get(&p, &fileLen);
+  if (end - p < fileLen + 2)
+  {
+    return false;
+  }
+  owned->file.assign(p, fileLen);
+  p += fileLen;
+  get(&p, &formatLen);
+  if (end - p < formatLen)
+  {
+    return false;
+  }
+  owned->format.assign(p, formatLen);
+
+  uint32_t id = owned->site.id;
+  if (id > kMaxSiteId)
+  {
+    return false;
+  }
+  if (useRegistry_ || (id < sites_.size() && sites_[id]))
+  {
+    // every file repeats the sites it uses.
+    return true;
+  }
+  owned->site.level = static_cast<Logger::LogLevel>(level);
+  owned->site.line = line;
+  owned->site.file = owned->file.c_str();
+  owned->site.format = owned->format.c_str();
+  if (id >= sites_.size())
+  {
+    sites_.resize(id + 1);
+  }
+  sites_[id] = &owned->site;
+  ownedSites_.push_back(std::move(owned));
+  return true;
+}
+
+void BinaryLogDecoder::formatTime(int64_t microSecondsSinceEpoch, string* out)
+{
+  time_t seconds = static_cast<time_t>(microSecondsSinceEpoch / Timestamp::kMicroSecondsPerSecond);
+  int microseconds = static_cast<int>(microSecondsSinceEpoch % Timestamp::kMicroSecondsPerSecond);
+  if (seconds != lastSecond_ || timeLength_ == 0)
+  {
+    lastSecond_ = seconds;
+    struct tm tm_time;
+    ::localtime_r(&seconds, &tm_time);
+    timeLength_ = snprintf(time_, sizeof time_, "%s%s%4d%02d%02d %02d:%02d:%02d",
+                           tm_time.tm_zone ? tm_time.tm_zone : "",
+                           tm_time.tm_zone && *tm_time.tm_zone ? " " : "",
+                           tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday,
+                           tm_time.tm_hour, tm_time.tm_min, tm_time.tm_sec);
+  }
+  out->append(time_, static_cast<size_t>(timeLength_));
+  appendf(out, ".%06d ", microseconds);
+}
@@ -0,0 +1,202 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_BINARYLOGGING_H
+#define MUDUO_BASE_BINARYLOGGING_H
+
+#include <muduo/base/Logging.h>
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/base/Types.h>
+
+#include <memory>
+#include <vector>
+
+#include <stdint.h>
+#include <time.h>
+
+namespace muduo
+{
+
+/// Call site of a LOG_BIN_* statement, registered once, never freed.
+struct BinaryLogSite
+{
+  uint32_t id;
+  Logger::LogLevel level;
+  int line;
+  const char* file;    // basename of __FILE__
+  const char* format;  // printf style
+};
+
+/** class BinaryLogger
+ * - Brief:
+ *    deferred formatting: a LOG_BIN_* statement records its site id and raw
+ *    argument bytes, formatting is done later by BinaryLogDecoder, in the
+ *    AsyncLogging thread or offline.
+ *    1) record: u32 site id, i64 microseconds since epoch, i32 tid, then for
+ *       every argument a u8 ArgType and its bytes, strings are u32 length
+ *       plus bytes. Host byte order.
+ *    2) entry: u8 EntryKind, u32 length of payload, payload. AsyncLogging
+ *       frames everything in non kText modes, site entries make a binary
+ *       log file self contained.
+ *    Default output formats at once and writes text to Logger's output.
+ */
+class BinaryLogger : noncopyable
+{
+public:
+  typedef void (*OutputFunc)(const char* record, int len);
+
+  enum ArgType
+  {
+    kInt64 = 1,
+    kUint64,
+    kDouble,
+    kString,
+    kPointer,
+    kTimestamp,
+  };
+
+  enum EntryKind
+  {
+    kTextEntry = 'T',
+    kRecordEntry = 'R',
+    kSiteEntry = 'S',
+  };
+
+  static const int kMaxRecordSize = detail::kSmallBuffer;
+  static const int kRecordHeaderSize = 16;
+  static const int kEntryHeaderSize = 5;
+
+  static const BinaryLogSite* registerSite(Logger::LogLevel level,
+                                           const char* file,
+                                           int line,
+                                           const char* format);
+  /// NULL if id is not registered.
+  static const BinaryLogSite* site(uint32_t id);
+
+  static void setOutput(OutputFunc out);
+
+  template<typename... Args>
+  static void log(const BinaryLogSite* site, const Args&... args);
+
+  static void makeEntryHeader(EntryKind kind, size_t len, char* header);
+  static void appendSiteEntry(const BinaryLogSite& site, string* out);
+  /// Formats one record to a text line at once, as Logger does.
+  static void formatRecord(const char* record, int len, string* out);
+
+private:
+  static void output(const char* record, int len);
+};
+
+namespace detail
+{
+
+class RecordBuilder : noncopyable
+{
+private:
+  char buf_[BinaryLogger::kMaxRecordSize];
+  char* cur_;
+
+public:
+  explicit RecordBuilder(const BinaryLogSite* site);
+
+  void add(bool v) { addInt(v); }
+  void add(char v) { addInt(v); }
+  void add(signed char v) { addInt(v); }
+  void add(unsigned char v) { addUint(v); }
+  void add(short v) { addInt(v); }
+  void add(unsigned short v) { addUint(v); }
+  void add(int v) { addInt(v); }
+  void add(unsigned int v) { addUint(v); }
+  void add(long v) { addInt(v); }
+  void add(unsigned long v) { addUint(v); }
+  void add(long long v) { addInt(v); }
+  void add(unsigned long long v) { addUint(v); }
+  void add(float v) { addDouble(v); }
+  void add(double v) { addDouble(v); }
+  void add(const char* v) { addString(v, v ? strlen(v) : 0); }
+  void add(const string& v) { addString(v.data(), v.size()); }
+  void add(StringPiece v) { addString(v.data(), static_cast<size_t>(v.size())); }
+  void add(const void* v);
+  void add(Timestamp v);
+
+  const char* data() const { return buf_; }
+  int length() const { return static_cast<int>(cur_ - buf_); }
+
+private:
+  size_t avail() const { return static_cast<size_t>(buf_ + sizeof buf_ - cur_); }
+  void addInt(int64_t v) { addFixed(BinaryLogger::kInt64, &v, sizeof v); }
+  void addUint(uint64_t v) { addFixed(BinaryLogger::kUint64, &v, sizeof v); }
+  void addDouble(double v) { addFixed(BinaryLogger::kDouble, &v, sizeof v); }
+  void addFixed(BinaryLogger::ArgType type, const void* v, size_t len);
+  void addString(const char* str, size_t len);
+};
+
+}  // namespace detail
+
+template<typename... Args>
+void BinaryLogger::log(const BinaryLogSite* site, const Args&... args)
+{
+  detail::RecordBuilder builder(site);
+  int expand[] = { 0, (builder.add(args), 0)... };
+  (void)expand;
+  output(builder.data(), builder.length());
+}
+
+/** class BinaryLogDecoder
+ * - Brief:
+ *    formats records back to the text lines Logger would have written.
+ *    1) sites are looked up in the registry of this process, or, when
+ *       decoding a file, taken from its site entries.
+ *    2) format is applied in the backend, argument types come from the
+ *       record, so a mismatched conversion prints the value, never crashes.
+ */
+class BinaryLogDecoder : noncopyable
+{
+private:
+  struct OwnedSite;
+
+  const bool useRegistry_;
+  std::vector<const BinaryLogSite*> sites_;  ///< indexed by id, cache of registry.
+  std::vector<std::unique_ptr<OwnedSite>> ownedSites_;  ///< from site entries.
+  time_t lastSecond_;
+  char time_[64];
+  int timeLength_;
+
+public:
+  explicit BinaryLogDecoder(bool useRegistry);
+  ~BinaryLogDecoder();
+
+  /// Decodes the entry at data, text is appended to out.
+  /// Returns size of the entry, 0 if incomplete, -1 if corrupt.
+  int decodeEntry(const char* data, size_t len, string* out);
+  /// Returns false if record is corrupt or its site is unknown.
+  bool formatRecord(const char* record, size_t len, string* out);
+
+private:
+  const BinaryLogSite* findSite(uint32_t id);
+  bool addSite(const char* payload, size_t len);
+  void formatTime(int64_t microSecondsSinceEpoch, string* out);
+};
+
+}  // namespace muduo
+
+#define LOG_BIN(level, format, ...) \
+  do { \
+    if (muduo::Logger::logLevel() <= (level)) \
+    { \
+      static const muduo::BinaryLogSite* muduo_binlog_site = \
+        muduo::BinaryLogger::registerSite((level), __FILE__, __LINE__, (format)); \
+      muduo::BinaryLogger::log(muduo_binlog_site, ##__VA_ARGS__); \
+    } \
+  } while (0)
+
+#define LOG_BIN_TRACE(format, ...) LOG_BIN(muduo::Logger::TRACE, format, ##__VA_ARGS__)
+#define LOG_BIN_DEBUG(format, ...) LOG_BIN(muduo::Logger::DEBUG, format, ##__VA_ARGS__)
+#define LOG_BIN_INFO(format, ...) LOG_BIN(muduo::Logger::INFO, format, ##__VA_ARGS__)
+#define LOG_BIN_WARN(format, ...) LOG_BIN(muduo::Logger::WARN, format, ##__VA_ARGS__)
+#define LOG_BIN_ERROR(format, ...) LOG_BIN(muduo::Logger::ERROR, format, ##__VA_ARGS__)
+
+#endif  // MUDUO_BASE_BINARYLOGGING_H
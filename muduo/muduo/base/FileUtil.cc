@@ -6,15 +6,23 @@
 #include <muduo/base/FileUtil.h>
 #include <muduo/base/Logging.h> // strerror_tl
 
+#include <algorithm>
+#include <limits>
+
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 using namespace muduo;
 
+FileUtil::WritableFile::~WritableFile() = default;
+
 FileUtil::AppendFile::AppendFile(StringArg filename)
   : fp_(::fopen(filename.c_str(), "ae")),  // 'e' for O_CLOEXEC
     writtenBytes_(0)
@@ -63,6 +71,189 @@ size_t FileUtil::AppendFile::write(const char* logline, size_t len)
   return ::fwrite_unlocked(logline, 1, len, fp_);
 }
 
+namespace
+{
+
+off_t alignDown(off_t x, size_t alignment)
+{
+  return x / static_cast<off_t>(alignment) * static_cast<off_t>(alignment);
+}
+
+size_t alignUp(size_t x, size_t alignment)
+{
+  return (x + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+FileUtil::BlockAppendFile::BlockAppendFile(StringArg filename,
+                                           off_t preallocateBytes,
+                                           bool directIO,
+                                           off_t syncBytes)
+  : fd_(-1),
+    directIO_(directIO),
+    preallocateBytes_(preallocateBytes),
+    syncBytes_(syncBytes),
+    buffer_(NULL),
+    used_(0),
+    flushed_(0),
+    fileOffset_(0),
+    allocated_(0),
+    syncStart_(0),
+    syncEnd_(0),
+    writtenBytes_(0)
+{
+  int flags = O_RDWR | O_CREAT | O_CLOEXEC;
+  fd_ = ::open(filename.c_str(), flags | (directIO_ ? O_DIRECT : 0), 0644);
+  if (fd_ < 0 && directIO_)
+  {
+    // e.g. tmpfs
+    directIO_ = false;
+    fd_ = ::open(filename.c_str(), flags, 0644);
+  }
+  assert(fd_ >= 0);
+  void* buf = NULL;
+  int ret = ::posix_memalign(&buf, kAlignment, kBlockSize);
+  assert(ret == 0); (void)ret;
+  buffer_ = static_cast<char*>(buf);
+
+  // appends to an existing file, rolled twice in a second.
+  struct stat st;
+  off_t size = ::fstat(fd_, &st) == 0 ? st.st_size : 0;
+  fileOffset_ = alignDown(size, kAlignment);
+  used_ = static_cast<size_t>(size - fileOffset_);
+  if (used_ > 0 && ::pread(fd_, buffer_, kAlignment, fileOffset_) != static_cast<ssize_t>(used_))
+  {
+    fprintf(stderr, "BlockAppendFile: read tail of %s failed\n", filename.c_str());
+  }
+  flushed_ = used_;
+  allocated_ = size;
+  syncStart_ = syncEnd_ = fileOffset_;
+}
+
+FileUtil::BlockAppendFile::~BlockAppendFile()
+{
+  flush();
+  // drops padding and unused preallocated blocks.
+  if (::ftruncate(fd_, fileOffset_ + static_cast<off_t>(used_)) < 0)
+  {
+    fprintf(stderr, "BlockAppendFile: ftruncate failed %s\n", strerror_tl(errno));
+  }
+  ::close(fd_);
+  ::free(buffer_);
+}
+
+void FileUtil::BlockAppendFile::append(const char* logline, size_t len)
+{
+  writtenBytes_ += len;
+  while (len > 0)
+  {
+    size_t n = std::min(len, kBlockSize - used_);
+    memcpy(buffer_ + used_, logline, n);
+    used_ += n;
+    logline += n;
+    len -= n;
+    if (used_ == kBlockSize)
+    {
+      writeBlock();
+    }
+  }
+}
+
+void FileUtil::BlockAppendFile::flush()
+{
+  if (used_ > flushed_)
+  {
+    if (directIO_)
+    {
+      memset(buffer_ + used_, 0, alignUp(used_, kAlignment) - used_);
+    }
+    writeRange(flushed_, used_);
+    flushed_ = used_;
+  }
+}
+
+void FileUtil::BlockAppendFile::writeRange(size_t begin, size_t end)
+{
+  if (directIO_)
+  {
+    begin = begin / kAlignment * kAlignment;
+    end = alignUp(end, kAlignment);
+  }
+  while (begin < end)
+  {
+    ssize_t n = ::pwrite(fd_, buffer_ + begin, end - begin,
+                         fileOffset_ + static_cast<off_t>(begin));
+    if (n < 0 && errno == EINVAL && directIO_)
+    {
+      // O_DIRECT is refused at write time by some file systems.
+      directIO_ = false;
+      ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) & ~O_DIRECT);
+      continue;
+    }
+    if (n <= 0)
+    {
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      fprintf(stderr, "BlockAppendFile::writeRange() failed %s\n", strerror_tl(errno));
+      break;
+    }
+    begin += static_cast<size_t>(n);
+  }
+}
+
+void FileUtil::BlockAppendFile::writeBlock()
+{
+  off_t end = fileOffset_ + static_cast<off_t>(kBlockSize);
+  preallocate(end);
+  writeRange(flushed_, kBlockSize);
+  fileOffset_ = end;
+  used_ = 0;
+  flushed_ = 0;
+  paceWriteback();
+}
+
+void FileUtil::BlockAppendFile::preallocate(off_t end)
+{
+  if (preallocateBytes_ > 0 && end > allocated_)
+  {
+    off_t len = std::max(preallocateBytes_, end - allocated_);
+    // FALLOC_FL_KEEP_SIZE, readers never see the preallocated zeros.
+    if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, allocated_, len) == 0)
+    {
+      allocated_ += len;
+    }
+    else
+    {
+      // EOPNOTSUPP, do not try again.
+      allocated_ = std::numeric_limits<off_t>::max();
+    }
+  }
+}
+
+void FileUtil::BlockAppendFile::paceWriteback()
+{
+  if (syncBytes_ > 0 && fileOffset_ - syncEnd_ >= syncBytes_)
+  {
+    // waits for the range started last time, usually done by now.
+    if (syncEnd_ > syncStart_)
+    {
+      ::sync_file_range(fd_, syncStart_, syncEnd_ - syncStart_,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                        SYNC_FILE_RANGE_WAIT_AFTER);
+      if (!directIO_)
+      {
+        ::posix_fadvise(fd_, syncStart_, syncEnd_ - syncStart_, POSIX_FADV_DONTNEED);
+      }
+    }
+    ::sync_file_range(fd_, syncEnd_, fileOffset_ - syncEnd_, SYNC_FILE_RANGE_WRITE);
+    syncStart_ = syncEnd_;
+    syncEnd_ = fileOffset_;
+  }
+}
+
 FileUtil::ReadSmallFile::ReadSmallFile(StringArg filename)
   : fd_(::open(filename.c_str(), O_RDONLY | O_CLOEXEC)),
     err_(0)
@@ -169,6 +360,179 @@ int FileUtil::ReadSmallFile::readToBuffer(int* size)
   return err;
 }
 
+FileUtil::MappedFile::MappedFile(StringArg filename, int advice)
+  : err_(0),
+    data_(NULL),
+    size_(0)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    err_ = errno;
+    return;
+  }
+  struct stat statbuf;
+  if (::fstat(fd, &statbuf) != 0)
+  {
+    err_ = errno;
+  }
+  else if (!S_ISREG(statbuf.st_mode) || statbuf.st_size == 0)
+  {
+    err_ = EINVAL;
+  }
+  else
+  {
+    size_t size = static_cast<size_t>(statbuf.st_size);
+    void* p = ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED)
+    {
+      err_ = errno;
+    }
+    else
+    {
+      data_ = static_cast<char*>(p);
+      size_ = size;
+      // hints only, errors are ignored.
+      if (advice & kSequential)
+      {
+        ::madvise(data_, size_, MADV_SEQUENTIAL);
+      }
+      if (advice & kWillNeed)
+      {
+        ::madvise(data_, size_, MADV_WILLNEED);
+      }
+#ifdef MADV_HUGEPAGE
+      if (advice & kHugePages)
+      {
+        ::madvise(data_, size_, MADV_HUGEPAGE);
+      }
+#endif
+    }
+  }
+  ::close(fd);  // mapping stays
+}
+
+FileUtil::MappedFile::~MappedFile()
+{
+  if (data_)
+  {
+    ::munmap(data_, size_);
+  }
+}
+
+const size_t FileUtil::RecordReader::kChunkSize;
+
+FileUtil::RecordReader::RecordReader(StringArg filename, char delimiter, int advice)
+  : mapped_(filename, advice),
+    delimiter_(delimiter),
+    fd_(-1),
+    err_(0),
+    data_(mapped_.data()),
+    begin_(0),
+    end_(mapped_.size()),
+    offset_(0),
+    seekable_(false),
+    eof_(mapped_.valid())
+{
+  if (!mapped_.valid())
+  {
+    fd_ = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd_ < 0)
+    {
+      err_ = errno;
+      eof_ = true;
+    }
+    else if (::fstat(fd_, &st) == 0)
+    {
+      // pread(2) of a pipe fails with ESPIPE, decided once.
+      seekable_ = S_ISREG(st.st_mode);
+    }
+  }
+}
+
+FileUtil::RecordReader::~RecordReader()
+{
+  if (fd_ >= 0)
+  {
+    ::close(fd_);
+  }
+}
+
+bool FileUtil::RecordReader::next(StringPiece* record)
+{
+  size_t scanned = 0;  // after begin_, no delimiter there
+  while (true)
+  {
+    if (begin_ + scanned < end_)
+    {
+      const char* start = data_ + begin_;
+      const void* found = ::memchr(start + scanned, delimiter_, end_ - begin_ - scanned);
+      if (found)
+      {
+        size_t len = static_cast<const char*>(found) - start;
+        *record = StringPiece(start, static_cast<int>(len));
+        begin_ += len + 1;
+        return true;
+      }
+      scanned = end_ - begin_;
+    }
+    if (!fill())
+    {
+      break;
+    }
+  }
+  if (err_ == 0 && begin_ < end_)
+  {
+    // last one without delimiter.
+    *record = StringPiece(data_ + begin_, static_cast<int>(end_ - begin_));
+    begin_ = end_;
+    return true;
+  }
+  return false;
+}
+
+bool FileUtil::RecordReader::fill()
+{
+  if (eof_)
+  {
+    return false;
+  }
+  size_t unread = end_ - begin_;
+  if (begin_ > 0)
+  {
+    ::memmove(&buffer_[0], &buffer_[begin_], unread);
+    begin_ = 0;
+    end_ = unread;
+  }
+  if (buffer_.size() < end_ + kChunkSize)
+  {
+    // a long record doubles it.
+    buffer_.resize(std::max(end_ + kChunkSize, 2 * buffer_.size()));
+  }
+  data_ = &buffer_[0];
+
+  ssize_t n = 0;
+  do
+  {
+    n = seekable_ ? ::pread(fd_, &buffer_[end_], kChunkSize, offset_)
+                  : ::read(fd_, &buffer_[end_], kChunkSize);
+  } while (n < 0 && errno == EINTR);
+
+  if (n > 0)
+  {
+    end_ += static_cast<size_t>(n);
+    offset_ += n;
+    return true;
+  }
+  if (n < 0)
+  {
+    err_ = errno;
+  }
+  eof_ = true;
+  return false;
+}
+
 template int FileUtil::readFile(StringArg filename,
                                 int maxSize,
                                 string* content,
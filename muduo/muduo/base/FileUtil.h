@@ -12,6 +12,8 @@
 #include <muduo/base/StringPiece.h>
 #include <sys/types.h>  // for off_t
 
+#include <vector>
+
 namespace muduo
 {
 namespace FileUtil
@@ -70,6 +72,107 @@ int readFile(StringArg filename,
   return file.readToString(maxSize, content, fileSize, modifyTime, createTime);
 }
 
+/**
+ * - MappedFile
+ * read only mmap(2) of a whole regular file, for data loaded at startup,
+ * e.g. dictionaries and routing tables, used in place without a copy.
+ * \a advice is hints for madvise(2): kSequential doubles read ahead and
+ * drops pages behind, kWillNeed starts reading all of it at once,
+ * kHugePages asks for huge pages, taken only if the kernel can do it for
+ * files. not valid() for an empty or non regular file, or if mmap fails,
+ * RecordReader reads those too.
+ */
+class MappedFile : noncopyable
+{
+public:
+  enum Advice
+  {
+    kNormal = 0,
+    kSequential = 1,
+    kWillNeed = 2,
+    kHugePages = 4,
+  };
+
+private:
+  int err_;
+  char* data_;  // NULL if not mapped
+  size_t size_;
+
+public:
+  explicit MappedFile(StringArg filename, int advice = kSequential | kWillNeed);
+  ~MappedFile();
+
+  bool valid() const { return data_ != NULL; }
+  // errno, EINVAL for an empty or non regular file.
+  int error() const { return err_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+};
+
+/**
+ * - RecordReader
+ * yields records ended by \a delimiter, '\n' for lines, without copying:
+ *
+ *   FileUtil::RecordReader reader(filename);
+ *   StringPiece line;
+ *   while (reader.next(&line)) { ... }
+ *
+ * reads through MappedFile if it can, records point into the mapping and
+ * live as long as the reader. otherwise, e.g. /proc files, pipes or a
+ * failed mmap, reads kChunkSize at a time with pread(2), or read(2) for
+ * pipes, and a record lives till the next call.
+ * record excludes the delimiter, the last one may have none.
+ */
+class RecordReader : noncopyable
+{
+public:
+  static const size_t kChunkSize = 1024*1024;
+
+private:
+  MappedFile mapped_;
+  const char delimiter_;
+  int fd_;                    // -1 if mapped
+  int err_;
+  std::vector<char> buffer_;  // of fallback
+  const char* data_;          // mapped_.data() or buffer_
+  size_t begin_;              // of unread in data_
+  size_t end_;
+  off_t offset_;              // of file read into buffer_
+  bool seekable_;             // regular file, read by pread(2)
+  bool eof_;
+
+public:
+  explicit RecordReader(StringArg filename,
+                        char delimiter = '\n',
+                        int advice = MappedFile::kSequential | MappedFile::kWillNeed);
+  ~RecordReader();
+
+  // false at end of file or on error.
+  bool next(StringPiece* record);
+  // errno of open or read, 0 at end of file.
+  int error() const { return err_; }
+  bool mapped() const { return mapped_.valid(); }
+
+private:
+  // reads another chunk after unread, returns false at eof.
+  bool fill();
+};
+
+/**
+ * - WritableFile
+ * a file LogFile appends to, one for each roll. not thread safe.
+ */
+class WritableFile : noncopyable
+{
+public:
+  virtual ~WritableFile();
+
+  virtual void append(const char* logline, size_t len) = 0;
+  virtual void flush() = 0;
+  // bytes appended by this object.
+  virtual off_t writtenBytes() const = 0;
+};
+
 /**
  * RAII class, wirte data to file, the fd has 64KB buffer.
  * it writing operation use fwrite_unlocked().
@@ -79,7 +182,7 @@ int readFile(StringArg filename,
  * 2. class dtor.
  */
 // not thread safe
-class AppendFile : noncopyable
+class AppendFile : public WritableFile
 {
 private:
   FILE* fp_;
@@ -89,17 +192,73 @@ private:
 
 public:
   explicit AppendFile(StringArg filename);
-  ~AppendFile();
+  ~AppendFile() override;
 
-  void append(const char* logline, size_t len);
-  void flush();
-  off_t writtenBytes() const { return writtenBytes_; }
+  void append(const char* logline, size_t len) override;
+  void flush() override;
+  off_t writtenBytes() const override { return writtenBytes_; }
 
 private:
   // non blocking write to file
   size_t write(const char* logline, size_t len);
 };
 
+/**
+ * - BlockAppendFile
+ * writes whole kBlockSize blocks with pwrite(2), so a log writer does not
+ * stall on file system work:
+ *  1) preallocates \a preallocateBytes at a time with fallocate(2), blocks
+ *     are not allocated in the write path.
+ *  2) \a directIO opens with O_DIRECT, log data does not fill page cache.
+ *     falls back to buffered I/O if the file system refuses.
+ *  3) \a syncBytes paces write back with sync_file_range(2): every
+ *     syncBytes the new range is started, and the range before it waited
+ *     for and dropped from page cache. dirty pages never pile up for a
+ *     writeback storm or a long fsync.
+ *
+ * flush() writes the partial block, it is written again when full. with
+ * O_DIRECT, the file is padded with zeros to kAlignment till then, and is
+ * truncated to its length on close.
+ */
+class BlockAppendFile : public WritableFile
+{
+public:
+  static const size_t kBlockSize = 1024*1024;
+  static const size_t kAlignment = 4096;
+
+private:
+  int fd_;
+  bool directIO_;
+  const off_t preallocateBytes_;
+  const off_t syncBytes_;
+  char* buffer_;       // kBlockSize, aligned to kAlignment
+  size_t used_;        // bytes in buffer_
+  size_t flushed_;     // bytes in buffer_ already in file
+  off_t fileOffset_;   // of buffer_, aligned to kAlignment
+  off_t allocated_;    // preallocated up to
+  off_t syncStart_;    // sync_file_range started from here
+  off_t syncEnd_;      // to here
+  off_t writtenBytes_;
+
+public:
+  BlockAppendFile(StringArg filename,
+                  off_t preallocateBytes,
+                  bool directIO,
+                  off_t syncBytes);
+  ~BlockAppendFile() override;
+
+  void append(const char* logline, size_t len) override;
+  void flush() override;
+  off_t writtenBytes() const override { return writtenBytes_; }
+
+private:
+  // writes buffer_[begin, end) at its place in file.
+  void writeRange(size_t begin, size_t end);
+  void writeBlock();
+  void preallocate(off_t end);
+  void paceWriteback();
+};
+
 }  // namespace FileUtil
 }  // namespace muduo
 
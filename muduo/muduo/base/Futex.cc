@@ -0,0 +1,121 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/Futex.h>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::detail;
+
+namespace
+{
+
+long futex(std::atomic<int32_t>* word, int op, int32_t value)
+{
+  static_assert(sizeof(std::atomic<int32_t>) == sizeof(int32_t), "futex word");
+  return ::syscall(SYS_futex, reinterpret_cast<int32_t*>(word), op, value, NULL, NULL, 0);
+}
+
+bool canSpin()
+{
+  // function static, primitives may be global.
+  static bool multiCpu = ::sysconf(_SC_NPROCESSORS_ONLN) > 1;
+  return multiCpu;
+}
+
+}  // namespace
+
+bool FutexWord::spinUntil(bool (*pred)(FutexWord*))
+{
+  if (!canSpin())
+  {
+    return pred(this);
+  }
+  int32_t spin = spin_.load(std::memory_order_relaxed);
+  int32_t maxSpin = spin * 2 + 10 < kMaxSpin ? spin * 2 + 10 : kMaxSpin;
+  int32_t count = 0;
+  bool done = false;
+  while (!(done = pred(this)) && ++count < maxSpin)
+  {
+    cpuRelax();
+  }
+  // moving average, racy but only a hint.
+  spin_.store(spin + (count - spin) / 8, std::memory_order_relaxed);
+  return done;
+}
+
+void FutexWord::park(int32_t value)
+{
+  futex(&word_, FUTEX_WAIT_PRIVATE, value);
+}
+
+void FutexWord::wakeSlow(int n)
+{
+  futex(&word_, FUTEX_WAKE_PRIVATE, n);
+}
+
+void FutexEvent::wait(int32_t key)
+{
+  // spinning is for notify() soon after, so it's short and fixed.
+  if (canSpin())
+  {
+    for (int i = 0; i < 64 && word_.load(std::memory_order_acquire) == key; ++i)
+    {
+      cpuRelax();
+    }
+  }
+  if (word_.load(std::memory_order_acquire) == key)
+  {
+    park(key);
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+namespace
+{
+
+bool semaphoreReady(FutexWord* self)
+{
+  return static_cast<FutexSemaphore*>(self)->tryWait();
+}
+
+bool latchReady(FutexWord* self)
+{
+  return static_cast<FutexLatch*>(self)->getCount() <= 0;
+}
+
+}  // namespace
+
+void FutexSemaphore::waitSlow()
+{
+  if (spinUntil(semaphoreReady))
+  {
+    return;
+  }
+  waiters_.fetch_add(1, std::memory_order_seq_cst);
+  while (!tryWait())
+  {
+    park(0);
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void FutexLatch::waitSlow()
+{
+  if (spinUntil(latchReady))
+  {
+    return;
+  }
+  waiters_.fetch_add(1, std::memory_order_seq_cst);
+  int32_t count;
+  while ((count = word_.load(std::memory_order_seq_cst)) > 0)
+  {
+    park(count);
+  }
+  waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,205 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_FUTEX_H
+#define MUDUO_BASE_FUTEX_H
+
+#include <muduo/base/noncopyable.h>
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+/// in spin loops, a pause on x86.
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+/** class FutexWord
+ * - Brief:
+ *    a futex word with a count of threads parked on it, wake() is a load
+ *    and no syscall when the count is 0. waiter and waker follow Dekker:
+ *    the waiter adds to waiters_ then checks the word, the waker changes
+ *    the word then checks waiters_, both seq_cst, so at least one sees the
+ *    other.
+ *    a waiter spins a while before it parks, how long adapts to how long
+ *    it took recently, like PTHREAD_MUTEX_ADAPTIVE_NP, never on one cpu.
+ */
+class FutexWord : noncopyable
+{
+public:
+  static const int kMaxSpin = 1000;
+
+protected:
+  std::atomic<int32_t> word_;
+  std::atomic<int32_t> waiters_;
+  std::atomic<int32_t> spin_;  ///< average spins of recent waits
+
+  explicit FutexWord(int32_t value)
+    : word_(value),
+      waiters_(0),
+      spin_(0)
+  {
+  }
+
+  /// Spins until pred(this) is true, or gives up, returns pred(this).
+  bool spinUntil(bool (*pred)(FutexWord*));
+  /// Blocks while word_ == value, may return spuriously.
+  void park(int32_t value);
+  /// Wakes n of those parked, if any.
+  void wake(int n)
+  {
+    if (waiters_.load(std::memory_order_seq_cst) > 0)
+    {
+      wakeSlow(n);
+    }
+  }
+
+  void wakeSlow(int n);
+};
+
+}  // namespace detail
+
+/** class FutexEvent
+ * - Brief:
+ *    event count, a Condition without a mutex, for waiting on a predicate
+ *    of lock-free state:
+ *
+ *      int32_t key = event.prepareWait();
+ *      if (ready()) { event.cancelWait(); } else { event.wait(key); }
+ *
+ *    and after making ready() true, event.notify(), which costs a fence and
+ *    a load when nobody waits. wait(key) returns at once if notified after
+ *    prepareWait(), it may return spuriously, so check ready() in a loop.
+ */
+class FutexEvent : public detail::FutexWord
+{
+public:
+  FutexEvent()
+    : FutexWord(0)
+  {
+  }
+
+  int32_t prepareWait()
+  {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    return word_.load(std::memory_order_seq_cst);
+  }
+
+  void cancelWait()
+  {
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void wait(int32_t key);
+
+  void notify() { notifyN(1); }
+  void notifyAll() { notifyN(INT32_MAX); }
+
+private:
+  void notifyN(int n)
+  {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_relaxed) > 0)
+    {
+      word_.fetch_add(1, std::memory_order_seq_cst);
+      wakeSlow(n);
+    }
+  }
+};
+
+/** class FutexSemaphore
+ * - Brief:
+ *    counting semaphore, post() and a wait() that finds count > 0 are one
+ *    atomic operation each, no syscall unless a thread is parked.
+ */
+class FutexSemaphore : public detail::FutexWord
+{
+public:
+  explicit FutexSemaphore(int32_t count = 0)
+    : FutexWord(count)
+  {
+  }
+
+  bool tryWait()
+  {
+    int32_t count = word_.load(std::memory_order_relaxed);
+    while (count > 0)
+    {
+      if (word_.compare_exchange_weak(count, count - 1, std::memory_order_seq_cst))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void wait()
+  {
+    if (!tryWait())
+    {
+      waitSlow();
+    }
+  }
+
+  void post(int32_t n = 1)
+  {
+    word_.fetch_add(n, std::memory_order_seq_cst);
+    wake(n);
+  }
+
+  int32_t getCount() const { return word_.load(std::memory_order_relaxed); }
+
+private:
+  void waitSlow();
+};
+
+/** class FutexLatch
+ * - Brief:
+ *    CountDownLatch without mutex, countDown() is one atomic operation
+ *    unless it is the last one and a thread is parked.
+ */
+class FutexLatch : public detail::FutexWord
+{
+public:
+  explicit FutexLatch(int32_t count)
+    : FutexWord(count)
+  {
+  }
+
+  void wait()
+  {
+    if (word_.load(std::memory_order_acquire) > 0)
+    {
+      waitSlow();
+    }
+  }
+
+  void countDown()
+  {
+    if (word_.fetch_sub(1, std::memory_order_seq_cst) == 1)
+    {
+      wake(INT32_MAX);
+    }
+  }
+
+  int32_t getCount() const { return word_.load(std::memory_order_relaxed); }
+
+private:
+  void waitSlow();
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_FUTEX_H
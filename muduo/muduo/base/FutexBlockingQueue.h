@@ -0,0 +1,158 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_FUTEXBLOCKINGQUEUE_H
+#define MUDUO_BASE_FUTEXBLOCKINGQUEUE_H
+
+#include <muduo/base/Futex.h>
+#include <muduo/base/LockFreeQueue.h>
+
+namespace muduo
+{
+
+/** class FutexBlockingQueue
+ * - Brief:
+ *    blocking put()/take() over SpscQueue or MpmcQueue.
+ *    1) a blocked side spins kSpinCount times first, then sleeps on a
+ *       FutexEvent of the other side, notEmpty_ or notFull_.
+ *    2) push (pop) costs a fence and a load if nobody sleeps, otherwise it
+ *       wakes all sleepers of the other side, so a busy queue makes no
+ *       syscall at all and a sleeping side is woken once.
+ *    Queue is SpscQueue<T> or MpmcQueue<T>, the producer/consumer rules of
+ *    Queue still apply.
+ */
+template<typename Queue>
+class FutexBlockingQueue : noncopyable
+{
+public:
+  typedef typename Queue::value_type T;
+  static const int kSpinCount = 128;
+
+private:
+  Queue queue_;
+  FutexEvent notEmpty_;  ///< notified by push
+  FutexEvent notFull_;   ///< notified by pop
+
+public:
+  explicit FutexBlockingQueue(size_t capacity)
+    : queue_(capacity)
+  {
+  }
+
+  size_t size() const { return queue_.size(); }
+  size_t capacity() const { return queue_.capacity(); }
+
+  void put(T x)
+  {
+    if (!queue_.tryPush(std::move(x)))
+    {
+      waitFor(&pushOp, &x, &notFull_);
+    }
+    signal(&notEmpty_);
+  }
+
+  /// Blocks until all of n items are pushed.
+  void putBatch(T* items, size_t n)
+  {
+    while (n > 0)
+    {
+      size_t pushed = queue_.tryPushBatch(items, n);
+      if (pushed > 0)
+      {
+        signal(&notEmpty_);
+        items += pushed;
+        n -= pushed;
+      }
+      else
+      {
+        waitFor(&pushOp, items, &notFull_);
+        signal(&notEmpty_);
+        ++items;
+        --n;
+      }
+    }
+  }
+
+  T take()
+  {
+    T x;
+    if (!queue_.tryPop(&x))
+    {
+      waitFor(&popOp, &x, &notEmpty_);
+    }
+    signal(&notFull_);
+    return x;
+  }
+
+  /// Blocks until at least one item is available, returns number of items.
+  size_t takeBatch(T* out, size_t n)
+  {
+    size_t popped = queue_.tryPopBatch(out, n);
+    if (popped == 0)
+    {
+      waitFor(&popOp, out, &notEmpty_);
+      popped = 1 + queue_.tryPopBatch(out + 1, n - 1);
+    }
+    signal(&notFull_);
+    return popped;
+  }
+
+  bool tryPut(T x)
+  {
+    if (queue_.tryPush(std::move(x)))
+    {
+      signal(&notEmpty_);
+      return true;
+    }
+    return false;
+  }
+
+  bool tryTake(T* x)
+  {
+    if (queue_.tryPop(x))
+    {
+      signal(&notFull_);
+      return true;
+    }
+    return false;
+  }
+
+private:
+  static bool pushOp(Queue* queue, T* x) { return queue->tryPush(std::move(*x)); }
+  static bool popOp(Queue* queue, T* x) { return queue->tryPop(x); }
+
+  /// Retries op until it succeeds, spins first, then sleeps on event.
+  void waitFor(bool (*op)(Queue*, T*), T* x, FutexEvent* event)
+  {
+    for (int i = 0; i < kSpinCount; ++i)
+    {
+      if (op(&queue_, x))
+      {
+        return;
+      }
+      detail::cpuRelax();
+    }
+    while (true)
+    {
+      int32_t key = event->prepareWait();
+      if (op(&queue_, x))
+      {
+        event->cancelWait();
+        return;
+      }
+      event->wait(key);
+    }
+  }
+
+  static void signal(FutexEvent* event)
+  {
+    // several may wait for one batch.
+    event->notifyAll();
+  }
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_FUTEXBLOCKINGQUEUE_H
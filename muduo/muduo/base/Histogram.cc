@@ -0,0 +1,109 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/Histogram.h>
+
+#include <stdio.h>
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+
+using namespace muduo;
+
+namespace
+{
+
+int bucketOf(int64_t micros)
+{
+  int bucket = micros > 0 ? 64 - __builtin_clzll(static_cast<uint64_t>(micros)) : 0;
+  return bucket < Histogram::kNumBuckets ? bucket : Histogram::kNumBuckets - 1;
+}
+
+}  // namespace
+
+Histogram::Histogram()
+{
+  reset();
+}
+
+void Histogram::reset()
+{
+  for (std::atomic<int64_t>& bucket : buckets_)
+  {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  count_.store(0, std::memory_order_relaxed);
+  sum_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+void Histogram::add(int64_t micros)
+{
+  buckets_[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(micros, std::memory_order_relaxed);
+  int64_t old = max_.load(std::memory_order_relaxed);
+  while (micros > old
+         && !max_.compare_exchange_weak(old, micros, std::memory_order_relaxed))
+  {
+  }
+}
+
+void Histogram::merge(const Histogram& rhs)
+{
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    buckets_[i].fetch_add(rhs.buckets_[i].load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+  }
+  count_.fetch_add(rhs.count(), std::memory_order_relaxed);
+  sum_.fetch_add(rhs.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  int64_t max = rhs.max();
+  int64_t old = max_.load(std::memory_order_relaxed);
+  while (max > old
+         && !max_.compare_exchange_weak(old, max, std::memory_order_relaxed))
+  {
+  }
+}
+
+double Histogram::average() const
+{
+  int64_t n = count();
+  return n > 0 ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+}
+
+int64_t Histogram::percentile(double p) const
+{
+  int64_t n = count();
+  if (n == 0)
+  {
+    return 0;
+  }
+  int64_t threshold = static_cast<int64_t>(static_cast<double>(n) * p / 100.0);
+  int64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i)
+  {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= threshold && seen > 0)
+    {
+      int64_t upper = static_cast<int64_t>(1) << i;
+      return upper < max() ? upper : max();
+    }
+  }
+  return max();
+}
+
+string Histogram::toString() const
+{
+  char buf[256];
+  snprintf(buf, sizeof buf,
+           "count %" PRId64 " avg %.1fus p50 %" PRId64 "us p90 %" PRId64 "us"
+           " p99 %" PRId64 "us max %" PRId64 "us",
+           count(), average(), percentile(50), percentile(90),
+           percentile(99), max());
+  return buf;
+}
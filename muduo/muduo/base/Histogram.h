@@ -0,0 +1,56 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_HISTOGRAM_H
+#define MUDUO_BASE_HISTOGRAM_H
+
+#include <muduo/base/Types.h>
+#include <muduo/base/noncopyable.h>
+
+#include <atomic>
+
+#include <stdint.h>
+
+namespace muduo
+{
+
+/** class Histogram
+ * - Brief:
+ *    lock free histogram of latencies in microseconds, bucket i counts
+ *    values in [2^(i-1), 2^i), so percentiles are accurate within 2x.
+ *    add() is wait free, readers see a consistent-enough snapshot.
+ */
+class Histogram : noncopyable
+{
+public:
+  static const int kNumBuckets = 40;  ///< up to 2^39 us, about 6 days.
+
+private:
+  std::atomic<int64_t> buckets_[kNumBuckets];
+  std::atomic<int64_t> count_;
+  std::atomic<int64_t> sum_;
+  std::atomic<int64_t> max_;
+
+public:
+  Histogram();
+
+  void add(int64_t micros);
+  /// Adds all values of rhs.
+  void merge(const Histogram& rhs);
+  void reset();
+
+  int64_t count() const { return count_.load(std::memory_order_relaxed); }
+  int64_t max() const { return max_.load(std::memory_order_relaxed); }
+  double average() const;
+  /// Upper bound of bucket where @c p percent of values fall below, 0 < p <= 100.
+  int64_t percentile(double p) const;
+
+  /// e.g. "count 100 avg 12.3us p50 16us p90 32us p99 64us max 40us"
+  string toString() const;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_HISTOGRAM_H
@@ -0,0 +1,215 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_INLINEFUNCTION_H
+#define MUDUO_BASE_INLINEFUNCTION_H
+
+#include <muduo/base/noncopyable.h>
+
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+template<typename F>
+inline bool isNullCallable(const F&) { return false; }
+
+template<typename R, typename... ARGS>
+inline bool isNullCallable(R (*f)(ARGS...)) { return f == NULL; }
+
+template<typename S>
+inline bool isNullCallable(const std::function<S>& f) { return !f; }
+
+}  // namespace detail
+
+template<typename Signature, size_t kInlineSize = 64>
+class InlineFunction;
+
+/** class InlineFunction
+ * - Brief:
+ *    InlineFunction is a move-only std::function with a kInlineSize bytes
+ *    buffer, callable object which is small enough (and nothrow movable) is
+ *    constructed in the buffer, no heap allocation.
+ *    common bind shapes fit in 64 bytes, e.g.
+ *      std::bind(&TcpConnection::sendInLoop, this, string)  56 bytes
+ *      std::bind(writeCompleteCallback_, shared_from_this()) 48 bytes
+ *    bigger callable object is allocated on heap, as std::function does.
+ *    inline is about the callable only, what it holds may allocate, e.g. a
+ *    bound string beyond the small string buffer, 15 bytes in libstdc++.
+ */
+template<size_t kInlineSize, typename R, typename... ARGS>
+class InlineFunction<R (ARGS...), kInlineSize> : noncopyable
+{
+private:
+  struct Ops
+  {
+    R (*invoke)(void* storage, ARGS&&... args);
+    ///> move construct dst from src, then destroy src.
+    void (*relocate)(void* dst, void* src);
+    void (*destroy)(void* storage);
+  };
+
+  typedef typename std::aligned_storage<kInlineSize, alignof(max_align_t)>::type Storage;
+
+  template<typename F>
+  struct InlineOps
+  {
+    static R invoke(void* p, ARGS&&... args)
+    { return (*static_cast<F*>(p))(std::forward<ARGS>(args)...); }
+    static void relocate(void* dst, void* src)
+    {
+      F* f = static_cast<F*>(src);
+      new (dst) F(std::move(*f));
+      f->~F();
+    }
+    static void destroy(void* p) { static_cast<F*>(p)->~F(); }
+    static const Ops* get()
+    {
+      static const Ops ops = { &invoke, &relocate, &destroy };
+      return &ops;
+    }
+  };
+
+  template<typename F>
+  struct HeapOps
+  {
+    static F* ptr(void* p) { return *static_cast<F**>(p); }
+    static R invoke(void* p, ARGS&&... args)
+    { return (*ptr(p))(std::forward<ARGS>(args)...); }
+    static void relocate(void* dst, void* src) { new (dst) F*(ptr(src)); }
+    static void destroy(void* p) { delete ptr(p); }
+    static const Ops* get()
+    {
+      static const Ops ops = { &invoke, &relocate, &destroy };
+      return &ops;
+    }
+  };
+
+  mutable Storage storage_;
+  const Ops* ops_; ///< NULL if empty.
+
+public:
+  template<typename F>
+  struct fitsInline
+  {
+    static const bool value = sizeof(F) <= sizeof(Storage)
+                              && alignof(F) <= alignof(Storage)
+                              && std::is_nothrow_move_constructible<F>::value;
+  };
+
+  InlineFunction() noexcept
+    : ops_(NULL)
+  {
+  }
+
+  InlineFunction(std::nullptr_t) noexcept
+    : ops_(NULL)
+  {
+  }
+
+  template<typename F,
+           typename = typename std::enable_if<
+               !std::is_same<typename std::decay<F>::type, InlineFunction>::value>::type>
+  InlineFunction(F&& f)
+    : ops_(NULL)
+  {
+    typedef typename std::decay<F>::type Functor;
+    if (detail::isNullCallable(f))
+    {
+      return;
+    }
+    init(std::forward<F>(f), std::integral_constant<bool, fitsInline<Functor>::value>());
+  }
+
+  InlineFunction(InlineFunction&& rhs) noexcept
+    : ops_(rhs.ops_)
+  {
+    if (ops_)
+    {
+      ops_->relocate(&storage_, &rhs.storage_);
+      rhs.ops_ = NULL;
+    }
+  }
+
+  InlineFunction& operator=(InlineFunction&& rhs) noexcept
+  {
+    if (this != &rhs)
+    {
+      reset();
+      if (rhs.ops_)
+      {
+        rhs.ops_->relocate(&storage_, &rhs.storage_);
+        ops_ = rhs.ops_;
+        rhs.ops_ = NULL;
+      }
+    }
+    return *this;
+  }
+
+  InlineFunction& operator=(std::nullptr_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  ~InlineFunction()
+  {
+    reset();
+  }
+
+  void reset() noexcept
+  {
+    if (ops_)
+    {
+      ops_->destroy(&storage_);
+      ops_ = NULL;
+    }
+  }
+
+  void swap(InlineFunction& rhs) noexcept
+  {
+    InlineFunction tmp(std::move(rhs));
+    rhs = std::move(*this);
+    *this = std::move(tmp);
+  }
+
+  explicit operator bool() const noexcept { return ops_ != NULL; }
+
+  R operator()(ARGS... args) const
+  {
+    assert(ops_ != NULL);
+    return ops_->invoke(&storage_, std::forward<ARGS>(args)...);
+  }
+
+private:
+  template<typename F>
+  void init(F&& f, std::true_type /* inline */)
+  {
+    typedef typename std::decay<F>::type Functor;
+    new (&storage_) Functor(std::forward<F>(f));
+    ops_ = InlineOps<Functor>::get();
+  }
+
+  template<typename F>
+  void init(F&& f, std::false_type /* inline */)
+  {
+    typedef typename std::decay<F>::type Functor;
+    new (&storage_) Functor*(new Functor(std::forward<F>(f)));
+    ops_ = HeapOps<Functor>::get();
+  }
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_INLINEFUNCTION_H
@@ -0,0 +1,142 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/KeyValueLogging.h>
+
+#include <math.h>
+
+using namespace muduo;
+
+namespace
+{
+
+const char kHex[] = "0123456789abcdef";
+
+// logfmt leaves a value bare unless it is empty or has these.
+bool needsQuote(const char* str, size_t len)
+{
+  if (len == 0)
+  {
+    return true;
+  }
+  for (size_t i = 0; i < len; ++i)
+  {
+    unsigned char c = static_cast<unsigned char>(str[i]);
+    if (c <= ' ' || c == '"' || c == '=' || c == '\\' || c == 0x7f)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+void KeyValueLogger::appendKey(StringPiece key)
+{
+  if (json_)
+  {
+    stream() << ',';
+    appendEscaped(key.data(), static_cast<size_t>(key.size()));
+    stream() << ':';
+  }
+  else
+  {
+    if (!first_)
+    {
+      stream() << ' ';
+    }
+    stream() << key << '=';
+  }
+  first_ = false;
+}
+
+void KeyValueLogger::appendString(const char* str, size_t len)
+{
+  if (json_ || needsQuote(str, len))
+  {
+    appendEscaped(str, len);
+  }
+  else
+  {
+    stream().append(str, static_cast<int>(len));
+  }
+}
+
+// quoted, JSON escapes, runs of plain bytes are copied at once.
+// bytes above 0x7f are taken as UTF-8 and copied.
+void KeyValueLogger::appendEscaped(const char* str, size_t len)
+{
+  LogStream& s = stream();
+  s << '"';
+  const char* run = str;
+  const char* end = str + len;
+  for (const char* p = str; p < end; ++p)
+  {
+    unsigned char c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7f)
+    {
+      continue;
+    }
+    s.append(run, static_cast<int>(p - run));
+    run = p + 1;
+    switch (c)
+    {
+      case '"': s.append("\\\"", 2); break;
+      case '\\': s.append("\\\\", 2); break;
+      case '\n': s.append("\\n", 2); break;
+      case '\r': s.append("\\r", 2); break;
+      case '\t': s.append("\\t", 2); break;
+      default:
+      {
+        char u[6] = { '\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xf] };
+        s.append(u, sizeof u);
+      }
+    }
+  }
+  s.append(run, static_cast<int>(end - run));
+  s << '"';
+}
+
+void KeyValueLogger::appendValue(bool v)
+{
+  if (v)
+  {
+    stream().append("true", 4);
+  }
+  else
+  {
+    stream().append("false", 5);
+  }
+}
+
+void KeyValueLogger::appendValue(double v)
+{
+  if (json_ && !isfinite(v))
+  {
+    // JSON has no NaN or infinity.
+    stream().append("null", 4);
+  }
+  else
+  {
+    stream() << v;
+  }
+}
+
+void KeyValueLogger::appendValue(const char* v)
+{
+  if (v)
+  {
+    appendString(v, strlen(v));
+  }
+  else if (json_)
+  {
+    stream().append("null", 4);
+  }
+  else
+  {
+    appendString("", 0);
+  }
+}
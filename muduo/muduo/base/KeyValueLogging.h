@@ -0,0 +1,96 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_KEYVALUELOGGING_H
+#define MUDUO_BASE_KEYVALUELOGGING_H
+
+#include <muduo/base/Logging.h>
+#include <muduo/base/StringPiece.h>
+
+namespace muduo
+{
+
+/** class KeyValueLogger
+ * - Brief:
+ *    structured log line, LOG_INFO_KV("conn", conn->name())("bytes", n).
+ *    1) pairs are escaped straight into the LogStream buffer of a Logger,
+ *       no string is built, the line goes to Logger's output as usual.
+ *    2) Logger::setKeyValueFormat() picks the layout:
+ *       kLogfmt: 20180101 12:00:00.000000 1234 INFO  conn=a bytes=5 - file.cc:12
+ *       kJson:   {"time":"20180101 12:00:00.000000","tid":1234,"level":"INFO",
+ *                 "file":"file.cc","line":12,"conn":"a","bytes":5}
+ *    3) numbers and bools are written bare, anything else as a string,
+ *       logfmt quotes a string only if it must.
+ */
+class KeyValueLogger : noncopyable
+{
+private:
+  Logger logger_;
+  const bool json_;
+  bool first_;
+
+public:
+  KeyValueLogger(Logger::SourceFile file, int line, Logger::LogLevel level)
+    : logger_(file, line, level, Logger::keyValueFormat()),
+      json_(Logger::keyValueFormat() == Logger::kJson),
+      first_(true)
+  {
+  }
+
+  template<typename V>
+  KeyValueLogger& operator()(StringPiece key, const V& value)
+  {
+    appendKey(key);
+    appendValue(value);
+    return *this;
+  }
+
+private:
+  LogStream& stream() { return logger_.stream(); }
+
+  void appendKey(StringPiece key);
+  void appendString(const char* str, size_t len);
+  void appendEscaped(const char* str, size_t len);
+
+  void appendValue(bool v);
+  void appendValue(char v) { appendString(&v, 1); }
+  void appendValue(short v) { stream() << v; }
+  void appendValue(unsigned short v) { stream() << v; }
+  void appendValue(int v) { stream() << v; }
+  void appendValue(unsigned int v) { stream() << v; }
+  void appendValue(long v) { stream() << v; }
+  void appendValue(unsigned long v) { stream() << v; }
+  void appendValue(long long v) { stream() << v; }
+  void appendValue(unsigned long long v) { stream() << v; }
+  void appendValue(float v) { appendValue(static_cast<double>(v)); }
+  void appendValue(double v);
+  void appendValue(const char* v);
+  void appendValue(const string& v) { appendString(v.data(), v.size()); }
+  void appendValue(StringPiece v) { appendString(v.data(), static_cast<size_t>(v.size())); }
+
+  // anything LogStream can format, e.g. Timestamp::toString(), as a string.
+  template<typename T>
+  void appendValue(const T& v)
+  {
+    LogStream s;
+    s << v;
+    appendString(s.buffer().data(), static_cast<size_t>(s.buffer().length()));
+  }
+};
+
+}  // namespace muduo
+
+#define LOG_TRACE_KV if (MUDUO_LOG_ENABLED(TRACE)) \
+  muduo::KeyValueLogger(__FILE__, __LINE__, muduo::Logger::TRACE)
+#define LOG_DEBUG_KV if (MUDUO_LOG_ENABLED(DEBUG)) \
+  muduo::KeyValueLogger(__FILE__, __LINE__, muduo::Logger::DEBUG)
+#define LOG_INFO_KV if (MUDUO_LOG_ENABLED(INFO)) \
+  muduo::KeyValueLogger(__FILE__, __LINE__, muduo::Logger::INFO)
+#define LOG_WARN_KV if (MUDUO_LOG_ENABLED(WARN)) \
+  muduo::KeyValueLogger(__FILE__, __LINE__, muduo::Logger::WARN)
+#define LOG_ERROR_KV if (MUDUO_LOG_ENABLED(ERROR)) \
+  muduo::KeyValueLogger(__FILE__, __LINE__, muduo::Logger::ERROR)
+
+#endif  // MUDUO_BASE_KEYVALUELOGGING_H
@@ -0,0 +1,328 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_LOCKFREEQUEUE_H
+#define MUDUO_BASE_LOCKFREEQUEUE_H
+
+#include <muduo/base/noncopyable.h>
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+const size_t kCacheLineSize = 64;
+
+inline size_t roundUpToPowerOf2(size_t n)
+{
+  size_t size = 2;
+  while (size < n)
+  {
+    size *= 2;
+  }
+  return size;
+}
+
+}  // namespace detail
+
+/** class SpscQueue
+ * - Brief:
+ *    bounded single producer single consumer ring buffer, wait free.
+ *    1) tail_ is written by producer only, head_ by consumer only, they are
+ *       on different cache lines.
+ *    2) producer caches head_ and consumer caches tail_, so the other cache
+ *       line is read only when the cached one says full (or empty).
+ *    T must be default constructible and move assignable.
+ */
+template<typename T>
+class SpscQueue : noncopyable
+{
+public:
+  typedef T value_type;
+
+private:
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<T[]> items_;
+  char pad0_[detail::kCacheLineSize];
+
+  std::atomic<size_t> tail_;  ///< next slot to write, producer.
+  size_t cachedHead_;         ///< producer copy of head_.
+  char pad1_[detail::kCacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+  std::atomic<size_t> head_;  ///< next slot to read, consumer.
+  size_t cachedTail_;         ///< consumer copy of tail_.
+  char pad2_[detail::kCacheLineSize - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+public:
+  /// capacity is rounded up to power of 2.
+  explicit SpscQueue(size_t capacity)
+    : capacity_(detail::roundUpToPowerOf2(capacity)),
+      mask_(capacity_ - 1),
+      items_(new T[capacity_]),
+      tail_(0),
+      cachedHead_(0),
+      head_(0),
+      cachedTail_(0)
+  {
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  /// Approximate if called by neither producer nor consumer.
+  size_t size() const
+  {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  bool empty() const { return size() == 0; }
+
+  /// Producer only.
+  template<typename U>
+  bool tryPush(U&& x)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - cachedHead_ == capacity_)
+    {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+      if (tail - cachedHead_ == capacity_)
+      {
+        return false;
+      }
+    }
+    items_[tail & mask_] = std::forward<U>(x);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Producer only, moves from items, returns number pushed.
+  size_t tryPushBatch(T* items, size_t n)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (capacity_ - (tail - cachedHead_) < n)
+    {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+    }
+    size_t room = capacity_ - (tail - cachedHead_);
+    if (n > room)
+    {
+      n = room;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      items_[(tail + i) & mask_] = std::move(items[i]);
+    }
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  /// Consumer only.
+  bool tryPop(T* x)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == cachedTail_)
+    {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+      if (head == cachedTail_)
+      {
+        return false;
+      }
+    }
+    *x = std::move(items_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer only, returns number popped into out.
+  size_t tryPopBatch(T* out, size_t n)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (cachedTail_ - head < n)
+    {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+    }
+    size_t avail = cachedTail_ - head;
+    if (n > avail)
+    {
+      n = avail;
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      out[i] = std::move(items_[(head + i) & mask_]);
+    }
+    head_.store(head + n, std::memory_order_release);
+    return n;
+  }
+};
+
+/** class MpmcQueue
+ * - Brief:
+ *    bounded multi producer multi consumer ring buffer, lock free,
+ *    Dmitry Vyukov's algorithm: every cell has a sequence number telling
+ *    whether it is ready for the producer or the consumer of a lap.
+ *    1) one CAS on enqueuePos_ (dequeuePos_) per push (pop), or per batch.
+ *    2) enqueuePos_ and dequeuePos_ are on different cache lines.
+ *    T must be default constructible and move assignable.
+ */
+template<typename T>
+class MpmcQueue : noncopyable
+{
+public:
+  typedef T value_type;
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  char pad0_[detail::kCacheLineSize];
+
+  std::atomic<size_t> enqueuePos_;
+  char pad1_[detail::kCacheLineSize - sizeof(std::atomic<size_t>)];
+
+  std::atomic<size_t> dequeuePos_;
+  char pad2_[detail::kCacheLineSize - sizeof(std::atomic<size_t>)];
+
+public:
+  /// capacity is rounded up to power of 2.
+  explicit MpmcQueue(size_t capacity)
+    : capacity_(detail::roundUpToPowerOf2(capacity)),
+      mask_(capacity_ - 1),
+      cells_(new Cell[capacity_]),
+      enqueuePos_(0),
+      dequeuePos_(0)
+  {
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  /// Approximate.
+  size_t size() const
+  {
+    size_t enqueue = enqueuePos_.load(std::memory_order_relaxed);
+    size_t dequeue = dequeuePos_.load(std::memory_order_relaxed);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+  template<typename U>
+  bool tryPush(U&& x)
+  {
+    size_t pos = 0;
+    if (claim(&enqueuePos_, 0, 1, &pos) == 0)
+    {
+      return false;
+    }
+    Cell& cell = cells_[pos & mask_];
+    cell.data = std::forward<U>(x);
+    cell.sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Moves from items, returns number pushed.
+  size_t tryPushBatch(T* items, size_t n)
+  {
+    size_t pos = 0;
+    n = claim(&enqueuePos_, 0, n, &pos);
+    for (size_t i = 0; i < n; ++i)
+    {
+      Cell& cell = cells_[(pos + i) & mask_];
+      cell.data = std::move(items[i]);
+      cell.sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    return n;
+  }
+
+  bool tryPop(T* x)
+  {
+    size_t pos = 0;
+    if (claim(&dequeuePos_, 1, 1, &pos) == 0)
+    {
+      return false;
+    }
+    Cell& cell = cells_[pos & mask_];
+    *x = std::move(cell.data);
+    cell.sequence.store(pos + capacity_, std::memory_order_release);
+    return true;
+  }
+
+  /// Returns number popped into out.
+  size_t tryPopBatch(T* out, size_t n)
+  {
+    size_t pos = 0;
+    n = claim(&dequeuePos_, 1, n, &pos);
+    for (size_t i = 0; i < n; ++i)
+    {
+      Cell& cell = cells_[(pos + i) & mask_];
+      out[i] = std::move(cell.data);
+      cell.sequence.store(pos + i + capacity_, std::memory_order_release);
+    }
+    return n;
+  }
+
+private:
+  /// Claims up to n consecutive cells from *position, a cell at pos is
+  /// ready when its sequence is pos + lag (0 for producer, 1 for consumer).
+  /// Returns number of cells claimed, the first one is *first.
+  size_t claim(std::atomic<size_t>* position, size_t lag, size_t n, size_t* first)
+  {
+    size_t pos = position->load(std::memory_order_relaxed);
+    while (true)
+    {
+      size_t ready = 0;
+      while (ready < n)
+      {
+        size_t seq = cells_[(pos + ready) & mask_].sequence.load(std::memory_order_acquire);
+        if (seq != pos + ready + lag)
+        {
+          break;
+        }
+        ++ready;
+      }
+
+      if (ready == 0)
+      {
+        size_t seq = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+        // cell of previous lap not consumed (produced) yet, full (empty).
+        if (static_cast<ptrdiff_t>(seq - (pos + lag)) < 0)
+        {
+          return 0;
+        }
+        // others claimed it, retry from new position.
+        pos = position->load(std::memory_order_relaxed);
+        continue;
+      }
+
+      if (position->compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed))
+      {
+        *first = pos;
+        return ready;
+      }
+      // pos is reloaded by compare_exchange_weak
+    }
+  }
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_LOCKFREEQUEUE_H
@@ -0,0 +1,269 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <muduo/base/LockProfiler.h>
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace muduo;
+
+namespace
+{
+
+int64_t nowNanos()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+struct Registry
+{
+  MutexLock mutex;  // not named, of course
+  std::multimap<string, LockStats*> locks GUARDED_BY(mutex);  // alive
+  // of locks destroyed, also every name ever seen.
+  std::map<string, std::unique_ptr<LockStats>> retired GUARDED_BY(mutex);
+};
+
+// never destroyed, named locks may be used during exit.
+Registry& registry()
+{
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+// "avg 12.3ns p50 16ns p99 64ns max 40ns"
+string formatNanos(const Histogram& h)
+{
+  char buf[128];
+  snprintf(buf, sizeof buf, "avg %.1fns p50 %" PRId64 "ns p99 %" PRId64 "ns max %" PRId64 "ns",
+           h.average(), h.percentile(50), h.percentile(99), h.max());
+  return buf;
+}
+
+}  // namespace
+
+std::atomic<bool> LockProfiler::enabled_(::getenv("MUDUO_LOCK_PROFILING") != NULL);
+
+MutexLock::MutexLock(const char* name)
+  : holder_(0),
+    stats_(LockProfiler::registerLock(name)),
+    lockedAt_(0)
+{
+  MCHECK(pthread_mutex_init(&mutex_, NULL));
+}
+
+void MutexLock::lockProfiled()
+{
+  if (!LockProfiler::enabled())
+  {
+    MCHECK(pthread_mutex_lock(&mutex_));
+    return;
+  }
+  int64_t n = stats_->acquisitions_.fetch_add(1, std::memory_order_relaxed);
+  int ret = pthread_mutex_trylock(&mutex_);
+  if (ret == EBUSY)
+  {
+    int64_t start = nowNanos();
+    MCHECK(pthread_mutex_lock(&mutex_));
+    lockedAt_ = nowNanos();
+    stats_->contended_.fetch_add(1, std::memory_order_relaxed);
+    stats_->waitTime_.add(lockedAt_ - start);
+  }
+  else
+  {
+    MCHECK(ret);
+    if (n % LockProfiler::kHoldSampling == 0)
+    {
+      lockedAt_ = nowNanos();
+    }
+  }
+}
+
+// also before Condition::wait(), which releases the lock.
+void MutexLock::endHold()
+{
+  stats_->holdTime_.add(nowNanos() - lockedAt_);
+  lockedAt_ = 0;
+}
+
+void MutexLock::releaseStats()
+{
+  LockProfiler::unregisterLock(stats_);
+  stats_ = NULL;
+}
+
+LockStats::LockStats(const string& name)
+  : name_(name),
+    acquisitions_(0),
+    contended_(0)
+{
+}
+
+double LockStats::totalWait() const
+{
+  return waitTime_.average() * static_cast<double>(waitTime_.count());
+}
+
+void LockStats::merge(const LockStats& rhs)
+{
+  acquisitions_.fetch_add(rhs.acquisitions(), std::memory_order_relaxed);
+  contended_.fetch_add(rhs.contended(), std::memory_order_relaxed);
+  waitTime_.merge(rhs.waitTime_);
+  holdTime_.merge(rhs.holdTime_);
+}
+
+void LockStats::reset()
+{
+  acquisitions_.store(0, std::memory_order_relaxed);
+  contended_.store(0, std::memory_order_relaxed);
+  waitTime_.reset();
+  holdTime_.reset();
+}
+
+string LockStats::toString() const
+{
+  int64_t n = acquisitions();
+  int64_t c = contended();
+  char buf[128];
+  snprintf(buf, sizeof buf, "%s acquisitions %" PRId64 " contended %" PRId64 " (%.1f%%) total wait %.3fms",
+           name_.c_str(), n, c, n > 0 ? 100.0 * static_cast<double>(c) / static_cast<double>(n) : 0.0,
+           totalWait() / 1e6);
+  string result(buf);
+  result += "\n  wait ";
+  result += formatNanos(waitTime_);
+  result += "\n  hold ";
+  result += formatNanos(holdTime_);
+  return result;
+}
+
+void LockProfiler::setEnabled(bool on)
+{
+  enabled_.store(on, std::memory_order_relaxed);
+}
+
+LockStats* LockProfiler::registerLock(const char* name)
+{
+  LockStats* stats = new LockStats(name);
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  std::unique_ptr<LockStats>& retired = r.retired[stats->name()];
+  if (!retired)
+  {
+    retired.reset(new LockStats(stats->name()));
+  }
+  r.locks.insert(std::make_pair(stats->name(), stats));
+  return stats;
+}
+
+void LockProfiler::unregisterLock(LockStats* stats)
+{
+  Registry& r = registry();
+  {
+  MutexLockGuard lock(r.mutex);
+  auto range = r.locks.equal_range(stats->name());
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (it->second == stats)
+    {
+      r.locks.erase(it);
+      break;
+    }
+  }
+  r.retired[stats->name()]->merge(*stats);
+  }
+  delete stats;
+}
+
+namespace
+{
+
+std::unique_ptr<LockStats> sumOf(Registry& r, const string& name, const LockStats& retired)
+  REQUIRES(r.mutex)
+{
+  std::unique_ptr<LockStats> sum(new LockStats(name));
+  sum->merge(retired);
+  auto range = r.locks.equal_range(name);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    sum->merge(*it->second);
+  }
+  return sum;
+}
+
+}  // namespace
+
+std::unique_ptr<LockStats> LockProfiler::stats(const string& name)
+{
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  auto it = r.retired.find(name);
+  if (it == r.retired.end())
+  {
+    return std::unique_ptr<LockStats>();
+  }
+  return sumOf(r, name, *it->second);
+}
+
+std::vector<std::unique_ptr<LockStats>> LockProfiler::allStats()
+{
+  std::vector<std::unique_ptr<LockStats>> result;
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  for (const auto& it : r.retired)
+  {
+    result.push_back(sumOf(r, it.first, *it.second));
+  }
+  return result;
+}
+
+void LockProfiler::reset()
+{
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  for (auto& it : r.retired)
+  {
+    it.second->reset();
+  }
+  for (auto& it : r.locks)
+  {
+    it.second->reset();
+  }
+}
+
+namespace
+{
+
+bool moreWait(const std::unique_ptr<LockStats>& lhs, const std::unique_ptr<LockStats>& rhs)
+{
+  return lhs->totalWait() > rhs->totalWait();
+}
+
+}  // namespace
+
+string LockProfiler::report()
+{
+  std::vector<std::unique_ptr<LockStats>> stats = allStats();
+  std::sort(stats.begin(), stats.end(), moreWait);
+  string result(enabled() ? "lock profiling enabled\n" : "lock profiling disabled\n");
+  for (const auto& s : stats)
+  {
+    result += s->toString();
+    result += "\n";
+  }
+  return result;
+}
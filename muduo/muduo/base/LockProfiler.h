@@ -0,0 +1,93 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_LOCKPROFILER_H
+#define MUDUO_BASE_LOCKPROFILER_H
+
+#include <muduo/base/Histogram.h>
+#include <muduo/base/Mutex.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace muduo
+{
+
+/** class LockStats
+ * - Brief:
+ *    contention of one named MutexLock, or the sum of all locks of a name,
+ *    times are nanoseconds. an acquisition is contended when pthread_mutex_trylock() fails, only
+ *    those are timed for waitTime. holdTime is sampled, every contended
+ *    acquisition and one in LockProfiler::kHoldSampling of others.
+ */
+class LockStats : noncopyable
+{
+  friend class MutexLock;
+
+private:
+  const string name_;
+  std::atomic<int64_t> acquisitions_;
+  std::atomic<int64_t> contended_;
+  Histogram waitTime_;
+  Histogram holdTime_;
+
+public:
+  explicit LockStats(const string& name);
+
+  const string& name() const { return name_; }
+  int64_t acquisitions() const { return acquisitions_.load(std::memory_order_relaxed); }
+  int64_t contended() const { return contended_.load(std::memory_order_relaxed); }
+  const Histogram& waitTime() const { return waitTime_; }
+  const Histogram& holdTime() const { return holdTime_; }
+  /// total time waited, in nanoseconds.
+  double totalWait() const;
+
+  /// Adds counts of rhs, of the same name.
+  void merge(const LockStats& rhs);
+  void reset();
+  /// e.g. "EventLoop acquisitions 100 contended 10 (10.0%) wait ... hold ..."
+  string toString() const;
+};
+
+/** class LockProfiler
+ * - Brief:
+ *    opt-in contention profiling of MutexLock, only locks constructed with
+ *    a name are profiled, and only while enabled. unnamed locks cost one
+ *    branch, named ones an atomic load when disabled, a trylock and an
+ *    atomic increment when enabled, clock_gettime() when contended or
+ *    sampled. enabled at start if MUDUO_LOCK_PROFILING is set in env.
+ *    every named lock counts in a LockStats of its own, so locks of one
+ *    name, e.g. EventLoop of every io thread, don't bounce a cache line
+ *    between cores, they are summed by name when read. a lock merges its
+ *    counts into those of its name when destroyed.
+ */
+class LockProfiler : noncopyable
+{
+public:
+  static const int kHoldSampling = 16;
+
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+  static void setEnabled(bool on);
+
+  /// Sum of locks of name, a snapshot, NULL if no lock of name ever existed.
+  static std::unique_ptr<LockStats> stats(const string& name);
+  /// Sum of every name, a snapshot.
+  static std::vector<std::unique_ptr<LockStats>> allStats();
+  static void reset();
+  /// One line per name, most total wait first.
+  static string report();
+
+private:
+  friend class MutexLock;
+  static LockStats* registerLock(const char* name);
+  static void unregisterLock(LockStats* stats);
+
+  static std::atomic<bool> enabled_;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_LOCKPROFILER_H
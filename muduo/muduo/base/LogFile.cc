@@ -5,18 +5,130 @@
 
 #include <muduo/base/LogFile.h>
 
+#include <muduo/base/BlockingQueue.h>
+#include <muduo/base/CurrentThread.h>
 #include <muduo/base/FileUtil.h>
 #include <muduo/base/ProcessInfo.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#ifdef MUDUO_HAVE_ZLIB
+#include <muduo/base/GzipFile.h>
+#endif
 
 #include <assert.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/resource.h>
 #include <time.h>
+#include <unistd.h>
 
 using namespace muduo;
 
+namespace
+{
+
+// file.gz, then removes file, a failed one is left as is.
+void compressFile(const string& filename)
+{
+#ifdef MUDUO_HAVE_ZLIB
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return;
+  }
+  string gzname = filename + ".gz";
+  bool ok = false;
+  bool created = false;
+  {
+  GzipFile gz = GzipFile::openForWriteExclusive(gzname);
+  if (gz.valid())
+  {
+    created = true;
+    char buf[64*1024];
+    ssize_t n = 0;
+    ok = true;
+    while (ok && (n = ::read(fd, buf, sizeof buf)) > 0)
+    {
+      ok = gz.write(StringPiece(buf, static_cast<int>(n))) == n;
+    }
+    ok = ok && n == 0;
+  }
+  }
+  ::close(fd);
+  if (ok)
+  {
+    ::unlink(filename.c_str());
+  }
+  else
+  {
+    fprintf(stderr, "LogFile: failed to compress %s\n", filename.c_str());
+    if (created)
+    {
+      // not one there before, e.g. of another process.
+      ::unlink(gzname.c_str());
+    }
+  }
+#else
+  (void)filename;
+#endif
+}
+
+}  // namespace
+
+/// compresses rolled files one by one, off the logging thread.
+class LogFile::Compressor : noncopyable
+{
+private:
+  BlockingQueue<string> queue_;
+  Thread thread_;
+
+public:
+  Compressor()
+    : thread_(std::bind(&Compressor::threadFunc, this), "LogCompressor")
+  {
+    thread_.start();
+  }
+
+  ~Compressor()
+  {
+    queue_.put(string());  // finishes files queued before
+    thread_.join();
+  }
+
+  void compress(const string& filename)
+  {
+    queue_.put(filename);
+  }
+
+private:
+  void threadFunc()
+  {
+    // behind the threads doing real work.
+    ::setpriority(PRIO_PROCESS, CurrentThread::tid(), 10);
+    string filename;
+    while (!(filename = queue_.take()).empty())
+    {
+      compressFile(filename);
+    }
+  }
+};
+
+LogFile::LogFile(const string& basename,
+                 const string& storedpath,
+                 off_t rollSize,
+                 bool threadSafe,
+                 int flushInterval,
+                 int checkEveryN)
+  : LogFile(basename, storedpath, rollSize, Options(),
+            threadSafe, flushInterval, checkEveryN)
+{
+}
+
 LogFile::LogFile(const string& basename,
                  const string& storedpath,
                  off_t rollSize,
+                 const Options& options,
                  bool threadSafe,
                  int flushInterval,
                  int checkEveryN)
@@ -25,13 +137,23 @@ LogFile::LogFile(const string& basename,
     rollSize_(rollSize),
     flushInterval_(flushInterval),
     checkEveryN_(checkEveryN),
+    options_(options),
     count_(0),
     mutex_(threadSafe ? new MutexLock : NULL),
     startOfPeriod_(0),
     lastRoll_(0),
-    lastFlush_(0)
+    lastFlush_(0),
+    rollCount_(0)
 {
   assert(basename.find('/') == string::npos);
+  if (options_.compress)
+  {
+#ifdef MUDUO_HAVE_ZLIB
+    compressor_.reset(new Compressor);
+#else
+    fprintf(stderr, "LogFile: built without zlib, rolled files are not compressed\n");
+#endif
+  }
   rollFile();
 }
 
@@ -55,7 +177,21 @@ void LogFile::flush()
   if (mutex_)
   {
     MutexLockGuard lock(*mutex_);
+    flush_unlocked();
+  }
+  else
+  {
+    flush_unlocked();
+  }
+}
+
+void LogFile::flush_unlocked()
+{
+  if (options_.latency)
+  {
+    Timestamp start(Timestamp::now());
     file_->flush();
+    flushLatency_.add(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch());
   }
   else
   {
@@ -65,7 +201,16 @@ void LogFile::flush()
 
 void LogFile::append_unlocked(const char* logline, int len)
 {
-  file_->append(logline, len);
+  if (options_.latency)
+  {
+    Timestamp start(Timestamp::now());
+    file_->append(logline, len);
+    writeLatency_.add(Timestamp::now().microSecondsSinceEpoch() - start.microSecondsSinceEpoch());
+  }
+  else
+  {
+    file_->append(logline, len);
+  }
 
   if (file_->writtenBytes() > rollSize_)
   {
@@ -86,7 +231,7 @@ void LogFile::append_unlocked(const char* logline, int len)
       else if (now - lastFlush_ > flushInterval_)
       {
         lastFlush_ = now;
-        file_->flush();
+        flush_unlocked();
       }
     }
   }
@@ -112,7 +257,29 @@ bool LogFile::rollFile()
     lastRoll_ = now;
     lastFlush_ = now;
     startOfPeriod_ = start;
-    file_.reset(new FileUtil::AppendFile(fullfilename));
+    Timestamp begin(options_.latency ? Timestamp::now() : Timestamp());
+    file_.reset();  // closed before compressed
+    if (options_.blockWrite)
+    {
+      file_.reset(new FileUtil::BlockAppendFile(fullfilename,
+                                                options_.preallocate,
+                                                options_.directIO,
+                                                options_.syncBytes));
+    }
+    else
+    {
+      file_.reset(new FileUtil::AppendFile(fullfilename));
+    }
+    if (options_.latency)
+    {
+      flushLatency_.add(Timestamp::now().microSecondsSinceEpoch() - begin.microSecondsSinceEpoch());
+    }
+    if (compressor_ && !filename_.empty() && filename_ != fullfilename)
+    {
+      compressor_->compress(filename_);
+    }
+    filename_ = fullfilename;
+    ++rollCount_;
     return true;
   }
   return false;
@@ -6,6 +6,7 @@
 #ifndef MUDUO_BASE_LOGFILE_H
 #define MUDUO_BASE_LOGFILE_H
 
+#include <muduo/base/Histogram.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Types.h>
 
@@ -16,7 +17,7 @@ namespace muduo
 
 namespace FileUtil
 {
-class AppendFile;
+class WritableFile;
 }
 
 /**
@@ -31,6 +32,28 @@ class AppendFile;
  */
 class LogFile : noncopyable
 {
+public:
+  /// How files are written, default is a stdio FileUtil::AppendFile.
+  struct Options
+  {
+    bool blockWrite;      ///< FileUtil::BlockAppendFile, for options below.
+    off_t preallocate;    ///< fallocate this much at a time, 0 for none.
+    bool directIO;        ///< O_DIRECT.
+    off_t syncBytes;      ///< sync_file_range pacing, 0 for none.
+    bool compress;        ///< gzip rolled files in background, needs zlib.
+    bool latency;         ///< writeLatency(), flushLatency(), 2 clock reads per append.
+
+    Options()
+      : blockWrite(false),
+        preallocate(64*1024*1024),
+        directIO(false),
+        syncBytes(8*1024*1024),
+        compress(false),
+        latency(false)
+    {
+    }
+  };
+
 private:
   const static int kRollPerSeconds_ = 60*60*24;
     // how mush time use a new file, one day.
@@ -43,13 +66,21 @@ private:
   const int flushInterval_; // flush interval.
   const int checkEveryN_;
     // to flush or roll when written time is greate than it.
+  const Options options_;
   int count_; // count of current roll file written time.
 
   std::unique_ptr<MutexLock> mutex_;
   time_t startOfPeriod_; // period of roll file, here is one day.
   time_t lastRoll_;
   time_t lastFlush_; // last flush of current roll file
-  std::unique_ptr<FileUtil::AppendFile> file_;
+  int rollCount_; // number of files opened.
+  string filename_; // of file_
+  std::unique_ptr<FileUtil::WritableFile> file_;
+
+  class Compressor;
+  std::unique_ptr<Compressor> compressor_; // of rolled files
+  Histogram writeLatency_; // of append, in microseconds, if options_.latency
+  Histogram flushLatency_; // of flush and roll, if options_.latency
 
 public:
   LogFile(const string& basename,
@@ -58,6 +89,13 @@ public:
           bool threadSafe = true,
           int flushInterval = 3,
           int checkEveryN = 1024);
+  LogFile(const string& basename,
+          const string& storedpath,
+          off_t rollSize,
+          const Options& options,
+          bool threadSafe = true,
+          int flushInterval = 3,
+          int checkEveryN = 1024);
   ~LogFile();
 
   void append(const char* logline, int len);
@@ -68,6 +106,9 @@ public:
    * we can set specified path in the invokation, but must add a member for path.
    */
   bool rollFile();
+  int rollCount() const { return rollCount_; }
+  const Histogram& writeLatency() const { return writeLatency_; }
+  const Histogram& flushLatency() const { return flushLatency_; }
 
 private:
   /**
@@ -77,6 +118,7 @@ private:
    *  2) flush when over \m flushInterval_ seconds.
    */
   void append_unlocked(const char* logline, int len);
+  void flush_unlocked();
   // get a log file name: processName.20181224-122022.hostName.pid.log
   static string getLogFileName(const string& basename, time_t* now);
 
@@ -6,6 +6,7 @@
 #include <muduo/base/LogStream.h>
 
 #include <algorithm>
+#include <cmath>
 #include <limits>
 #include <type_traits>
 #include <assert.h>
@@ -16,7 +17,6 @@
 using namespace muduo;
 using namespace muduo::detail;
 
-// TODO: better itoa.
 #if defined(__clang__)
 #pragma clang diagnostic ignored "-Wtautological-compare"
 #else
@@ -28,53 +28,458 @@ namespace muduo
 namespace detail
 {
 
-const char digits[] = "9876543210123456789";
-const char* zero = digits + 9;
-static_assert(sizeof(digits) == 20, "wrong number of digits");
-
 const char digitsHex[] = "0123456789ABCDEF";
 static_assert(sizeof digitsHex == 17, "wrong number of digitsHex");
 
-// Efficient Integer to String Conversions, by Matthew Wilson.
+// "00" "01" ... "99"
+const char digits2[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+static_assert(sizeof digits2 == 201, "wrong number of digits2");
+
+// two digits at a time, from the right end of a scratch buffer.
 template<typename T>
 size_t convert(char buf[], T value)
 {
-  T i = value;
-  char* p = buf;
-
-  do
+  typedef typename std::make_unsigned<T>::type U;
+  // -value overflows for the min value, but not in unsigned.
+  U i = value < 0 ? static_cast<U>(0 - static_cast<U>(value)) : static_cast<U>(value);
+  char scratch[32];
+  char* end = scratch + sizeof scratch;
+  char* p = end;
+
+  while (i >= 100)
+  {
+    size_t index = static_cast<size_t>(i % 100) * 2;
+    i /= 100;
+    p -= 2;
+    memcpy(p, digits2 + index, 2);
+  }
+  if (i < 10)
+  {
+    *--p = static_cast<char>('0' + i);
+  }
+  else
   {
-    int lsd = static_cast<int>(i % 10);
-    i /= 10;
-    *p++ = zero[lsd];
-  } while (i != 0);
+    p -= 2;
+    memcpy(p, digits2 + static_cast<size_t>(i) * 2, 2);
+  }
 
   if (value < 0)
   {
-    *p++ = '-';
+    *--p = '-';
   }
+  size_t len = static_cast<size_t>(end - p);
+  memcpy(buf, p, len);
+  buf[len] = '\0';
+  return len;
+}
+
+size_t convertHex(char buf[], uintptr_t value)
+{
+  // number of nibbles is known up front, no reverse.
+  int bits = value == 0 ? 4 : 64 - __builtin_clzll(value);
+  size_t len = static_cast<size_t>((bits + 3) / 4);
+  char* p = buf + len;
   *p = '\0';
-  std::reverse(buf, p);
+  do
+  {
+    *--p = digitsHex[value & 0xF];
+    value >>= 4;
+  } while (p != buf);
 
-  return p - buf;
+  return len;
 }
 
-size_t convertHex(char buf[], uintptr_t value)
+// Grisu2, "Printing Floating-Point Numbers Quickly and Accurately with
+// Integers", by Florian Loitsch, after the implementation in RapidJSON.
+// It gives the shortest digits that read back to the same double in
+// 99.9% of cases, and never wrong digits in the rest.
+namespace grisu
 {
-  uintptr_t i = value;
-  char* p = buf;
 
-  do
+struct DiyFp
+{
+  uint64_t f;
+  int e;
+
+  DiyFp(uint64_t fp, int exp) : f(fp), e(exp) {}
+
+  explicit DiyFp(double d)
+  {
+    const uint64_t kFractionMask = 0x000FFFFFFFFFFFFFULL;
+    const uint64_t kHiddenBit = 0x0010000000000000ULL;
+    uint64_t bits = 0;
+    memcpy(&bits, &d, sizeof bits);
+    int biasedExp = static_cast<int>((bits >> 52) & 0x7FF);
+    f = bits & kFractionMask;
+    if (biasedExp != 0)
+    {
+      f += kHiddenBit;
+      e = biasedExp - 1075;
+    }
+    else
+    {
+      e = -1074;
+    }
+  }
+
+  DiyFp operator-(const DiyFp& rhs) const
+  {
+    return DiyFp(f - rhs.f, e);
+  }
+
+  // rounded 64x64 bit multiplication, keeps the high half.
+  DiyFp operator*(const DiyFp& rhs) const
+  {
+    unsigned __int128 p = static_cast<unsigned __int128>(f) * rhs.f;
+    uint64_t h = static_cast<uint64_t>(p >> 64);
+    uint64_t l = static_cast<uint64_t>(p);
+    if (l & (uint64_t(1) << 63))
+    {
+      ++h;
+    }
+    return DiyFp(h, e + rhs.e + 64);
+  }
+
+  DiyFp normalize() const
+  {
+    int s = __builtin_clzll(f);
+    return DiyFp(f << s, e - s);
+  }
+
+  // m+ and m-, the boundaries of the rounding interval, with the same exponent.
+  void normalizedBoundaries(DiyFp* minus, DiyFp* plus) const
   {
-    int lsd = static_cast<int>(i % 16);
-    i /= 16;
-    *p++ = digitsHex[lsd];
-  } while (i != 0);
+    DiyFp pl = DiyFp((f << 1) + 1, e - 1).normalize();
+    DiyFp mi = (f == 0x0010000000000000ULL) ? DiyFp((f << 2) - 1, e - 2)
+                                            : DiyFp((f << 1) - 1, e - 1);
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+    *plus = pl;
+    *minus = mi;
+  }
+};
 
+// 10^k for k = -348, -340, ..., 340
+const uint64_t kCachedPowersF[] =
+{
+  0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+  0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+  0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+  0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+  0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+  0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+  0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+  0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+  0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+  0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+  0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+  0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+  0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+  0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+  0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+  0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+  0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+  0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+  0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+  0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+  0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+  0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+  0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+  0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+  0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+  0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+  0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+  0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+  0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+};
+
+const int16_t kCachedPowersE[] =
+{
+  -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+  -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+  -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+  -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+  56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+  375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+  694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+  1013, 1039, 1066
+};
+
+const uint64_t kPow10[] =
+{
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+  10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+  100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL,
+};
+
+// c = 10^-k, so that c*w has its exponent in [-60, -32].
+DiyFp cachedPower(int e, int* k)
+{
+  double dk = (-61 - e) * 0.30102999566398114 + 347;  // dk must be positive
+  int ik = static_cast<int>(dk);
+  if (dk - ik > 0.0)
+  {
+    ++ik;
+  }
+  unsigned index = static_cast<unsigned>((ik >> 3) + 1);
+  *k = -(-348 + static_cast<int>(index) * 8);
+  return DiyFp(kCachedPowersF[index], kCachedPowersE[index]);
+}
+
+int countDecimalDigit32(uint32_t n)
+{
+  int count = 1;
+  while (n >= 10)
+  {
+    n /= 10;
+    ++count;
+  }
+  return count;
+}
+
+void grisuRound(char* buffer, int len, uint64_t delta, uint64_t rest,
+                uint64_t tenKappa, uint64_t wpw)
+{
+  // closer to w, without leaving the rounding interval.
+  while (rest < wpw && delta - rest >= tenKappa &&
+         (rest + tenKappa < wpw || wpw - rest > rest + tenKappa - wpw))
+  {
+    buffer[len - 1]--;
+    rest += tenKappa;
+  }
+}
+
+int digitGen(const DiyFp& w, const DiyFp& mp, uint64_t delta, char* buffer, int* k)
+{
+  const DiyFp one(uint64_t(1) << -mp.e, mp.e);
+  const DiyFp wpw = mp - w;
+  uint32_t p1 = static_cast<uint32_t>(mp.f >> -one.e);
+  uint64_t p2 = mp.f & (one.f - 1);
+  int kappa = countDecimalDigit32(p1);
+  int len = 0;
+
+  while (kappa > 0)
+  {
+    uint32_t div = static_cast<uint32_t>(kPow10[kappa - 1]);
+    uint32_t d = p1 / div;
+    p1 %= div;
+    if (d || len)
+    {
+      buffer[len++] = static_cast<char>('0' + d);
+    }
+    --kappa;
+    uint64_t rest = (static_cast<uint64_t>(p1) << -one.e) + p2;
+    if (rest <= delta)
+    {
+      *k += kappa;
+      grisuRound(buffer, len, delta, rest, kPow10[kappa] << -one.e, wpw.f);
+      return len;
+    }
+  }
+
+  for (;;)
+  {
+    p2 *= 10;
+    delta *= 10;
+    char d = static_cast<char>(p2 >> -one.e);
+    if (d || len)
+    {
+      buffer[len++] = static_cast<char>('0' + d);
+    }
+    p2 &= one.f - 1;
+    --kappa;
+    if (p2 < delta)
+    {
+      *k += kappa;
+      int index = -kappa;
+      grisuRound(buffer, len, delta, p2, one.f, wpw.f * (index < 20 ? kPow10[index] : 0));
+      return len;
+    }
+  }
+}
+
+// v is finite and positive, value is digits * 10^k.
+int grisu2(double value, char* digits, int* k)
+{
+  const DiyFp v(value);
+  DiyFp minus(0, 0), plus(0, 0);
+  v.normalizedBoundaries(&minus, &plus);
+
+  const DiyFp cmk = cachedPower(plus.e, k);
+  const DiyFp w = v.normalize() * cmk;
+  DiyFp wp = plus * cmk;
+  DiyFp wm = minus * cmk;
+  wm.f++;
+  wp.f--;
+  return digitGen(w, wp, wp.f - wm.f, digits, k);
+}
+
+// rounds digits to precision digits, returns false on a near tie,
+// where the digits of Grisu2 are too close to tell.
+bool roundDigits(char* digits, int* len, int* k, int precision)
+{
+  if (*len <= precision)
+  {
+    return true;
+  }
+  // the next 4 digits, as a number in [0, 9999]
+  int tail = 0;
+  for (int i = precision; i < precision + 4; ++i)
+  {
+    tail = tail * 10 + (i < *len ? digits[i] - '0' : 0);
+  }
+  // Grisu2 digits are off by at most a few units in the 16th digit.
+  if (tail >= 4990 && tail <= 5010)
+  {
+    return false;
+  }
+  *k += *len - precision;
+  *len = precision;
+  if (tail > 5000)
+  {
+    int i = precision - 1;
+    while (i >= 0 && digits[i] == '9')
+    {
+      digits[i--] = '0';
+    }
+    if (i >= 0)
+    {
+      digits[i]++;
+    }
+    else
+    {
+      // 999 -> 1000
+      digits[0] = '1';
+      *len = 1;
+      *k += precision;
+    }
+  }
+  return true;
+}
+
+// printf %g layout of digits * 10^k, without trailing zeros.
+size_t formatG(char buf[], bool negative, char* digits, int len, int k, int precision)
+{
+  while (len > 1 && digits[len - 1] == '0')
+  {
+    --len;
+    ++k;
+  }
+  char* p = buf;
+  if (negative)
+  {
+    *p++ = '-';
+  }
+  int exp10 = k + len - 1;  // of the first digit
+  if (exp10 < -4 || exp10 >= precision)
+  {
+    // d.ddde+XX
+    *p++ = digits[0];
+    if (len > 1)
+    {
+      *p++ = '.';
+      memcpy(p, digits + 1, static_cast<size_t>(len - 1));
+      p += len - 1;
+    }
+    *p++ = 'e';
+    *p++ = exp10 < 0 ? '-' : '+';
+    int absExp = exp10 < 0 ? -exp10 : exp10;
+    if (absExp >= 100)
+    {
+      *p++ = static_cast<char>('0' + absExp / 100);
+      absExp %= 100;
+    }
+    memcpy(p, digits2 + absExp * 2, 2);
+    p += 2;
+  }
+  else if (exp10 < 0)
+  {
+    // 0.000ddd
+    *p++ = '0';
+    *p++ = '.';
+    memset(p, '0', static_cast<size_t>(-exp10 - 1));
+    p += -exp10 - 1;
+    memcpy(p, digits, static_cast<size_t>(len));
+    p += len;
+  }
+  else if (k >= 0)
+  {
+    // ddd000
+    memcpy(p, digits, static_cast<size_t>(len));
+    p += len;
+    memset(p, '0', static_cast<size_t>(k));
+    p += k;
+  }
+  else
+  {
+    // ddd.ddd
+    memcpy(p, digits, static_cast<size_t>(exp10 + 1));
+    p += exp10 + 1;
+    *p++ = '.';
+    memcpy(p, digits + exp10 + 1, static_cast<size_t>(len - exp10 - 1));
+    p += len - exp10 - 1;
+  }
   *p = '\0';
-  std::reverse(buf, p);
+  return static_cast<size_t>(p - buf);
+}
+
+// precision 0 for the shortest round trip digits.
+size_t convertDouble(char buf[], double v, int precision)
+{
+  if (!std::isfinite(v))
+  {
+    return static_cast<size_t>(snprintf(buf, 32, "%g", v));
+  }
+  bool negative = std::signbit(v);
+  if (v == 0)
+  {
+    char* p = buf;
+    if (negative)
+    {
+      *p++ = '-';
+    }
+    *p++ = '0';
+    *p = '\0';
+    return static_cast<size_t>(p - buf);
+  }
+  char digits[32];
+  int k = 0;
+  int len = grisu2(negative ? -v : v, digits, &k);
+  if (precision == 0)
+  {
+    return formatG(buf, negative, digits, len, k, 17);
+  }
+  // subnormals have fewer significant bits than 12 digits.
+  if (std::fabs(v) < std::numeric_limits<double>::min()
+      || !roundDigits(digits, &len, &k, precision))
+  {
+    return static_cast<size_t>(snprintf(buf, 32, "%.*g", precision, v));
+  }
+  return formatG(buf, negative, digits, len, k, precision);
+}
+
+}  // namespace grisu
 
-  return p - buf;
+size_t convertDouble(char buf[], double v)
+{
+  return grisu::convertDouble(buf, v, 12);
+}
+
+size_t convertShortest(char buf[], double v)
+{
+  return grisu::convertDouble(buf, v, 0);
 }
 
 template class FixedBuffer<kSmallBuffer>;
@@ -184,12 +589,12 @@ LogStream& LogStream::operator<<(const void* p)
   return *this;
 }
 
-// FIXME: replace this with Grisu3 by Florian Loitsch.
+// same text as "%.12g"
 LogStream& LogStream::operator<<(double v)
 {
   if (buffer_.avail() >= kMaxNumericSize)
   {
-    int len = snprintf(buffer_.current(), kMaxNumericSize, "%.12g", v);
+    size_t len = convertDouble(buffer_.current(), v);
     buffer_.add(len);
   }
   return *this;
@@ -219,3 +624,26 @@ template Fmt::Fmt(const char* fmt, unsigned long long);
 
 template Fmt::Fmt(const char* fmt, float);
 template Fmt::Fmt(const char* fmt, double);
+
+RoundTrip::RoundTrip(double val)
+  : length_(static_cast<int>(convertShortest(buf_, val)))
+{
+}
+
+template<typename T>
+Hex::Hex(T val)
+{
+  static_assert(std::is_integral<T>::value == true, "Must be integral type");
+  typedef typename std::make_unsigned<T>::type U;
+  length_ = static_cast<int>(convertHex(buf_, static_cast<U>(val)));
+}
+
+template Hex::Hex(char);
+template Hex::Hex(short);
+template Hex::Hex(unsigned short);
+template Hex::Hex(int);
+template Hex::Hex(unsigned int);
+template Hex::Hex(long);
+template Hex::Hex(unsigned long);
+template Hex::Hex(long long);
+template Hex::Hex(unsigned long long);
@@ -201,6 +201,49 @@ inline LogStream& operator<<(LogStream& s, const Fmt& fmt)
   return s;
 }
 
+/// Shortest text that reads back to the same double,
+/// LogStream prints "%.12g" for compatibility.
+class RoundTrip
+{
+private:
+  char buf_[32];
+  int length_;
+
+public:
+  explicit RoundTrip(double val);
+
+  const char* data() const { return buf_; }
+  int length() const { return length_; }
+};
+
+inline LogStream& operator<<(LogStream& s, const RoundTrip& v)
+{
+  s.append(v.data(), v.length());
+  return s;
+}
+
+/// Upper case hexadecimal without "0x", negative values in two's complement.
+/// Cheaper than Fmt("%X", val).
+class Hex
+{
+private:
+  char buf_[32];
+  int length_;
+
+public:
+  template<typename T>
+  explicit Hex(T val);
+
+  const char* data() const { return buf_; }
+  int length() const { return length_; }
+};
+
+inline LogStream& operator<<(LogStream& s, const Hex& v)
+{
+  s.append(v.data(), v.length());
+  return s;
+}
+
 }  // namespace muduo
 
 #endif  // MUDUO_BASE_LOGSTREAM_H
@@ -6,6 +6,7 @@
 #include <muduo/base/Logging.h>
 
 #include <muduo/base/CurrentThread.h>
+#include <muduo/base/Mutex.h>
 #include <muduo/base/Timestamp.h>
 #include <muduo/base/TimeZone.h>
 
@@ -13,7 +14,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 namespace muduo
 {
@@ -40,6 +43,7 @@ __thread char t_time[64];
 __thread time_t t_lastSecond;
 
 Logger::LogLevel g_logLevel = initLogLevel();
+Logger::LineFormat g_keyValueFormat = Logger::kLogfmt;
 Logger::OutputFunc g_output = defaultOutput;
 Logger::FlushFunc g_flush = defaultFlush;
 TimeZone g_logTimeZone;
@@ -69,6 +73,8 @@ const char* LogLevelName[Logger::NUM_LOG_LEVELS] =
   "FATAL ",
 };
 
+const int LogLevelNameLength[Logger::NUM_LOG_LEVELS] = { 5, 5, 4, 4, 5, 5 };
+
 // helper class for known string length at compile time
 class T
 {
@@ -108,18 +114,90 @@ void defaultFlush()
   fflush(stdout);
 }
 
+// of LogModule, constructed on first use, modules are often globals.
+struct LogModules
+{
+  MutexLock mutex;
+  Logger::LogLevel defaultLevel;  // g_logLevel may not be initialized yet
+  std::vector<LogModule*> modules;
+  std::vector<std::pair<string, Logger::LogLevel> > levels;  // by name
+
+  LogModules()
+    : defaultLevel(initLogLevel())
+  {
+    // MUDUO_LOG_MODULES=net=DEBUG,http=TRACE
+    const char* env = ::getenv("MUDUO_LOG_MODULES");
+    string spec(env ? env : "");
+    size_t start = 0;
+    while (start < spec.size())
+    {
+      size_t end = std::min(spec.find(',', start), spec.size());
+      string item(spec, start, end - start);
+      size_t equal = item.find('=');
+      if (equal != string::npos)
+      {
+        for (int i = 0; i < Logger::NUM_LOG_LEVELS; ++i)
+        {
+          string name(LogLevelName[i]);
+          name.erase(name.find(' '));
+          if (item.compare(equal + 1, string::npos, name) == 0)
+          {
+            setLevel(item.substr(0, equal), static_cast<Logger::LogLevel>(i));
+          }
+        }
+      }
+      start = end + 1;
+    }
+  }
+
+  // one entry per name, the last one wins.
+  void setLevel(const string& name, Logger::LogLevel level)
+  {
+    for (auto& entry : levels)
+    {
+      if (entry.first == name)
+      {
+        entry.second = level;
+        return;
+      }
+    }
+    levels.push_back(std::make_pair(name, level));
+  }
+
+  static LogModules& instance()
+  {
+    static LogModules modules;
+    return modules;
+  }
+};
+
 }  // namespace muduo
 
 using namespace muduo;
 
-Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int line)
+Logger::Impl::Impl(LogLevel level, int savedErrno, const SourceFile& file, int line,
+                   LineFormat format)
   : time_(Timestamp::now()),
     stream_(),
     level_(level),
     line_(line),
-    basename_(file)
+    basename_(file),
+    format_(format)
 {
+  if (format_ == kJson)
+  {
+    // file and line go first, finish() only closes the object.
+    stream_ << T("{\"time\":\"", 9);
+    formatTime();
+    stream_ << T("\",\"tid\":", 8) << CurrentThread::tid()
+            << T(",\"level\":\"", 10);
+    stream_.append(LogLevelName[level], LogLevelNameLength[level]);
+    stream_ << T("\",\"file\":\"", 10) << basename_
+            << T("\",\"line\":", 9) << line_;
+    return;
+  }
   formatTime();
+  stream_ << ' ';
   CurrentThread::tid();
   stream_ << T(CurrentThread::tidString(), CurrentThread::tidStringLength());
   stream_ << T(LogLevelName[level], 6);
@@ -166,21 +244,28 @@ void Logger::Impl::formatTime()
 
   if (g_logTimeZone.valid())
   {
-    Fmt us(".%06d ", microseconds);
-    assert(us.length() == 8);
-    stream_ << T(s_strZone.c_str(), 4) << T(t_time, 17) << T(us.data(), 8);
+    Fmt us(".%06d", microseconds);
+    assert(us.length() == 7);
+    stream_ << T(s_strZone.c_str(), 4) << T(t_time, 17) << T(us.data(), 7);
   }
   else
   {
-    Fmt us(".%06d ", microseconds);
-    assert(us.length() == 8);
-    stream_ << T(s_strZone.c_str(), 4) << T(t_time, 17) << T(us.data(), 8);
+    Fmt us(".%06d", microseconds);
+    assert(us.length() == 7);
+    stream_ << T(s_strZone.c_str(), 4) << T(t_time, 17) << T(us.data(), 7);
   }
 }
 
 void Logger::Impl::finish()
 {
-  stream_ << " - " << basename_ << ':' << line_ << '\n';
+  if (format_ == kJson)
+  {
+    stream_ << T("}\n", 2);
+  }
+  else
+  {
+    stream_ << " - " << basename_ << ':' << line_ << '\n';
+  }
 }
 
 Logger::Logger(SourceFile file, int line)
@@ -204,6 +289,11 @@ Logger::Logger(SourceFile file, int line, bool toAbort)
 {
 }
 
+Logger::Logger(SourceFile file, int line, LogLevel level, LineFormat format)
+  : impl_(level, 0, file, line, format)
+{
+}
+
 Logger::~Logger()
 {
   impl_.finish();
@@ -219,6 +309,27 @@ Logger::~Logger()
 void Logger::setLogLevel(Logger::LogLevel level)
 {
   g_logLevel = level;
+  LogModules& all = LogModules::instance();
+  MutexLockGuard lock(all.mutex);
+  all.defaultLevel = level;
+  for (LogModule* module : all.modules)
+  {
+    module->setLevel(level, false);
+  }
+}
+
+void Logger::setLogLevel(const char* module, Logger::LogLevel level)
+{
+  LogModules& all = LogModules::instance();
+  MutexLockGuard lock(all.mutex);
+  all.setLevel(module, level);
+  for (LogModule* m : all.modules)
+  {
+    if (strcmp(m->name(), module) == 0)
+    {
+      m->setLevel(level, true);
+    }
+  }
 }
 
 void Logger::setOutput(OutputFunc out)
@@ -235,3 +346,58 @@ void Logger::setTimeZone(const TimeZone& tz)
 {
   g_logTimeZone = tz;
 }
+
+void Logger::setKeyValueFormat(LineFormat format)
+{
+  assert(format != kText);
+  g_keyValueFormat = format;
+}
+
+LogModule::LogModule(const char* name)
+  : name_(name),
+    level_(Logger::INFO),
+    explicit_(false)
+{
+  LogModules& all = LogModules::instance();
+  MutexLockGuard lock(all.mutex);
+  level_.store(all.defaultLevel, std::memory_order_relaxed);
+  for (const auto& level : all.levels)
+  {
+    if (level.first == name_)
+    {
+      setLevel(level.second, true);
+    }
+  }
+  all.modules.push_back(this);
+}
+
+LogModule::~LogModule()
+{
+  LogModules& all = LogModules::instance();
+  MutexLockGuard lock(all.mutex);
+  all.modules.erase(std::remove(all.modules.begin(), all.modules.end(), this),
+                    all.modules.end());
+}
+
+void LogModule::setLevel(Logger::LogLevel level, bool byName)
+{
+  if (byName || !explicit_)
+  {
+    level_.store(level, std::memory_order_relaxed);
+    explicit_ = explicit_ || byName;
+  }
+}
+
+int64_t detail::logEverySec(LogRateLimit* limit, double seconds)
+{
+  int64_t now = Timestamp::now().microSecondsSinceEpoch();
+  int64_t next = limit->next.load(std::memory_order_relaxed);
+  if (now < next
+      || !limit->next.compare_exchange_strong(
+            next, now + static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond)))
+  {
+    limit->count.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+  return limit->count.exchange(0, std::memory_order_relaxed) + 1;
+}
@@ -9,6 +9,8 @@
 #include <muduo/base/LogStream.h>
 #include <muduo/base/Timestamp.h>
 
+#include <atomic>
+
 namespace muduo
 {
 
@@ -36,6 +38,14 @@ public:
     NUM_LOG_LEVELS,
   };
 
+  /// layout of a line, kLogfmt and kJson are for KeyValueLogger.
+  enum LineFormat
+  {
+    kText,    ///< time tid level message - file:line
+    kLogfmt,  ///< time tid level key=value ... - file:line
+    kJson,    ///< {"time":...,"key":value,...}
+  };
+
   // compile time calculation of basename of source file
   class SourceFile
   {
@@ -77,9 +87,11 @@ private:
     LogLevel level_;
     int line_; // __LINE__
     SourceFile basename_; // __FILE__ without dir
+    LineFormat format_;
 
   public:
-    Impl(LogLevel level, int old_errno, const SourceFile& file, int line);
+    Impl(LogLevel level, int old_errno, const SourceFile& file, int line,
+         LineFormat format = kText);
     void formatTime();
     void finish();
   };
@@ -92,24 +104,112 @@ public:
   Logger(SourceFile file, int line, LogLevel level);
   Logger(SourceFile file, int line, LogLevel level, const char* func);
   Logger(SourceFile file, int line, bool toAbort);
+  Logger(SourceFile file, int line, LogLevel level, LineFormat format);
   ~Logger();
 
   LogStream& stream() { return impl_.stream_; }
 
   static LogLevel logLevel();
   static void setLogLevel(LogLevel level);
+  /// Level of a LogModule, it no longer follows setLogLevel(LogLevel).
+  static void setLogLevel(const char* module, LogLevel level);
   static void setOutput(OutputFunc);
   static void setFlush(FlushFunc);
   static void setTimeZone(const TimeZone& tz);
+  static LineFormat keyValueFormat();
+  /// kLogfmt by default, or kJson.
+  static void setKeyValueFormat(LineFormat format);
 };
 
 extern Logger::LogLevel g_logLevel;
+extern Logger::LineFormat g_keyValueFormat;
 
 inline Logger::LogLevel Logger::logLevel()
 {
   return g_logLevel;
 }
 
+inline Logger::LineFormat Logger::keyValueFormat()
+{
+  return g_keyValueFormat;
+}
+
+/** class LogModule
+ * - Brief:
+ *    runtime log level of a group of source files, e.g. "net" or "http",
+ *    checked by LOG_MODULE(module, level) with one load and one branch.
+ *    1) follows Logger::setLogLevel(level) until set by name, with
+ *       Logger::setLogLevel(name, level) or MUDUO_LOG_MODULES=net=DEBUG,http=TRACE
+ *    2) defined at namespace scope, lives as long as the program.
+ */
+class LogModule : noncopyable
+{
+private:
+  const char* name_;
+  std::atomic<int> level_;  ///< Logger::LogLevel, read by every LOG_MODULE.
+  bool explicit_;  ///< level set by name, setLogLevel(level) leaves it alone.
+
+public:
+  explicit LogModule(const char* name);
+  ~LogModule();
+
+  const char* name() const { return name_; }
+  Logger::LogLevel level() const
+  { return static_cast<Logger::LogLevel>(level_.load(std::memory_order_relaxed)); }
+
+private:
+  friend class Logger;
+  void setLevel(Logger::LogLevel level, bool byName);
+};
+
+namespace detail
+{
+
+/// state of a LOG_EVERY_N or LOG_EVERY_SEC statement, zero initialized.
+struct LogRateLimit
+{
+  std::atomic<int64_t> count;
+  std::atomic<int64_t> next;  ///< microseconds, next time to log.
+};
+
+/// true for the 1st, (n+1)th, (2n+1)th ... call, every call if n <= 1.
+inline bool logEveryN(LogRateLimit* limit, int64_t n)
+{
+  return n <= 1 || limit->count.fetch_add(1, std::memory_order_relaxed) % n == 0;
+}
+
+/// 0 to skip, or 1 + number of statements skipped since the last one logged.
+int64_t logEverySec(LogRateLimit* limit, double seconds);
+
+struct LogSkipped
+{
+  int64_t count;
+};
+
+inline LogStream& operator<<(LogStream& s, LogSkipped skipped)
+{
+  if (skipped.count > 0)
+  {
+    s << '[' << skipped.count << " skipped] ";
+  }
+  return s;
+}
+
+}  // namespace detail
+
+//
+// Compile with -DMUDUO_LOG_MIN_LEVEL=N to remove statements below level N
+// entirely, 0 TRACE, 1 DEBUG, 2 INFO, 3 WARN, 4 ERROR. FATAL always stays.
+//
+#ifndef MUDUO_LOG_MIN_LEVEL
+#define MUDUO_LOG_MIN_LEVEL 0
+#endif
+
+#define MUDUO_LOG_COMPILED(level) \
+  (static_cast<int>(muduo::Logger::level) >= MUDUO_LOG_MIN_LEVEL)
+#define MUDUO_LOG_ENABLED(level) \
+  (MUDUO_LOG_COMPILED(level) && muduo::Logger::logLevel() <= muduo::Logger::level)
+
 //
 // CAUTION: do not write:
 //
@@ -126,18 +226,48 @@ inline Logger::LogLevel Logger::logLevel()
 //   else
 //     logWarnStream << "Bad news";
 //
-#define LOG_TRACE if (muduo::Logger::logLevel() <= muduo::Logger::TRACE) \
+#define LOG_TRACE if (MUDUO_LOG_ENABLED(TRACE)) \
   muduo::Logger(__FILE__, __LINE__, muduo::Logger::TRACE, __func__).stream()
-#define LOG_DEBUG if (muduo::Logger::logLevel() <= muduo::Logger::DEBUG) \
+#define LOG_DEBUG if (MUDUO_LOG_ENABLED(DEBUG)) \
   muduo::Logger(__FILE__, __LINE__, muduo::Logger::DEBUG, __func__).stream()
-#define LOG_INFO if (muduo::Logger::logLevel() <= muduo::Logger::INFO) \
+#define LOG_INFO if (MUDUO_LOG_ENABLED(INFO)) \
   muduo::Logger(__FILE__, __LINE__).stream()
-#define LOG_WARN muduo::Logger(__FILE__, __LINE__, muduo::Logger::WARN).stream()
-#define LOG_ERROR muduo::Logger(__FILE__, __LINE__, muduo::Logger::ERROR).stream()
+#define LOG_WARN if (MUDUO_LOG_ENABLED(WARN)) \
+  muduo::Logger(__FILE__, __LINE__, muduo::Logger::WARN).stream()
+#define LOG_ERROR if (MUDUO_LOG_ENABLED(ERROR)) \
+  muduo::Logger(__FILE__, __LINE__, muduo::Logger::ERROR).stream()
 #define LOG_FATAL muduo::Logger(__FILE__, __LINE__, muduo::Logger::FATAL).stream()
-#define LOG_SYSERR muduo::Logger(__FILE__, __LINE__, false).stream()
+#define LOG_SYSERR if (MUDUO_LOG_ENABLED(ERROR)) \
+  muduo::Logger(__FILE__, __LINE__, false).stream()
 #define LOG_SYSFATAL muduo::Logger(__FILE__, __LINE__, true).stream()
 
+// LOG_MODULE(g_netLog, DEBUG) << "...";
+#define LOG_MODULE(module, severity) \
+  if (MUDUO_LOG_COMPILED(severity) && (module).level() <= muduo::Logger::severity) \
+    muduo::Logger(__FILE__, __LINE__, muduo::Logger::severity, __func__).stream()
+
+// LOG_EVERY_N(WARN, 100) << "...", logs the 1st, 101st, 201st ... time.
+#define LOG_EVERY_N(level, n) \
+  if (MUDUO_LOG_ENABLED(level) && \
+      ({ static muduo::detail::LogRateLimit muduo_log_limit; \
+         muduo::detail::logEveryN(&muduo_log_limit, (n)); })) \
+    muduo::Logger(__FILE__, __LINE__, muduo::Logger::level).stream()
+
+// LOG_EVERY_SEC(ERROR, 1.0) << "...", at most once per second,
+// with the number of statements skipped in between.
+#define LOG_EVERY_SEC(level, seconds) \
+  if (int64_t muduo_log_n = MUDUO_LOG_ENABLED(level) ? \
+      ({ static muduo::detail::LogRateLimit muduo_log_limit; \
+         muduo::detail::logEverySec(&muduo_log_limit, (seconds)); }) : 0) \
+    muduo::Logger(__FILE__, __LINE__, muduo::Logger::level).stream() \
+      << muduo::detail::LogSkipped{muduo_log_n - 1}
+#define LOG_SYSERR_EVERY_SEC(seconds) \
+  if (int64_t muduo_log_n = MUDUO_LOG_ENABLED(ERROR) ? \
+      ({ static muduo::detail::LogRateLimit muduo_log_limit; \
+         muduo::detail::logEverySec(&muduo_log_limit, (seconds)); }) : 0) \
+    muduo::Logger(__FILE__, __LINE__, false).stream() \
+      << muduo::detail::LogSkipped{muduo_log_n - 1}
+
 const char* strerror_tl(int savedErrno);
 
 // Taken from glog/logging.h
@@ -0,0 +1,203 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/MappedRingLog.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/base/Types.h>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+namespace
+{
+
+const char kMagic[8] = { 'M', 'U', 'D', 'U', 'O', 'R', 'N', 'G' };
+const uint32_t kVersion = 1;
+
+uint64_t recordSize(uint32_t len)
+{
+  return (MappedRingLog::kRecordHeaderSize + len + 7) & ~static_cast<uint64_t>(7);
+}
+
+}  // namespace
+
+struct MappedRingLog::Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t headerSize;
+  uint64_t capacity;
+  int64_t createTime;   // microseconds since epoch
+  int32_t pid;
+  alignas(64) uint64_t cursor;  // bytes reserved since created, own cache line
+};
+
+MappedRingLog::MappedRingLog(StringArg filename, size_t capacity)
+  : fd_(::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+    capacity_(implicit_cast<size_t>(
+          (capacity + kHeaderSize - 1) / kHeaderSize * kHeaderSize)),
+    map_(NULL),
+    header_(NULL),
+    ring_(NULL),
+    maxLineLength_(static_cast<int>(std::min<size_t>(capacity_ / 4, 1024*1024)))
+{
+  static_assert(sizeof(Header) <= kHeaderSize, "header too large");
+  if (fd_ < 0)
+  {
+    fprintf(stderr, "MappedRingLog: open %s failed %s\n", filename.c_str(), strerror(errno));
+    abort();
+  }
+  const off_t fileSize = static_cast<off_t>(kHeaderSize + capacity_);
+  // a store to a hole the file system can not fill is SIGBUS, so allocate now.
+  int err = ::posix_fallocate(fd_, 0, fileSize);
+  if (err == EOPNOTSUPP || err == EINVAL)
+  {
+    err = ::ftruncate(fd_, fileSize) == 0 ? 0 : errno;
+  }
+  if (err != 0)
+  {
+    fprintf(stderr, "MappedRingLog: allocate %s failed %s\n", filename.c_str(), strerror(err));
+    abort();
+  }
+  void* addr = ::mmap(NULL, static_cast<size_t>(fileSize), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED)
+  {
+    fprintf(stderr, "MappedRingLog: mmap %s failed %s\n", filename.c_str(), strerror(errno));
+    abort();
+  }
+  map_ = static_cast<char*>(addr);
+  header_ = reinterpret_cast<Header*>(map_);
+  ring_ = map_ + kHeaderSize;
+
+  header_->version = kVersion;
+  header_->headerSize = static_cast<uint32_t>(kHeaderSize);
+  header_->capacity = capacity_;
+  header_->createTime = Timestamp::now().microSecondsSinceEpoch();
+  header_->pid = ::getpid();
+  __atomic_store_n(&header_->cursor, 0, __ATOMIC_RELAXED);
+  // readers take a file with magic as complete.
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(header_->magic, kMagic, sizeof kMagic);
+}
+
+MappedRingLog::~MappedRingLog()
+{
+  ::munmap(map_, kHeaderSize + capacity_);
+  ::close(fd_);
+}
+
+void MappedRingLog::append(const char* logline, int len)
+{
+  const uint32_t length = static_cast<uint32_t>(std::min(std::max(len, 0), maxLineLength_));
+  const uint64_t offset = __atomic_fetch_add(&header_->cursor, recordSize(length), __ATOMIC_RELAXED);
+  const uint32_t lengthAndCheck[2] = { length, check(offset, length) };
+  copyIn(ring_, capacity_, offset + sizeof offset, lengthAndCheck, sizeof lengthAndCheck);
+  copyIn(ring_, capacity_, offset + kRecordHeaderSize, logline, length);
+  // offset is 8 byte aligned, capacity_ too, so it is never split.
+  uint64_t* commit = reinterpret_cast<uint64_t*>(ring_ + offset % capacity_);
+  __atomic_store_n(commit, offset, __ATOMIC_RELEASE);
+}
+
+void MappedRingLog::sync()
+{
+  ::msync(map_, kHeaderSize + capacity_, MS_SYNC);
+}
+
+int MappedRingLog::readFile(StringArg filename, const RecordCallback& cb)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return -1;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize))
+  {
+    ::close(fd);
+    return -1;
+  }
+  const size_t fileSize = static_cast<size_t>(st.st_size);
+  void* addr = ::mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+  {
+    return -1;
+  }
+
+  const char* map = static_cast<const char*>(addr);
+  const Header* header = reinterpret_cast<const Header*>(map);
+  const size_t capacity = fileSize - kHeaderSize;
+  if (memcmp(header->magic, kMagic, sizeof kMagic) != 0
+      || header->version != kVersion
+      || header->headerSize != kHeaderSize
+      || header->capacity != capacity
+      || capacity % 8 != 0)
+  {
+    ::munmap(addr, fileSize);
+    return -1;
+  }
+
+  const char* ring = map + kHeaderSize;
+  const uint64_t cursor = __atomic_load_n(&header->cursor, __ATOMIC_ACQUIRE);
+  // bytes before this are overwritten, a record starting at or after it
+  // and ending before cursor is intact.
+  uint64_t offset = cursor > capacity ? cursor - capacity : 0;
+  int count = 0;
+  string line;
+  while (offset + kRecordHeaderSize <= cursor)
+  {
+    const uint64_t* commit = reinterpret_cast<const uint64_t*>(ring + offset % capacity);
+    uint32_t lengthAndCheck[2];
+    if (__atomic_load_n(commit, __ATOMIC_ACQUIRE) == offset)
+    {
+      copyOut(ring, capacity, offset + sizeof offset, lengthAndCheck, sizeof lengthAndCheck);
+      if (lengthAndCheck[1] == check(offset, lengthAndCheck[0])
+          && offset + recordSize(lengthAndCheck[0]) <= cursor)
+      {
+        line.resize(lengthAndCheck[0]);
+        copyOut(ring, capacity, offset + kRecordHeaderSize, &*line.begin(), line.size());
+        cb(line.data(), static_cast<int>(line.size()));
+        ++count;
+        offset += recordSize(lengthAndCheck[0]);
+        continue;
+      }
+    }
+    // not committed, or not a record boundary, resync.
+    offset += 8;
+  }
+  ::munmap(addr, fileSize);
+  return count;
+}
+
+void MappedRingLog::copyIn(char* ring, size_t capacity, uint64_t offset, const void* data, size_t len)
+{
+  const size_t pos = static_cast<size_t>(offset % capacity);
+  const size_t first = std::min(len, capacity - pos);
+  memcpy(ring + pos, data, first);
+  memcpy(ring, static_cast<const char*>(data) + first, len - first);
+}
+
+void MappedRingLog::copyOut(const char* ring, size_t capacity, uint64_t offset, void* data, size_t len)
+{
+  const size_t pos = static_cast<size_t>(offset % capacity);
+  const size_t first = std::min(len, capacity - pos);
+  memcpy(data, ring + pos, first);
+  memcpy(static_cast<char*>(data) + first, ring, len - first);
+}
+
+uint32_t MappedRingLog::check(uint64_t offset, uint32_t len)
+{
+  return len ^ static_cast<uint32_t>(offset >> 3) ^ 0x474e4952;  // "RING"
+}
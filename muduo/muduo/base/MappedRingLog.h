@@ -0,0 +1,79 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_MAPPEDRINGLOG_H
+#define MUDUO_BASE_MAPPEDRINGLOG_H
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/base/StringPiece.h>
+
+#include <functional>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace muduo
+{
+
+/** class MappedRingLog
+ * - Brief:
+ *    flight recorder: log lines are copied into a ring in a MAP_SHARED
+ *    file mapping. the pages belong to the kernel, so whatever is appended
+ *    survives LOG_FATAL, a crash or SIGKILL of the process, without write(2)
+ *    or fsync in the logging path. old lines are overwritten.
+ *    1) file: a kHeaderSize header, with a cursor of total bytes reserved,
+ *       then capacity bytes of ring.
+ *    2) record: u64 offset, u32 length, u32 check, then the line, padded to
+ *       8 bytes. offset is of the record since the ring was created.
+ *    3) append() reserves its record with an atomic add on the cursor,
+ *       copies the line in, and commits by storing offset last. a reader
+ *       takes a record only if its offset matches its place, so half
+ *       written records are skipped, so is anything a slower writer still
+ *       holds after a whole lap, as long as the ring is not tiny.
+ *    thread safe, one ring for the process.
+ */
+class MappedRingLog : noncopyable
+{
+public:
+  typedef std::function<void (const char* line, int len)> RecordCallback;
+
+  static const size_t kHeaderSize = 4096;
+  static const int kRecordHeaderSize = 16;
+
+private:
+  struct Header;
+
+  int fd_;
+  size_t capacity_;
+  char* map_;
+  Header* header_;
+  char* ring_;
+  int maxLineLength_;  // longer lines are truncated.
+
+public:
+  /// Creates or truncates filename, \a capacity is rounded up to pages.
+  /// Aborts if the file can not be created.
+  MappedRingLog(StringArg filename, size_t capacity);
+  ~MappedRingLog();
+
+  void append(const char* logline, int len);
+  /// Writes dirty pages to disk, it is only needed against a power loss.
+  void sync();
+
+  size_t capacity() const { return capacity_; }
+
+  /// Calls cb for every line still in the ring of filename, oldest first.
+  /// Returns number of lines, -1 if filename is not a ring log.
+  static int readFile(StringArg filename, const RecordCallback& cb);
+
+private:
+  static void copyIn(char* ring, size_t capacity, uint64_t offset, const void* data, size_t len);
+  static void copyOut(const char* ring, size_t capacity, uint64_t offset, void* data, size_t len);
+  static uint32_t check(uint64_t offset, uint32_t len);
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_MAPPEDRINGLOG_H
@@ -111,6 +111,8 @@ __END_DECLS
 namespace muduo
 {
 
+class LockStats;
+
 // Use as data member of a class, eg.
 //
 // class Foo
@@ -139,18 +141,30 @@ class /*CAPABILITY("mutex")*/ MutexLock : noncopyable
 private:
   pthread_mutex_t mutex_;
   pid_t holder_;
+  LockStats* stats_;  ///< of named lock, see LockProfiler.h
+  int64_t lockedAt_;  ///< in nanoseconds, when hold time is sampled.
 
 public:
   MutexLock()
-    : holder_(0)
+    : holder_(0),
+      stats_(NULL),
+      lockedAt_(0)
   {
     MCHECK(pthread_mutex_init(&mutex_, NULL));
   }
 
+  /// Contention of a named lock is profiled while LockProfiler is enabled,
+  /// locks of the same name are reported together, e.g. shards of a map.
+  explicit MutexLock(const char* name);
+
   ~MutexLock()
   {
     assert(holder_ == 0);
     MCHECK(pthread_mutex_destroy(&mutex_));
+    if (stats_)
+    {
+      releaseStats();
+    }
   }
 
   // must be called when locked, i.e. for assertion
@@ -168,7 +182,14 @@ public:
 
   void lock() ACQUIRE()
   {
-    MCHECK(pthread_mutex_lock(&mutex_));
+    if (stats_)
+    {
+      lockProfiled();
+    }
+    else
+    {
+      MCHECK(pthread_mutex_lock(&mutex_));
+    }
     assignHolder();
   }
 
@@ -204,9 +225,18 @@ private:
 
   void unassignHolder()
   {
+    if (lockedAt_)
+    {
+      endHold();
+    }
     holder_ = 0;
   }
 
+  /// in LockProfiler.cc
+  void lockProfiled();
+  void endHold();
+  void releaseStats();
+
   void assignHolder()
   {
     holder_ = CurrentThread::tid();
@@ -0,0 +1,281 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_OBJECTPOOL_H
+#define MUDUO_BASE_OBJECTPOOL_H
+
+#include <muduo/base/Mutex.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <stddef.h>
+
+namespace muduo
+{
+
+/** class ObjectPool
+ * - Brief:
+ *    fixed size blocks for objects of type T, one pool per T, to take hot
+ *    allocations off malloc, e.g. Timer and TcpConnection.
+ *    1) every thread caches free blocks in a list of its own, taking and
+ *       returning a block touches no shared cache line.
+ *    2) a thread gets kBatchSize blocks at a time from the global list when
+ *       its cache is empty, and gives kBatchSize back when it has twice as
+ *       many, so blocks freed in another thread than the one allocating
+ *       flow back in batches, under a mutex once per kBatchSize.
+ *    3) cache of an exiting thread goes to the global list.
+ *    memory is never given back to the system, the pool keeps the peak.
+ *    for std::shared_ptr use makeShared(), which puts the control block and
+ *    the object in one block, see PoolAllocator.
+ */
+template<typename T>
+class ObjectPool : noncopyable
+{
+public:
+  static const int kBatchSize = 32;
+
+private:
+  union Node
+  {
+    Node* next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+  static_assert(alignof(Node) <= alignof(max_align_t), "over aligned T");
+
+  struct Chain
+  {
+    Node* head;
+    int count;
+  };
+
+  // per thread, POD for __thread.
+  struct Cache
+  {
+    Node* head;
+    int count;
+    bool registered;  ///< for flush at thread exit
+  };
+
+  struct Global
+  {
+    MutexLock mutex;
+    std::vector<Chain> chains GUARDED_BY(mutex);
+    pthread_key_t key;
+    std::atomic<int64_t> blocks;
+
+    Global()
+      : blocks(0)
+    {
+      MCHECK(pthread_key_create(&key, &ObjectPool::onThreadExit));
+    }
+  };
+
+  static __thread Cache t_cache;
+
+public:
+  static void* allocate()
+  {
+    Cache& cache = t_cache;
+    if (cache.head == NULL)
+    {
+      refill();
+    }
+    Node* node = cache.head;
+    cache.head = node->next;
+    --cache.count;
+    return node;
+  }
+
+  static void deallocate(void* p)
+  {
+    Node* node = static_cast<Node*>(p);
+    Cache& cache = t_cache;
+    if (!cache.registered)
+    {
+      registerThread();
+    }
+    node->next = cache.head;
+    cache.head = node;
+    if (++cache.count >= 2 * kBatchSize)
+    {
+      release(kBatchSize);
+    }
+  }
+
+  template<typename... Args>
+  static T* create(Args&&... args)
+  {
+    void* p = allocate();
+    try
+    {
+      return new (p) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      deallocate(p);
+      throw;
+    }
+  }
+
+  static void destroy(T* obj)
+  {
+    if (obj)
+    {
+      obj->~T();
+      deallocate(obj);
+    }
+  }
+
+  struct Deleter
+  {
+    void operator()(T* obj) const { destroy(obj); }
+  };
+  typedef std::unique_ptr<T, Deleter> UniquePtr;
+
+  template<typename... Args>
+  static UniquePtr makeUnique(Args&&... args)
+  {
+    return UniquePtr(create(std::forward<Args>(args)...));
+  }
+
+  /// Blocks ever made, for stats.
+  static int64_t blocks()
+  {
+    return global().blocks.load(std::memory_order_relaxed);
+  }
+
+private:
+  // never destroyed, blocks may be freed during exit.
+  static Global& global()
+  {
+    static Global* global = new Global;
+    return *global;
+  }
+
+  // so that cache is flushed at thread exit.
+  static void registerThread()
+  {
+    t_cache.registered = true;
+    MCHECK(pthread_setspecific(global().key, &t_cache));
+  }
+
+  static void refill()
+  {
+    Global& g = global();
+    Cache& cache = t_cache;
+    if (!cache.registered)
+    {
+      registerThread();
+    }
+    {
+    MutexLockGuard lock(g.mutex);
+    if (!g.chains.empty())
+    {
+      Chain chain = g.chains.back();
+      g.chains.pop_back();
+      cache.head = chain.head;
+      cache.count = chain.count;
+      return;
+    }
+    }
+    Node* nodes = static_cast<Node*>(::operator new(sizeof(Node) * kBatchSize));
+    for (int i = 0; i < kBatchSize - 1; ++i)
+    {
+      nodes[i].next = &nodes[i+1];
+    }
+    nodes[kBatchSize-1].next = NULL;
+    cache.head = nodes;
+    cache.count = kBatchSize;
+    g.blocks.fetch_add(kBatchSize, std::memory_order_relaxed);
+  }
+
+  // gives the first n cached blocks to global list.
+  static void release(int n)
+  {
+    Cache& cache = t_cache;
+    Chain chain = { cache.head, n };
+    Node* last = cache.head;
+    for (int i = 1; i < n; ++i)
+    {
+      last = last->next;
+    }
+    cache.head = last->next;
+    cache.count -= n;
+    last->next = NULL;
+    Global& g = global();
+    MutexLockGuard lock(g.mutex);
+    g.chains.push_back(chain);
+  }
+
+  static void onThreadExit(void*)
+  {
+    if (t_cache.count > 0)
+    {
+      release(t_cache.count);
+    }
+    t_cache.registered = false;
+  }
+};
+
+template<typename T>
+__thread typename ObjectPool<T>::Cache ObjectPool<T>::t_cache = { NULL, 0, false };
+
+/// Allocator of ObjectPool, for std::allocate_shared().
+template<typename T>
+class PoolAllocator
+{
+public:
+  typedef T value_type;
+
+  PoolAllocator() = default;
+
+  template<typename U>
+  PoolAllocator(const PoolAllocator<U>&)
+  {
+  }
+
+  T* allocate(size_t n)
+  {
+    if (n == 1)
+    {
+      return static_cast<T*>(ObjectPool<T>::allocate());
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n)
+  {
+    if (n == 1)
+    {
+      ObjectPool<T>::deallocate(p);
+    }
+    else
+    {
+      ::operator delete(p);
+    }
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) { return true; }
+
+template<typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) { return false; }
+
+/// make_shared() of pooled object and control block.
+template<typename T, typename... Args>
+std::shared_ptr<T> makeShared(Args&&... args)
+{
+  return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_OBJECTPOOL_H
@@ -0,0 +1,236 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/ParallelGzipFile.h>
+
+#include <muduo/base/ThreadPool.h>
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+const size_t ParallelGzipFile::kDefaultBlockSize;
+const size_t ParallelGzipFile::kDictionarySize;
+
+struct ParallelGzipFile::Block
+{
+  string input;
+  string dictionary;
+  bool last;
+  string output;   // by compress()
+  uLong crc;       // of input
+  bool ok;
+  bool done;       // by mutex_
+};
+
+namespace
+{
+
+// gzip header of RFC 1952, no name, no mtime, unix.
+const char kGzipHeader[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, 3 };
+
+void putLittleEndian32(char* buf, uLong x)
+{
+  for (int i = 0; i < 4; ++i)
+  {
+    buf[i] = static_cast<char>((x >> (8 * i)) & 0xff);
+  }
+}
+
+}  // namespace
+
+ParallelGzipFile::ParallelGzipFile(StringArg filename,
+                                   ThreadPool* pool,
+                                   int level,
+                                   size_t blockSize)
+  : pool_(pool),
+    level_(level),
+    blockSize_(std::max(blockSize, kDictionarySize)),
+    maxInFlight_(2 * static_cast<size_t>(std::max(pool->numThreads(), 1))),
+    fd_(::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)),
+    ok_(fd_ >= 0),
+    crc_(::crc32(0L, Z_NULL, 0)),
+    uncompressedBytes_(0),
+    compressedBytes_(0),
+    mutex_(),
+    done_(mutex_)
+{
+  input_.reserve(blockSize_);
+  writeFile(kGzipHeader, sizeof kGzipHeader);
+}
+
+ParallelGzipFile::~ParallelGzipFile()
+{
+  close();
+}
+
+bool ParallelGzipFile::append(StringPiece data)
+{
+  const char* p = data.data();
+  size_t len = data.size();
+  while (ok_ && len > 0)
+  {
+    size_t n = std::min(len, blockSize_ - input_.size());
+    input_.append(p, n);
+    uncompressedBytes_ += static_cast<off_t>(n);
+    p += n;
+    len -= n;
+    if (input_.size() == blockSize_)
+    {
+      submit(false);
+    }
+  }
+  return ok_;
+}
+
+bool ParallelGzipFile::close()
+{
+  if (fd_ < 0)
+  {
+    return ok_;
+  }
+  // the last block, maybe empty, ends the deflate stream.
+  submit(true);
+  writeDone(true);
+  if (ok_)
+  {
+    char trailer[8];
+    putLittleEndian32(trailer, crc_);
+    putLittleEndian32(trailer + 4, static_cast<uLong>(uncompressedBytes_) & 0xffffffffUL);
+    writeFile(trailer, sizeof trailer);
+  }
+  if (::close(fd_) != 0)
+  {
+    ok_ = false;
+  }
+  fd_ = -1;
+  return ok_;
+}
+
+void ParallelGzipFile::submit(bool last)
+{
+  BlockPtr block(new Block);
+  block->input.swap(input_);
+  block->dictionary.swap(dictionary_);
+  block->last = last;
+  block->crc = 0;
+  block->ok = false;
+  block->done = false;
+  if (!last)
+  {
+    const string& input = block->input;
+    size_t n = std::min(input.size(), kDictionarySize);
+    dictionary_.assign(input.data() + input.size() - n, n);
+  }
+  input_.reserve(blockSize_);
+  {
+  MutexLockGuard lock(mutex_);
+  inFlight_.push_back(block);
+  }
+  pool_->run(std::bind(&ParallelGzipFile::compress, block, level_, this));
+  writeDone(false);
+}
+
+// writes blocks done in order, waits while too many in flight, or for
+// all if wait.
+void ParallelGzipFile::writeDone(bool wait)
+{
+  while (true)
+  {
+    BlockPtr block;
+    {
+    MutexLockGuard lock(mutex_);
+    if (inFlight_.empty())
+    {
+      break;
+    }
+    if (wait || inFlight_.size() > maxInFlight_)
+    {
+      while (!inFlight_.front()->done)
+      {
+        done_.wait();
+      }
+    }
+    if (!inFlight_.front()->done)
+    {
+      break;
+    }
+    block = inFlight_.front();
+    inFlight_.pop_front();
+    }
+    if (ok_ && !block->ok)
+    {
+      ok_ = false;
+    }
+    if (ok_)
+    {
+      writeFile(block->output.data(), block->output.size());
+      crc_ = ::crc32_combine(crc_, block->crc, static_cast<z_off_t>(block->input.size()));
+    }
+  }
+}
+
+void ParallelGzipFile::writeFile(const char* data, size_t len)
+{
+  while (ok_ && len > 0)
+  {
+    ssize_t n = ::write(fd_, data, len);
+    if (n > 0)
+    {
+      data += n;
+      len -= static_cast<size_t>(n);
+      compressedBytes_ += n;
+    }
+    else if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    else
+    {
+      ok_ = false;
+    }
+  }
+}
+
+// in pool thread.
+void ParallelGzipFile::compress(const BlockPtr& block, int level, ParallelGzipFile* owner)
+{
+  Block& b = *block;
+  b.crc = ::crc32(0L, reinterpret_cast<const Bytef*>(b.input.data()),
+                  static_cast<uInt>(b.input.size()));
+
+  z_stream zs;
+  ::memset(&zs, 0, sizeof zs);
+  // negative window bits for raw deflate, header and trailer are ours.
+  b.ok = ::deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+  if (b.ok && !b.dictionary.empty())
+  {
+    b.ok = ::deflateSetDictionary(&zs,
+                                  reinterpret_cast<const Bytef*>(b.dictionary.data()),
+                                  static_cast<uInt>(b.dictionary.size())) == Z_OK;
+  }
+  if (b.ok)
+  {
+    // bound plus the empty stored block of sync flush.
+    b.output.resize(::deflateBound(&zs, static_cast<uLong>(b.input.size())) + 16);
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(b.input.data()));
+    zs.avail_in = static_cast<uInt>(b.input.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&*b.output.begin());
+    zs.avail_out = static_cast<uInt>(b.output.size());
+    int ret = ::deflate(&zs, b.last ? Z_FINISH : Z_SYNC_FLUSH);
+    b.ok = b.last ? ret == Z_STREAM_END : (ret == Z_OK && zs.avail_in == 0);
+    b.output.resize(zs.total_out);
+  }
+  ::deflateEnd(&zs);
+
+  MutexLockGuard lock(owner->mutex_);
+  b.done = true;
+  owner->done_.notifyAll();
+}
@@ -0,0 +1,95 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_PARALLELGZIPFILE_H
+#define MUDUO_BASE_PARALLELGZIPFILE_H
+
+#include <muduo/base/Condition.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+
+#include <deque>
+#include <memory>
+
+#include <sys/types.h>
+#include <zlib.h>
+
+namespace muduo
+{
+
+class ThreadPool;
+
+/** class ParallelGzipFile
+ * - Brief:
+ *    writes a gzip file like GzipFile::openForWriteTruncate(), but compresses
+ *    on a ThreadPool, as pigz does, for big files like rolled logs.
+ *    1) input is cut into blocks of blockSize, each block is raw deflated
+ *       by a task of pool, primed with the last 32KiB of the block before it
+ *       so the ratio is close to gzip, and ends with a sync flush so the
+ *       outputs of blocks concatenate into one deflate stream.
+ *    2) caller thread writes compressed blocks in order, and waits when
+ *       2 * threads blocks are in flight, so memory is bounded.
+ *    3) crc32 of blocks are combined, header and trailer are of gzip, so
+ *       gunzip and GzipFile::openForRead() read it.
+ *    pool must be started and outlive this, a pool of 0 thread compresses
+ *    in caller thread. not thread safe, one writer.
+ */
+class ParallelGzipFile : noncopyable
+{
+public:
+  static const size_t kDefaultBlockSize = 128 * 1024;
+  static const size_t kDictionarySize = 32 * 1024;
+
+private:
+  struct Block;
+  typedef std::shared_ptr<Block> BlockPtr;
+
+  ThreadPool* pool_;
+  const int level_;
+  const size_t blockSize_;
+  const size_t maxInFlight_;
+  int fd_;
+  bool ok_;
+  string input_;       ///< block being filled
+  string dictionary_;  ///< tail of the block before input_
+  uLong crc_;
+  off_t uncompressedBytes_;
+  off_t compressedBytes_;
+
+  MutexLock mutex_;
+  Condition done_;
+  std::deque<BlockPtr> inFlight_ /*GUARDED_BY(mutex_)*/;
+
+public:
+  /// Truncates filename, level is of zlib, 0 to 9.
+  ParallelGzipFile(StringArg filename,
+                   ThreadPool* pool,
+                   int level = Z_DEFAULT_COMPRESSION,
+                   size_t blockSize = kDefaultBlockSize);
+  /// Calls close().
+  ~ParallelGzipFile();
+
+  bool valid() const { return ok_; }
+  /// false if any error so far.
+  bool append(StringPiece data);
+  /// Writes the rest and gzip trailer, false if any error so far.
+  bool close();
+
+  /// number of uncompressed bytes
+  off_t tell() const { return uncompressedBytes_; }
+  /// number of compressed bytes written
+  off_t offset() const { return compressedBytes_; }
+
+private:
+  void submit(bool last);
+  void writeDone(bool wait);
+  void writeFile(const char* data, size_t len);
+  static void compress(const BlockPtr& block, int level, ParallelGzipFile* owner);
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_PARALLELGZIPFILE_H
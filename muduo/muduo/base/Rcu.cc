@@ -0,0 +1,122 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/Rcu.h>
+
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+using namespace muduo;
+
+namespace
+{
+
+const size_t kCacheLineSize = 64;
+
+// a cache line of its own, written by owner thread only.
+struct ThreadRecord
+{
+  char pad0[kCacheLineSize];
+  std::atomic<uint64_t> epoch;  // 0 when not reading
+  int nesting;
+  bool inUse;                   // by g_mutex
+  char pad1[kCacheLineSize];
+};
+
+std::atomic<uint64_t> g_epoch(1);
+MutexLock g_mutex;
+std::vector<ThreadRecord*> g_records GUARDED_BY(g_mutex);  // never freed, reused
+pthread_key_t g_key;
+pthread_once_t g_once = PTHREAD_ONCE_INIT;
+
+__thread ThreadRecord* t_record = NULL;
+
+void releaseRecord(void* arg)
+{
+  ThreadRecord* record = static_cast<ThreadRecord*>(arg);
+  assert(record->nesting == 0);
+  MutexLockGuard lock(g_mutex);
+  record->inUse = false;
+}
+
+void createKey()
+{
+  MCHECK(pthread_key_create(&g_key, releaseRecord));
+}
+
+ThreadRecord* registerThread()
+{
+  pthread_once(&g_once, createKey);
+  ThreadRecord* record = NULL;
+  {
+  MutexLockGuard lock(g_mutex);
+  for (ThreadRecord* r : g_records)
+  {
+    if (!r->inUse)
+    {
+      record = r;
+      break;
+    }
+  }
+  if (!record)
+  {
+    record = new ThreadRecord;
+    record->epoch.store(0, std::memory_order_relaxed);
+    record->nesting = 0;
+    g_records.push_back(record);
+  }
+  record->inUse = true;
+  }
+  MCHECK(pthread_setspecific(g_key, record));
+  t_record = record;
+  return record;
+}
+
+}  // namespace
+
+void Rcu::readLock()
+{
+  ThreadRecord* record = t_record ? t_record : registerThread();
+  if (record->nesting++ == 0)
+  {
+    // seq_cst, pairs with exchange of pointer in SnapshotPtr::publish().
+    record->epoch.store(g_epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+  }
+}
+
+void Rcu::readUnlock()
+{
+  ThreadRecord* record = t_record;
+  assert(record && record->nesting > 0);
+  if (--record->nesting == 0)
+  {
+    record->epoch.store(0, std::memory_order_release);
+  }
+}
+
+void Rcu::synchronize()
+{
+  assert(!t_record || t_record->nesting == 0);
+  // records are never freed, so waited for out of g_mutex, a new reader
+  // registers without waiting for us.
+  std::vector<ThreadRecord*> records;
+  uint64_t target = 0;
+  {
+  MutexLockGuard lock(g_mutex);
+  target = g_epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+  records = g_records;
+  }
+  for (ThreadRecord* record : records)
+  {
+    uint64_t epoch = record->epoch.load(std::memory_order_seq_cst);
+    while (epoch != 0 && epoch < target)
+    {
+      ::sched_yield();
+      epoch = record->epoch.load(std::memory_order_seq_cst);
+    }
+  }
+}
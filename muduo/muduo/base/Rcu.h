@@ -0,0 +1,108 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_RCU_H
+#define MUDUO_BASE_RCU_H
+
+#include <muduo/base/Mutex.h>
+
+#include <atomic>
+#include <memory>
+
+namespace muduo
+{
+
+/** class Rcu
+ * - Brief:
+ *    epoch based read-copy-update, readers of SnapshotPtr only write a
+ *    cache line of their own thread, writers wait for them.
+ *    1) every thread reading has a record, it holds the global epoch seen
+ *       when the outermost read section began, or 0 when not reading.
+ *    2) synchronize() bumps the global epoch and waits till every record is
+ *       0 or newer, so read sections begun before it have ended.
+ *    read sections nest, they must be short and must not block, and must
+ *    not call synchronize() (which deadlocks).
+ */
+class Rcu : noncopyable
+{
+public:
+  static void readLock();
+  static void readUnlock();
+  /// Blocks until all read sections begun before the call have ended.
+  static void synchronize();
+
+  class ReadGuard : noncopyable
+  {
+  public:
+    ReadGuard() { Rcu::readLock(); }
+    ~ReadGuard() { Rcu::readUnlock(); }
+  };
+};
+
+/** class SnapshotPtr
+ * - Brief:
+ *    a read-mostly object replaced as a whole, like the copy-on-write
+ *    shared_ptr idiom guarded by a mutex, but readers take no lock and
+ *    touch no shared reference count:
+ *
+ *      Rcu::ReadGuard guard;
+ *      const Routes* routes = routes_.get();  // valid till guard ends
+ *
+ *    update() publishes a new object, waits for readers of the old one and
+ *    deletes it, so writers are slow, serialized by a mutex.
+ */
+template<typename T>
+class SnapshotPtr : noncopyable
+{
+private:
+  std::atomic<T*> ptr_;
+  MutexLock mutex_;  ///< writers
+
+public:
+  explicit SnapshotPtr(std::unique_ptr<T> init)
+    : ptr_(init.release())
+  {
+  }
+
+  /// No reader must be left.
+  ~SnapshotPtr()
+  {
+    delete ptr_.load(std::memory_order_relaxed);
+  }
+
+  /// Must be called in a read section.
+  const T* get() const
+  {
+    return ptr_.load(std::memory_order_seq_cst);
+  }
+
+  /// Publishes obj, the old one is deleted when readers are gone.
+  void update(std::unique_ptr<T> obj)
+  {
+    MutexLockGuard lock(mutex_);
+    publish(std::move(obj));
+  }
+
+  /// Copy, modify by f(T*), then publish, e.g. insert to a map.
+  template<typename Func>
+  void modify(Func f)
+  {
+    MutexLockGuard lock(mutex_);
+    std::unique_ptr<T> copy(new T(*ptr_.load(std::memory_order_relaxed)));
+    f(copy.get());
+    publish(std::move(copy));
+  }
+
+private:
+  void publish(std::unique_ptr<T> obj)
+  {
+    std::unique_ptr<T> old(ptr_.exchange(obj.release(), std::memory_order_seq_cst));
+    Rcu::synchronize();
+  }
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_RCU_H
@@ -0,0 +1,108 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_SEQLOCK_H
+#define MUDUO_BASE_SEQLOCK_H
+
+#include <muduo/base/Futex.h>
+#include <muduo/base/noncopyable.h>
+
+#include <atomic>
+#include <type_traits>
+
+#include <stdint.h>
+#include <string.h>
+
+namespace muduo
+{
+
+/** class SeqLock
+ * - Brief:
+ *    a small POD read by many threads and written now and then, e.g. a
+ *    config or a clock offset. readers never write, they retry when a write
+ *    was in progress, so a read is a few loads when there is no writer.
+ *    1) seq_ is odd while writing, writers take it by CAS, so they are
+ *       serialized but don't block readers.
+ *    2) value is kept in atomic words, read and written relaxed, so a torn
+ *       read is not a data race, it is discarded by the seq_ check.
+ *    T must be trivially copyable, keep it to a few cache lines.
+ */
+template<typename T>
+class SeqLock : noncopyable
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:
+  static const size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+private:
+  std::atomic<uint32_t> seq_;
+  std::atomic<uint64_t> words_[kWords];
+
+public:
+  SeqLock()
+    : seq_(0)
+  {
+    T value = T();
+    store(value);
+  }
+
+  explicit SeqLock(const T& value)
+    : seq_(0)
+  {
+    store(value);
+  }
+
+  T load() const
+  {
+    uint64_t buf[kWords];
+    uint32_t seq0 = 0;
+    uint32_t seq1 = 0;
+    do
+    {
+      seq0 = seq_.load(std::memory_order_acquire);
+      while (seq0 & 1)
+      {
+        detail::cpuRelax();
+        seq0 = seq_.load(std::memory_order_acquire);
+      }
+      for (size_t i = 0; i < kWords; ++i)
+      {
+        buf[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      seq1 = seq_.load(std::memory_order_relaxed);
+    } while (seq0 != seq1);
+    T value;
+    memcpy(&value, buf, sizeof value);
+    return value;
+  }
+
+  void store(const T& value)
+  {
+    uint64_t buf[kWords] = { 0 };
+    memcpy(buf, &value, sizeof value);
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    while ((seq & 1)
+           || !seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed))
+    {
+      detail::cpuRelax();
+      seq = seq_.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; ++i)
+    {
+      words_[i].store(buf[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /// Number of stores so far, e.g. to tell if value has changed.
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_SEQLOCK_H
@@ -0,0 +1,161 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <muduo/base/ShardedCounter.h>
+
+#include <muduo/base/Mutex.h>
+
+#include <map>
+#include <new>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::detail;
+
+namespace
+{
+
+int initNumShards()
+{
+  long cpus = ::sysconf(_SC_NPROCESSORS_CONF);
+  int shards = 1;
+  while (shards < cpus && shards < 256)
+  {
+    shards *= 2;
+  }
+  return shards;
+}
+
+std::atomic<int> g_nextShard(0);
+
+struct Registry
+{
+  MutexLock mutex;
+  std::multimap<string, const ShardedCells*> cells GUARDED_BY(mutex);
+};
+
+// never destroyed, counters may be global.
+Registry& registry()
+{
+  static Registry* registry = new Registry;
+  return *registry;
+}
+
+}  // namespace
+
+__thread int muduo::detail::t_shardIndex = -1;
+
+int ShardedCells::assignShard()
+{
+  t_shardIndex = g_nextShard.fetch_add(1, std::memory_order_relaxed)
+                 & (ShardedStats::numShards() - 1);
+  return t_shardIndex;
+}
+
+ShardedCells::ShardedCells(const string& name)
+  : name_(name),
+    storage_(new char[(ShardedStats::numShards() + 1) * kCacheLineSize]),
+    cells_(NULL)
+{
+  uintptr_t p = reinterpret_cast<uintptr_t>(storage_.get());
+  p = (p + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+  cells_ = reinterpret_cast<Cell*>(p);
+  for (int i = 0; i < ShardedStats::numShards(); ++i)
+  {
+    new (&cells_[i]) Cell;
+    cells_[i].value.store(0, std::memory_order_relaxed);
+  }
+  if (!name_.empty())
+  {
+    Registry& r = registry();
+    MutexLockGuard lock(r.mutex);
+    r.cells.insert(std::make_pair(name_, this));
+  }
+}
+
+ShardedCells::~ShardedCells()
+{
+  if (!name_.empty())
+  {
+    Registry& r = registry();
+    MutexLockGuard lock(r.mutex);
+    auto range = r.cells.equal_range(name_);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+      if (it->second == this)
+      {
+        r.cells.erase(it);
+        break;
+      }
+    }
+  }
+}
+
+int64_t ShardedCells::value() const
+{
+  int64_t sum = 0;
+  for (int i = 0; i < ShardedStats::numShards(); ++i)
+  {
+    sum += cells_[i].value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+void ShardedCells::reset()
+{
+  for (int i = 0; i < ShardedStats::numShards(); ++i)
+  {
+    cells_[i].value.store(0, std::memory_order_relaxed);
+  }
+}
+
+int ShardedStats::numShards()
+{
+  // function static, counters may be global.
+  static int shards = initNumShards();
+  return shards;
+}
+
+int64_t ShardedStats::value(const string& name)
+{
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  int64_t sum = 0;
+  auto range = r.cells.equal_range(name);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    sum += it->second->value();
+  }
+  return sum;
+}
+
+string ShardedStats::report(StringPiece prefix)
+{
+  string result;
+  Registry& r = registry();
+  MutexLockGuard lock(r.mutex);
+  auto it = r.cells.lower_bound(prefix.as_string());
+  while (it != r.cells.end() && StringPiece(it->first).starts_with(prefix))
+  {
+    const string& name = it->first;
+    int64_t sum = 0;
+    for (; it != r.cells.end() && it->first == name; ++it)
+    {
+      sum += it->second->value();
+    }
+    char buf[32];
+    snprintf(buf, sizeof buf, " %" PRId64 "\n", sum);
+    result += name;
+    result += buf;
+  }
+  return result;
+}
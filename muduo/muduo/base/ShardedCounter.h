@@ -0,0 +1,113 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_SHARDEDCOUNTER_H
+#define MUDUO_BASE_SHARDEDCOUNTER_H
+
+#include <muduo/base/StringPiece.h>
+#include <muduo/base/Types.h>
+#include <muduo/base/noncopyable.h>
+
+#include <atomic>
+#include <memory>
+
+namespace muduo
+{
+
+namespace detail
+{
+
+extern __thread int t_shardIndex;
+
+/** class ShardedCells
+ * - Brief:
+ *    an int64 split into cache line sized cells, one per cpu rounded up to
+ *    power of 2, a thread always adds to the same cell, so threads on
+ *    different cpus don't bounce a cache line. a read sums all cells.
+ *    threads share cells when there are more threads than cells, so adding
+ *    is still an atomic add, but relaxed and uncontended.
+ */
+class ShardedCells : noncopyable
+{
+public:
+  static const size_t kCacheLineSize = 64;
+
+private:
+  struct Cell
+  {
+    std::atomic<int64_t> value;
+    char pad[kCacheLineSize - sizeof(std::atomic<int64_t>)];
+  };
+
+  const string name_;
+  std::unique_ptr<char[]> storage_;
+  Cell* cells_;  ///< aligned in storage_.
+
+protected:
+  explicit ShardedCells(const string& name);
+  ~ShardedCells();
+
+  void add(int64_t x)
+  {
+    int index = t_shardIndex >= 0 ? t_shardIndex : assignShard();
+    cells_[index].value.fetch_add(x, std::memory_order_relaxed);
+  }
+
+public:
+  const string& name() const { return name_; }
+  /// Sum of cells, not a snapshot if being added.
+  int64_t value() const;
+  void reset();
+
+private:
+  static int assignShard();
+};
+
+}  // namespace detail
+
+/// Counts up, e.g. requests.
+class ShardedCounter : public detail::ShardedCells
+{
+public:
+  /// Named ones are shown in ShardedStats::report().
+  explicit ShardedCounter(const string& name = string())
+    : ShardedCells(name)
+  {
+  }
+
+  void increment() { add(1); }
+  void add(int64_t x) { ShardedCells::add(x); }
+};
+
+/// Goes up and down, e.g. connections.
+class ShardedGauge : public detail::ShardedCells
+{
+public:
+  explicit ShardedGauge(const string& name = string())
+    : ShardedCells(name)
+  {
+  }
+
+  void increment() { add(1); }
+  void decrement() { add(-1); }
+  void add(int64_t x) { ShardedCells::add(x); }
+};
+
+/// Named ShardedCounters and ShardedGauges alive, values of same name are
+/// summed, e.g. of connections.
+class ShardedStats : noncopyable
+{
+public:
+  /// Number of cells of a counter.
+  static int numShards();
+  /// Value of name, 0 if not found.
+  static int64_t value(const string& name);
+  /// "name value\n" of names beginning with prefix, sorted.
+  static string report(StringPiece prefix = StringPiece());
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_SHARDEDCOUNTER_H
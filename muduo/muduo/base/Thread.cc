@@ -49,6 +49,42 @@ class ThreadNameInitializer
 
 ThreadNameInitializer init;
 
+struct ThreadRegistry
+{
+  MutexLock mutex;
+  std::map<pid_t, string> names GUARDED_BY(mutex);
+};
+
+// never destroyed, detached threads may outlive main().
+ThreadRegistry& registry()
+{
+  static ThreadRegistry* registry = new ThreadRegistry;
+  return *registry;
+}
+
+// tid is in registry during the lifetime.
+class ThreadRegistration : noncopyable
+{
+ public:
+  explicit ThreadRegistration(const string& name)
+    : tid_(muduo::CurrentThread::tid())
+  {
+    ThreadRegistry& r = registry();
+    MutexLockGuard lock(r.mutex);
+    r.names[tid_] = name;
+  }
+
+  ~ThreadRegistration()
+  {
+    ThreadRegistry& r = registry();
+    MutexLockGuard lock(r.mutex);
+    r.names.erase(tid_);
+  }
+
+ private:
+  const pid_t tid_;
+};
+
 struct ThreadData
 {
   typedef muduo::Thread::ThreadFunc ThreadFunc;
@@ -76,6 +112,7 @@ struct ThreadData
 
     muduo::CurrentThread::t_threadName = name_.empty() ? "muduoThread" : name_.c_str();
     ::prctl(PR_SET_NAME, muduo::CurrentThread::t_threadName);
+    ThreadRegistration registration(muduo::CurrentThread::t_threadName);
     try
     {
       func_();
@@ -197,4 +234,16 @@ int Thread::join()
   return pthread_join(pthreadId_, NULL);
 }
 
+std::map<pid_t, string> Thread::runningThreads()
+{
+  std::map<pid_t, string> result;
+  {
+  detail::ThreadRegistry& r = detail::registry();
+  MutexLockGuard lock(r.mutex);
+  result = r.names;
+  }
+  result[::getpid()] = "main";
+  return result;
+}
+
 }  // namespace muduo
@@ -11,6 +11,7 @@
 #include <muduo/base/Types.h>
 
 #include <functional>
+#include <map>
 #include <memory>
 #include <pthread.h>
 
@@ -45,6 +46,8 @@ public:
   const string& name() const { return name_; }
 
   static int numCreated() { return numCreated_.get(); }
+  /// tid to name of Threads running, and of main thread.
+  static std::map<pid_t, string> runningThreads();
 
 private:
   void setDefaultName();
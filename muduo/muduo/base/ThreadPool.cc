@@ -5,6 +5,7 @@
 
 #include <muduo/base/ThreadPool.h>
 
+#include <muduo/base/CurrentThread.h>
 #include <muduo/base/Exception.h>
 
 #include <assert.h>
@@ -18,7 +19,14 @@ ThreadPool::ThreadPool(const string& nameArg)
     notFull_(mutex_),
     name_(nameArg),
     maxQueueSize_(0),
-    running_(false)
+    running_(false),
+    minThreads_(0),
+    maxThreads_(0),
+    targetQueueDelay_(0.01),
+    idleTimeout_(60.0),
+    numThreads_(0),
+    numIdle_(0),
+    nextThreadId_(0)
 {
 }
 
@@ -43,20 +51,45 @@ void ThreadPool::start(int numThreads)
           std::bind(&ThreadPool::runInThread, this), name_+id));
     threads_[i]->start();
   }
+  numThreads_ = nextThreadId_ = numThreads;
   if (numThreads == 0 && threadInitCallback_)
   {
     threadInitCallback_();
   }
 }
 
+void ThreadPool::startElastic(int minThreads, int maxThreads)
+{
+  assert(threads_.empty());
+  assert(0 <= minThreads && minThreads <= maxThreads && maxThreads > 0);
+  minThreads_ = minThreads;
+  maxThreads_ = maxThreads;
+  running_ = true;
+  for (int i = 0; i < minThreads; ++i)
+  {
+    {
+    MutexLockGuard lock(mutex_);
+    ++numThreads_;
+    }
+    addThread();
+  }
+}
+
 void ThreadPool::stop()
 {
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
   {
   MutexLockGuard lock(mutex_);
   running_ = false;
   notEmpty_.notifyAll();
+  threads.swap(threads_);
+  for (auto& thr : exited_)
+  {
+    threads.push_back(std::move(thr));
   }
-  for (auto& thr : threads_)
+  exited_.clear();
+  }
+  for (auto& thr : threads)
   {
     thr->join();
   }
@@ -68,14 +101,23 @@ size_t ThreadPool::queueSize() const
   return queue_.size();
 }
 
+int ThreadPool::numThreads() const
+{
+  MutexLockGuard lock(mutex_);
+  return numThreads_;
+}
+
 void ThreadPool::run(Task task)
 {
-  if (threads_.empty())
+  if (maxThreads_ == 0 && threads_.empty())
   {
     task();
   }
   else
   {
+    bool grow = false;
+    std::vector<std::unique_ptr<muduo::Thread>> exited;
+    {
     MutexLockGuard lock(mutex_);
     while (isFull())
     {
@@ -83,23 +125,120 @@ void ThreadPool::run(Task task)
     }
     assert(!isFull());
 
-    queue_.push_back(std::move(task));
+    // only elastic mode reads the clock, see shouldGrow().
+    Timestamp now(maxThreads_ > 0 ? Timestamp::now() : Timestamp());
+    queue_.push_back(Entry{std::move(task), now});
     notEmpty_.notify();
+    grow = shouldGrow(now);
+    if (grow)
+    {
+      ++numThreads_;
+    }
+    exited.swap(exited_);
+    }
+
+    for (auto& thr : exited)
+    {
+      thr->join();
+    }
+    if (grow)
+    {
+      addThread();
+    }
+  }
+}
+
+bool ThreadPool::shouldGrow(Timestamp now) const
+{
+  mutex_.assertLocked();
+  if (maxThreads_ == 0 || numThreads_ >= maxThreads_ || numIdle_ > 0
+      || queue_.empty())
+  {
+    return false;
+  }
+  // never leave tasks without thread, even if minThreads_ is 0.
+  return numThreads_ == 0
+      || timeDifference(now, queue_.front().enqueued) > targetQueueDelay_;
+}
+
+void ThreadPool::growIfNeeded()
+{
+  {
+  MutexLockGuard lock(mutex_);
+  if (!shouldGrow(Timestamp::now()))
+  {
+    return;
+  }
+  ++numThreads_;
+  }
+  addThread();
+}
+
+void ThreadPool::addThread()
+{
+  MutexLockGuard lock(mutex_);
+  if (!running_)
+  {
+    --numThreads_;
+    return;
+  }
+  char id[32];
+  snprintf(id, sizeof id, "%d", ++nextThreadId_);
+  threads_.emplace_back(new muduo::Thread(
+        std::bind(&ThreadPool::runInThread, this), name_+id));
+  // new thread blocks on mutex_ in take(), after start() returns.
+  threads_.back()->start();
+}
+
+void ThreadPool::retireCurrentThread()
+{
+  mutex_.assertLocked();
+  for (size_t i = 0; i < threads_.size(); ++i)
+  {
+    if (threads_[i]->tid() == CurrentThread::tid())
+    {
+      exited_.push_back(std::move(threads_[i]));
+      threads_.erase(threads_.begin() + i);
+      --numThreads_;
+      return;
+    }
   }
+  assert(false);
 }
 
-ThreadPool::Task ThreadPool::take()
+ThreadPool::Task ThreadPool::take(bool* retire)
 {
   MutexLockGuard lock(mutex_);
   // always use a while-loop, due to spurious wakeup
   while (queue_.empty() && running_)
   {
-    notEmpty_.wait();
+    if (maxThreads_ > 0)
+    {
+      ++numIdle_;
+      bool timeout = notEmpty_.waitForSeconds(idleTimeout_);
+      --numIdle_;
+      if (timeout && queue_.empty() && running_ && numThreads_ > minThreads_)
+      {
+        retireCurrentThread();
+        *retire = true;
+        return Task();
+      }
+    }
+    else
+    {
+      notEmpty_.wait();
+    }
   }
   Task task;
   if (!queue_.empty())
   {
-    task = queue_.front();
+    Entry& entry = queue_.front();
+    if (maxThreads_ > 0)
+    {
+      queueDelay_.add(Timestamp::now().microSecondsSinceEpoch()
+                      - entry.enqueued.microSecondsSinceEpoch());
+    }
+    task = std::move(entry.task);
     queue_.pop_front();
     if (maxQueueSize_ > 0)
     {
@@ -125,8 +264,25 @@ void ThreadPool::runInThread()
     }
     while (running_)
     {
-      Task task(take()); ///< blocking
-      if (task)
+      bool retire = false;
+      Task task(take(&retire)); ///< blocking
+      if (retire)
+      {
+        break;
+      }
+      if (maxThreads_ > 0)
+      {
+        // tasks behind this one are waiting too long.
+        growIfNeeded();
+      }
+      if (task && maxThreads_ > 0)
+      {
+        Timestamp start(Timestamp::now());
+        task();
+        serviceTime_.add(Timestamp::now().microSecondsSinceEpoch()
+                         - start.microSecondsSinceEpoch());
+      }
+      else if (task)
       {
         task();
       }
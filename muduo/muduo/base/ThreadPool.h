@@ -7,8 +7,10 @@
 #define MUDUO_BASE_THREADPOOL_H
 
 #include <muduo/base/Condition.h>
+#include <muduo/base/Histogram.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
 #include <muduo/base/Types.h>
 
 #include <deque>
@@ -32,6 +34,12 @@ namespace muduo
  *    ThreadPool class is Thread-Safe, but the Thread-Safe of task is controled
  *    by yourself.
  *    ThreadPool object owner maybe block when call run, is that you want?
+ * - Elastic mode:
+ *    startElastic(min, max) starts min threads, run() adds a thread when
+ *    the oldest task has waited longer than targetQueueDelay and no thread
+ *    is idle, a thread exits after idling idleTimeout, down to min.
+ *    queueing delay and service time of every task are in histograms,
+ *    only in elastic mode, start(n) does not read the clock per task.
  */
 
 class ThreadPool : noncopyable
@@ -40,6 +48,12 @@ public:
   typedef std::function<void ()> Task;
 
 private:
+  struct Entry
+  {
+    Task task;
+    Timestamp enqueued; ///< for queueing delay, elastic mode only.
+  };
+
   mutable MutexLock mutex_;
   ///> task deque is not empty, the emphasis is on can do task.
   Condition notEmpty_;
@@ -49,14 +63,29 @@ private:
   ///> every thread who is in pool will call it before do tasks.
   ///> if no thread in pool, pool will call it if it is not null pointer.
   Task threadInitCallback_;
-  std::vector<std::unique_ptr<muduo::Thread>> threads_;
-  std::deque<Task> queue_; ///< tasks queue
+  std::vector<std::unique_ptr<muduo::Thread>> threads_ /*GUARDED_BY(mutex_)*/;
+  std::deque<Entry> queue_; ///< tasks queue
   ///> if is 0 or negative, queue is no restriction,
   ///> otherelse, it mean max tasks count.
   ///> why no use in constant?
   size_t maxQueueSize_;
   bool running_; ///< see start() and stop()
 
+  ///> elastic mode, see startElastic(). maxThreads_ is 0 if not elastic.
+  int minThreads_;
+  int maxThreads_;
+  double targetQueueDelay_; ///< seconds, grow if tasks wait longer.
+  double idleTimeout_;      ///< seconds, shrink if a thread idles longer.
+  int numThreads_ /*GUARDED_BY(mutex_)*/;
+  int numIdle_ /*GUARDED_BY(mutex_)*/;   ///< threads waiting in take().
+  int nextThreadId_ /*GUARDED_BY(mutex_)*/;
+  ///> threads exited in elastic mode, joined later.
+  std::vector<std::unique_ptr<muduo::Thread>> exited_ /*GUARDED_BY(mutex_)*/;
+
+  ///> elastic mode only, empty after start(n).
+  Histogram queueDelay_;  ///< microseconds from run() to start of task.
+  Histogram serviceTime_; ///< microseconds of task running.
+
 public:
   explicit ThreadPool(const string& nameArg = string("ThreadPool"));
   ~ThreadPool();
@@ -67,13 +96,22 @@ public:
   ///> set thread creat by pool or thread pool initialization before do tasks.
   ///> see start() and runInThread().
   void setThreadInitCallback(const Task& cb) { threadInitCallback_ = cb; }
+  ///> see startElastic().
+  void setTargetQueueDelay(double seconds) { targetQueueDelay_ = seconds; }
+  void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
 
   ///> create threads and call initialization(threadInitCallback_).
   void start(int numThreads);
+  ///> start minThreads threads, grow up to maxThreads on demand.
+  void startElastic(int minThreads, int maxThreads);
   void stop();
 
   const string& name() const { return name_; }
   size_t queueSize() const; ///< tasks count
+  int numThreads() const;   ///< current threads count
+
+  const Histogram& queueDelay() const { return queueDelay_; }
+  const Histogram& serviceTime() const { return serviceTime_; }
 
   // Could block if maxQueueSize > 0, because of tasks deque is full,
   // blocking until no full.
@@ -87,7 +125,14 @@ private:
   ///> initialization and do tasks in someone thread create by pool.
   void runInThread();
   ///> take a task from deque, maybe block.
-  Task take();
+  ///> in elastic mode, sets *retire if this thread should exit.
+  Task take(bool* retire);
+  ///> if elastic mode needs one more thread for queue_.
+  bool shouldGrow(Timestamp now) const;
+  void growIfNeeded();
+  void addThread();
+  ///> moves thread of caller from threads_ to exited_.
+  void retireCurrentThread();
 };
 
 }  // namespace muduo
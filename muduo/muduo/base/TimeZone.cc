@@ -8,6 +8,8 @@
 #include <muduo/base/Date.h>
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -27,6 +29,9 @@ const int kSecondsPerDay = 24*60*60;
 namespace detail
 {
 
+// constant initialized, for TimeZones constructed before main().
+std::atomic<int64_t> g_dataId(0);
+
 struct Transition
 {
   time_t gmttime;
@@ -55,14 +60,6 @@ struct Comp
     else
       return lhs.localtime < rhs.localtime;
   }
-
-  bool equal(const Transition& lhs, const Transition& rhs) const
-  {
-    if (compareGmt)
-      return lhs.gmttime == rhs.gmttime;
-    else
-      return lhs.localtime == rhs.localtime;
-  }
 };
 
 struct Localtime
@@ -96,6 +93,11 @@ struct TimeZone::Data
   vector<detail::Localtime> localtimes;
   vector<string> names;
   string abbreviation;
+  const int64_t id;  ///< unique, keys per thread caches
+
+  Data()
+    : id(++detail::g_dataId)
+  { }
 };
 
 namespace muduo
@@ -222,41 +224,93 @@ bool readTimeZoneFile(const char* zonefile, struct TimeZone::Data* data)
   return true;
 }
 
-const Localtime* findLocaltime(const TimeZone::Data& data, Transition sentry, Comp comp)
+// [begin, end) of utc or local seconds, in which all map to local.
+struct Interval
 {
-  const Localtime* local = NULL;
+  int64_t dataId;  // of TimeZone::Data, 0 for none
+  time_t begin;
+  time_t end;
+  const Localtime* local;
+};
 
-  if (data.transitions.empty() || comp(sentry, data.transitions.front()))
+// the local time of the last transition not after sentry.
+void findInterval(const TimeZone::Data& data, Transition sentry, Comp comp,
+                  Interval* interval)
+{
+  interval->dataId = data.id;
+  interval->begin = numeric_limits<time_t>::min();
+  interval->end = numeric_limits<time_t>::max();
+
+  vector<Transition>::const_iterator transI
+      = upper_bound(data.transitions.begin(),
+                    data.transitions.end(),
+                    sentry,
+                    comp);
+  if (transI != data.transitions.end())
+  {
+    interval->end = comp.compareGmt ? transI->gmttime : transI->localtime;
+  }
+  if (transI == data.transitions.begin())
   {
     // FIXME: should be first non dst time zone
-    local = &data.localtimes.front();
+    interval->local = &data.localtimes.front();
   }
   else
   {
-    vector<Transition>::const_iterator transI
-        = lower_bound(data.transitions.begin(),
-                      data.transitions.end(),
-                      sentry,
-                      comp);
-    if (transI != data.transitions.end())
-    {
-      if (!comp.equal(sentry, *transI))
-      {
-        assert(transI != data.transitions.begin());
-        --transI;
-      }
-      local = &data.localtimes[transI->localtimeIdx];
-    }
-    else
-    {
-      // FIXME: use TZ-env
-      local = &data.localtimes[data.transitions.back().localtimeIdx];
-    }
+    // FIXME: use TZ-env after the last one
+    --transI;
+    interval->begin = comp.compareGmt ? transI->gmttime : transI->localtime;
+    interval->local = &data.localtimes[transI->localtimeIdx];
   }
+}
 
-  return local;
+// the same interval as the last call for most timestamps, e.g. of logs,
+// checked with two compares instead of a binary search.
+inline const Localtime* findLocaltime(const TimeZone::Data& data, time_t seconds,
+                                      bool gmt, Interval* cache)
+{
+  if (cache->dataId != data.id
+      || seconds < cache->begin
+      || seconds >= cache->end)
+  {
+    Transition sentry(seconds, seconds, 0);
+    findInterval(data, sentry, Comp(gmt), cache);
+  }
+  return cache->local;
 }
 
+// broken-down time of the last day converted, only time of day changes
+// within it.
+struct DayCache
+{
+  time_t day;
+  struct tm tm;
+  bool valid;
+};
+
+inline void fillLocalTime(time_t localSeconds, DayCache* cache, struct tm* localTime)
+{
+  time_t day = localSeconds / kSecondsPerDay;
+  time_t seconds = localSeconds % kSecondsPerDay;
+  if (seconds < 0)
+  {
+    seconds += kSecondsPerDay;
+    --day;
+  }
+  if (!cache->valid || cache->day != day)
+  {
+    cache->tm = TimeZone::toUtcTime(day * kSecondsPerDay, true);
+    cache->day = day;
+    cache->valid = true;
+  }
+  *localTime = cache->tm;
+  fillHMS(static_cast<unsigned>(seconds), localTime);
+}
+
+__thread Interval t_utcInterval;
+__thread Interval t_localInterval;
+__thread DayCache t_day;
+
 }  // namespace detail
 }  // namespace muduo
 
@@ -280,23 +334,36 @@ TimeZone::TimeZone(int eastOfUtc, const char* name)
 struct tm TimeZone::toLocalTime(time_t seconds) const
 {
   struct tm localTime;
-  memZero(&localTime, sizeof(localTime));
+  toLocalTime(&seconds, 1, &localTime);
+  return localTime;
+}
+
+void TimeZone::toLocalTime(const time_t* seconds, size_t count,
+                           struct tm* localTimes) const
+{
   assert(data_ != NULL);
   const Data& data(*data_);
-
-  detail::Transition sentry(seconds, 0, 0);
-  const detail::Localtime* local = findLocaltime(data, sentry, detail::Comp(true));
-
-  if (local)
+  if (data.localtimes.empty())
   {
-    time_t localSeconds = seconds + local->gmtOffset;
-    ::gmtime_r(&localSeconds, &localTime); // FIXME: fromUtcTime
-    localTime.tm_isdst = local->isDst;
-    localTime.tm_gmtoff = local->gmtOffset;
-    localTime.tm_zone = &data.abbreviation[local->arrbIdx];
+    memZero(localTimes, count * sizeof(struct tm));
+    return;
   }
 
-  return localTime;
+  // copies, the loop does not touch thread locals.
+  detail::Interval interval = detail::t_utcInterval;
+  detail::DayCache day = detail::t_day;
+  for (size_t i = 0; i < count; ++i)
+  {
+    const detail::Localtime* local
+        = detail::findLocaltime(data, seconds[i], true, &interval);
+    struct tm* localTime = &localTimes[i];
+    detail::fillLocalTime(seconds[i] + local->gmtOffset, &day, localTime);
+    localTime->tm_isdst = local->isDst;
+    localTime->tm_gmtoff = local->gmtOffset;
+    localTime->tm_zone = &data.abbreviation[local->arrbIdx];
+  }
+  detail::t_utcInterval = interval;
+  detail::t_day = day;
 }
 
 time_t TimeZone::fromLocalTime(const struct tm& localTm) const
@@ -306,8 +373,8 @@ time_t TimeZone::fromLocalTime(const struct tm& localTm) const
 
   struct tm tmp = localTm;
   time_t seconds = ::timegm(&tmp); // FIXME: toUtcTime
-  detail::Transition sentry(0, seconds, 0);
-  const detail::Localtime* local = findLocaltime(data, sentry, detail::Comp(false));
+  const detail::Localtime* local
+      = detail::findLocaltime(data, seconds, false, &detail::t_localInterval);
   if (localTm.tm_isdst)
   {
     struct tm tryTm = toLocalTime(seconds - local->gmtOffset);
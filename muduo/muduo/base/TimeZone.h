@@ -34,7 +34,14 @@ public:
     return static_cast<bool>(data_);
   }
 
+  // the transition interval and the day of the last call are cached per
+  // thread, so a binary search or a date calculation is only done when the
+  // seconds leave them.
   struct tm toLocalTime(time_t secondsSinceEpoch) const;
+  // toLocalTime() of count seconds, for converting many at once, e.g. of
+  // logs being analyzed, the faster when in time order.
+  void toLocalTime(const time_t* secondsSinceEpoch, size_t count,
+                   struct tm* localTimes) const;
   time_t fromLocalTime(const struct tm&) const;
 
   // gmtime(3)
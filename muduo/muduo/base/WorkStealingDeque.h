@@ -0,0 +1,165 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_WORKSTEALINGDEQUE_H
+#define MUDUO_BASE_WORKSTEALINGDEQUE_H
+
+#include <muduo/base/noncopyable.h>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <assert.h>
+#include <stdint.h>
+
+namespace muduo
+{
+
+/** class WorkStealingDeque
+ * - Brief:
+ *    Chase-Lev deque, see "Correct and Efficient Work-Stealing for Weak
+ *    Memory Models" (Le, Pop, Cohen, Nardelli, PPoPP'13).
+ *    1) owner thread push() and pop() at bottom, LIFO, no atomic RMW unless
+ *       only one element left.
+ *    2) any thread steal() at top, FIFO, one CAS.
+ *    3) the ring grows when full, old rings are kept until destruction,
+ *       since a thief may be still reading it.
+ *    T must be trivially copyable, usually a pointer.
+ */
+template<typename T>
+class WorkStealingDeque : noncopyable
+{
+  static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+private:
+  struct Ring
+  {
+    const int64_t capacity;  ///< power of 2
+    std::unique_ptr<std::atomic<T>[]> items;
+
+    explicit Ring(int64_t cap)
+      : capacity(cap),
+        items(new std::atomic<T>[static_cast<size_t>(cap)])
+    {
+    }
+
+    T get(int64_t i) const
+    { return items[static_cast<size_t>(i & (capacity - 1))].load(std::memory_order_relaxed); }
+
+    void put(int64_t i, T x)
+    { items[static_cast<size_t>(i & (capacity - 1))].store(x, std::memory_order_relaxed); }
+  };
+
+  ///> top_ and bottom_ are on different cache lines, thieves write top_.
+  std::atomic<int64_t> top_;
+  char pad_[64 - sizeof(std::atomic<int64_t>)];
+  std::atomic<int64_t> bottom_;
+  std::atomic<Ring*> ring_;
+  std::vector<std::unique_ptr<Ring>> rings_;  ///< owned by owner thread.
+
+public:
+  explicit WorkStealingDeque(int64_t initialCapacity = 256)
+    : top_(0),
+      bottom_(0)
+  {
+    assert(initialCapacity > 0 && (initialCapacity & (initialCapacity - 1)) == 0);
+    rings_.emplace_back(new Ring(initialCapacity));
+    ring_.store(rings_.back().get(), std::memory_order_relaxed);
+  }
+
+  /// Owner only.
+  void push(T x)
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    Ring* r = ring_.load(std::memory_order_relaxed);
+    if (b - t > r->capacity - 1)
+    {
+      r = grow(r, t, b);
+    }
+    r->put(b, x);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  /// Owner only, returns false if empty.
+  bool pop(T* x)
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    Ring* r = ring_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    bool found = false;
+    if (t <= b)
+    {
+      *x = r->get(b);
+      found = true;
+      if (t == b)
+      {
+        // last one, race with thieves.
+        found = top_.compare_exchange_strong(t, t + 1,
+                                             std::memory_order_seq_cst,
+                                             std::memory_order_relaxed);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    }
+    else
+    {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return found;
+  }
+
+  /// Any thread, returns false if empty or lost race with others.
+  bool steal(T* x)
+  {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t < b)
+    {
+      Ring* r = ring_.load(std::memory_order_acquire);
+      T item = r->get(t);
+      if (top_.compare_exchange_strong(t, t + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+      {
+        *x = item;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Approximate, any thread.
+  size_t size() const
+  {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+  bool empty() const { return size() == 0; }
+
+private:
+  Ring* grow(Ring* old, int64_t t, int64_t b)
+  {
+    rings_.emplace_back(new Ring(old->capacity * 2));
+    Ring* r = rings_.back().get();
+    for (int64_t i = t; i < b; ++i)
+    {
+      r->put(i, old->get(i));
+    }
+    ring_.store(r, std::memory_order_release);
+    return r;
+  }
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGDEQUE_H
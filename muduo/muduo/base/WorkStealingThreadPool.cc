@@ -0,0 +1,457 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/base/WorkStealingThreadPool.h>
+
+#include <muduo/base/Exception.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+namespace
+{
+
+// Worker of current thread, NULL if not a worker.
+__thread void* t_currentWorker = NULL;
+
+const size_t kMaxInjectionBatch = 32;
+
+}  // namespace
+
+struct WorkStealingThreadPool::Worker : noncopyable
+{
+  WorkStealingThreadPool* const pool;
+  WorkStealingDeque<Task*> deque;
+  std::unique_ptr<Thread> thread;
+  uint32_t seed;  ///< xorshift state, for choosing victims.
+
+  ///> parker, see park().
+  MutexLock mutex;
+  Condition cond;
+  bool notified /*GUARDED_BY(mutex)*/;
+
+  Worker(WorkStealingThreadPool* owner, int index)
+    : pool(owner),
+      seed(static_cast<uint32_t>(index) * 2654435761u + 1),
+      cond(mutex),
+      notified(false)
+  {
+  }
+
+  uint32_t random()
+  {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+  }
+
+  void unpark()
+  {
+    MutexLockGuard lock(mutex);
+    notified = true;
+    cond.notify();
+  }
+};
+
+WorkStealingThreadPool::WorkStealingThreadPool(const string& nameArg)
+  : name_(nameArg),
+    mutex_(),
+    notFull_(mutex_),
+    injectionSize_(0),
+    maxQueueSize_(0),
+    numIdle_(0),
+    numSearching_(0),
+    running_(false)
+{
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  if (running_)
+  {
+    stop();
+  }
+}
+
+void WorkStealingThreadPool::start(int numThreads)
+{
+  assert(workers_.empty());
+  running_ = true;
+  workers_.reserve(numThreads);
+  for (int i = 0; i < numThreads; ++i)
+  {
+    workers_.emplace_back(new Worker(this, i));
+  }
+  for (int i = 0; i < numThreads; ++i)
+  {
+    char id[32];
+    snprintf(id, sizeof id, "%d", i+1);
+    Worker* worker = workers_[i].get();
+    worker->thread.reset(new muduo::Thread(
+          std::bind(&WorkStealingThreadPool::runInThread, this, worker), name_+id));
+    worker->thread->start();
+  }
+  if (numThreads == 0 && threadInitCallback_)
+  {
+    threadInitCallback_();
+  }
+}
+
+void WorkStealingThreadPool::stop()
+{
+  running_ = false;
+  {
+  MutexLockGuard lock(mutex_);
+  notFull_.notifyAll();
+  }
+  {
+  MutexLockGuard lock(idleMutex_);
+  for (Worker* worker : idle_)
+  {
+    worker->unpark();
+  }
+  idle_.clear();
+  numIdle_ = 0;
+  }
+  for (auto& worker : workers_)
+  {
+    worker->thread->join();
+  }
+
+  // drop tasks not yet run
+  for (auto& worker : workers_)
+  {
+    Task* task = NULL;
+    while (worker->deque.steal(&task))
+    {
+      delete task;
+    }
+  }
+  MutexLockGuard lock(mutex_);
+  for (Task* task : injection_)
+  {
+    delete task;
+  }
+  injection_.clear();
+  injectionSize_ = 0;
+}
+
+size_t WorkStealingThreadPool::queueSize() const
+{
+  size_t size = injectionSize_.load(std::memory_order_relaxed);
+  for (const auto& worker : workers_)
+  {
+    size += worker->deque.size();
+  }
+  return size;
+}
+
+void WorkStealingThreadPool::run(Task task)
+{
+  if (workers_.empty())
+  {
+    task();
+    return;
+  }
+
+  Worker* self = currentWorker();
+  if (self)
+  {
+    self->deque.push(new Task(std::move(task)));
+  }
+  else
+  {
+    MutexLockGuard lock(mutex_);
+    while (maxQueueSize_ > 0 && injection_.size() >= maxQueueSize_ && running_)
+    {
+      notFull_.wait();
+    }
+    injection_.push_back(new Task(std::move(task)));
+    injectionSize_.fetch_add(1, std::memory_order_relaxed);
+  }
+  notify(1);
+}
+
+void WorkStealingThreadPool::runBatch(std::vector<Task>* tasks)
+{
+  if (workers_.empty())
+  {
+    for (Task& task : *tasks)
+    {
+      task();
+    }
+    tasks->clear();
+    return;
+  }
+
+  size_t n = tasks->size();
+  Worker* self = currentWorker();
+  if (self)
+  {
+    for (Task& task : *tasks)
+    {
+      self->deque.push(new Task(std::move(task)));
+    }
+    notify(n);
+  }
+  else
+  {
+    // as much as maxQueueSize_ allows at a time, workers drain in between.
+    size_t i = 0;
+    while (i < n)
+    {
+      size_t count = n - i;
+      {
+      MutexLockGuard lock(mutex_);
+      while (maxQueueSize_ > 0 && injection_.size() >= maxQueueSize_ && running_)
+      {
+        notFull_.wait();
+      }
+      if (maxQueueSize_ > 0 && injection_.size() < maxQueueSize_)
+      {
+        count = std::min(count, maxQueueSize_ - injection_.size());
+      }
+      for (size_t j = i; j < i + count; ++j)
+      {
+        injection_.push_back(new Task(std::move((*tasks)[j])));
+      }
+      injectionSize_.fetch_add(count, std::memory_order_relaxed);
+      }
+      i += count;
+      notify(count);
+    }
+  }
+  tasks->clear();
+}
+
+void WorkStealingThreadPool::notify(size_t numTasks)
+{
+  // pairs with the fence in park(), either we see the searching (or idle)
+  // worker, or it sees the new task.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  // a searching worker will find the task, and wake the next one if there
+  // are more, so no thundering herd for a single task.
+  if (numTasks == 1 && numSearching_.load() > 0)
+  {
+    return;
+  }
+  if (numIdle_.load() == 0)
+  {
+    return;
+  }
+
+  MutexLockGuard lock(idleMutex_);
+  while (numTasks > 0 && !idle_.empty())
+  {
+    Worker* worker = idle_.back();
+    idle_.pop_back();
+    --numIdle_;
+    ++numSearching_;
+    worker->unpark();
+    --numTasks;
+  }
+}
+
+bool WorkStealingThreadPool::hasTask() const
+{
+  if (injectionSize_.load() > 0)
+  {
+    return true;
+  }
+  for (const auto& worker : workers_)
+  {
+    if (!worker->deque.empty())
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+WorkStealingThreadPool::Worker* WorkStealingThreadPool::currentWorker() const
+{
+  Worker* worker = static_cast<Worker*>(t_currentWorker);
+  return worker && worker->pool == this ? worker : NULL;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::findTask(Worker* self)
+{
+  Task* task = NULL;
+  if (self->deque.pop(&task))
+  {
+    return task;
+  }
+  if (injectionSize_.load(std::memory_order_relaxed) > 0)
+  {
+    task = takeInjection(self);
+    if (task)
+    {
+      return task;
+    }
+  }
+  return stealFrom(self);
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::takeInjection(Worker* self)
+{
+  Task* task = NULL;
+  size_t moved = 0;
+  {
+  MutexLockGuard lock(mutex_);
+  if (injection_.empty())
+  {
+    return NULL;
+  }
+  // fair share of the injection queue, the rest is for other workers.
+  size_t n = std::min(injection_.size() / workers_.size() + 1, kMaxInjectionBatch);
+  n = std::min(n, injection_.size());
+  task = injection_.front();
+  injection_.pop_front();
+  for (moved = 1; moved < n; ++moved)
+  {
+    self->deque.push(injection_.front());
+    injection_.pop_front();
+  }
+  injectionSize_.fetch_sub(moved, std::memory_order_relaxed);
+  if (maxQueueSize_ > 0)
+  {
+    notFull_.notifyAll();
+  }
+  }
+  if (moved > 1)
+  {
+    notify(1);
+  }
+  return task;
+}
+
+WorkStealingThreadPool::Task* WorkStealingThreadPool::stealFrom(Worker* self)
+{
+  size_t n = workers_.size();
+  size_t start = self->random() % n;
+  Task* task = NULL;
+  for (size_t i = 0; i < n; ++i)
+  {
+    Worker* victim = workers_[(start + i) % n].get();
+    if (victim == self)
+    {
+      continue;
+    }
+    // steal() fails on contention too, retry while victim has tasks.
+    while (!victim->deque.empty())
+    {
+      if (victim->deque.steal(&task))
+      {
+        return task;
+      }
+    }
+  }
+  return NULL;
+}
+
+void WorkStealingThreadPool::park(Worker* self, bool* searching)
+{
+  {
+  MutexLockGuard lock(idleMutex_);
+  idle_.push_back(self);
+  ++numIdle_;
+  }
+  if (*searching)
+  {
+    --numSearching_;
+    *searching = false;
+  }
+
+  // pairs with the fence in notify().
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (hasTask() || !running_)
+  {
+    MutexLockGuard lock(idleMutex_);
+    std::vector<Worker*>::iterator it = std::find(idle_.begin(), idle_.end(), self);
+    if (it != idle_.end())
+    {
+      idle_.erase(it);
+      --numIdle_;
+      ++numSearching_;
+      *searching = true;
+      return;
+    }
+    // otherwise somebody is waking us up.
+  }
+
+  {
+  MutexLockGuard lock(self->mutex);
+  while (!self->notified)
+  {
+    self->cond.wait();
+  }
+  self->notified = false;
+  }
+  // the waker counted us in numSearching_.
+  *searching = true;
+}
+
+void WorkStealingThreadPool::runInThread(Worker* self)
+{
+  t_currentWorker = self;
+  try
+  {
+    if (threadInitCallback_)
+    {
+      threadInitCallback_();
+    }
+    bool searching = false;
+    while (running_)
+    {
+      Task* task = findTask(self);
+      if (task)
+      {
+        if (searching)
+        {
+          searching = false;
+          // last searcher found work, let another one look for the rest.
+          if (numSearching_.fetch_sub(1) == 1 && hasTask())
+          {
+            notify(1);
+          }
+        }
+        (*task)();
+        delete task;
+      }
+      else
+      {
+        park(self, &searching);
+      }
+    }
+    if (searching)
+    {
+      --numSearching_;
+    }
+  }
+  catch (const Exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+    abort();
+  }
+  catch (const std::exception& ex)
+  {
+    fprintf(stderr, "exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    fprintf(stderr, "reason: %s\n", ex.what());
+    abort();
+  }
+  catch (...)
+  {
+    fprintf(stderr, "unknown exception caught in WorkStealingThreadPool %s\n", name_.c_str());
+    throw; // rethrow
+  }
+  t_currentWorker = NULL;
+}
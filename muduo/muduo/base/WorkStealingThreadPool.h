@@ -0,0 +1,94 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+#define MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
+
+#include <muduo/base/Condition.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Types.h>
+#include <muduo/base/WorkStealingDeque.h>
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+namespace muduo
+{
+
+/** class WorkStealingThreadPool
+ * - Brief:
+ *    same interface as ThreadPool, for many workers and tiny tasks.
+ *    1) every worker has a WorkStealingDeque, tasks run() by a worker go
+ *       to its own deque, idle workers steal from others.
+ *    2) tasks run() by other threads go to the injection queue, workers
+ *       move them to own deque in batches, one lock per batch.
+ *    3) idle workers park on their own condition, at most one worker is
+ *       woken per run(), and only if no worker is searching for tasks;
+ *       a searching worker which finds a task wakes the next one.
+ *    4) runBatch() queues many tasks with one lock.
+ */
+class WorkStealingThreadPool : noncopyable
+{
+public:
+  typedef std::function<void ()> Task;
+
+private:
+  struct Worker;
+
+  string name_;
+  Task threadInitCallback_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  mutable MutexLock mutex_;
+  Condition notFull_;
+  std::deque<Task*> injection_ /*GUARDED_BY(mutex_)*/;
+  std::atomic<size_t> injectionSize_;  ///< readable without mutex_.
+  size_t maxQueueSize_; ///< limits injection queue only, 0 is unlimited.
+
+  ///> parked workers, LIFO, so hot workers are woken first.
+  MutexLock idleMutex_;
+  std::vector<Worker*> idle_ /*GUARDED_BY(idleMutex_)*/;
+  std::atomic<int> numIdle_;
+  std::atomic<int> numSearching_;
+  std::atomic<bool> running_;
+
+public:
+  explicit WorkStealingThreadPool(const string& nameArg = string("WorkStealingThreadPool"));
+  ~WorkStealingThreadPool();
+
+  // Must be called before start().
+  void setMaxQueueSize(int maxSize) { maxQueueSize_ = maxSize; }
+  void setThreadInitCallback(const Task& cb) { threadInitCallback_ = cb; }
+
+  void start(int numThreads);
+  /// Tasks not yet run are dropped, as ThreadPool::stop() does.
+  void stop();
+
+  const string& name() const { return name_; }
+  /// Approximate number of tasks not yet run.
+  size_t queueSize() const;
+
+  /// Could block if maxQueueSize > 0 and called from non-worker thread.
+  void run(Task f);
+  /// Queues all tasks, wakes at most one worker per task.
+  /// Could block as run() does, tasks are queued maxQueueSize at a time.
+  void runBatch(std::vector<Task>* tasks);
+
+private:
+  void runInThread(Worker* self);
+  Task* findTask(Worker* self);
+  Task* takeInjection(Worker* self);
+  Task* stealFrom(Worker* self);
+  void park(Worker* self, bool* searching);
+  void notify(size_t numTasks);
+  bool hasTask() const;
+  Worker* currentWorker() const;
+};
+
+}  // namespace muduo
+
+#endif  // MUDUO_BASE_WORKSTEALINGTHREADPOOL_H
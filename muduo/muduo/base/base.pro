@@ -12,6 +12,7 @@ DESTDIR = $$PWD/../../bin
 HEADERS += \
     AsyncLogging.h \
     Atomic.h \
+    BinaryLogging.h \
     BlockingQueue.h \
     BoundedBlockingQueue.h \
     Condition.h \
@@ -21,13 +22,26 @@ HEADERS += \
     Date.h \
     Exception.h \
     FileUtil.h \
+    Futex.h \
+    FutexBlockingQueue.h \
+    InlineFunction.h \
     GzipFile.h \
+    Histogram.h \
+    KeyValueLogging.h \
+    LockProfiler.h \
+    LockFreeQueue.h \
     LogFile.h \
     Logging.h \
     LogStream.h \
+    MappedRingLog.h \
     Mutex.h \
     noncopyable.h \
+    ObjectPool.h \
+    ParallelGzipFile.h \
     ProcessInfo.h \
+    Rcu.h \
+    SeqLock.h \
+    ShardedCounter.h \
     Singleton.h \
     StringPiece.h \
     Thread.h \
@@ -37,21 +51,33 @@ HEADERS += \
     Timestamp.h \
     TimeZone.h \
     Types.h \
-    WeakCallback.h
+    WeakCallback.h \
+    WorkStealingDeque.h \
+    WorkStealingThreadPool.h
 
 SOURCES += \
     AsyncLogging.cc \
+    BinaryLogging.cc \
     Condition.cc \
     CountDownLatch.cc \
     CurrentThread.cc \
     Date.cc \
     Exception.cc \
     FileUtil.cc \
+    Futex.cc \
+    Histogram.cc \
+    KeyValueLogging.cc \
+    LockProfiler.cc \
     LogFile.cc \
     Logging.cc \
     LogStream.cc \
+    MappedRingLog.cc \
+    ParallelGzipFile.cc \
     ProcessInfo.cc \
+    Rcu.cc \
+    ShardedCounter.cc \
     Thread.cc \
     ThreadPool.cc \
     Timestamp.cc \
-    TimeZone.cc
+    TimeZone.cc \
+    WorkStealingThreadPool.cc
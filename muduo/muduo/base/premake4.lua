@@ -8,17 +8,27 @@ project "base"
     headers('*.h')
     files {
             'AsyncLogging.cc',
+            'BinaryLogging.cc',
             'Condition.cc',
             'CountDownLatch.cc',
             'Date.cc',
             'Exception.cc',
             'FileUtil.cc',
+            'Futex.cc',
+            'Histogram.cc',
+            'KeyValueLogging.cc',
+            'LockProfiler.cc',
             'LogFile.cc',
             'Logging.cc',
             'LogStream.cc',
+            'MappedRingLog.cc',
+            'ParallelGzipFile.cc',
             'ProcessInfo.cc',
+            'Rcu.cc',
+            'ShardedCounter.cc',
             'Timestamp.cc',
             'TimeZone.cc',
             'Thread.cc',
             'ThreadPool.cc',
+            'WorkStealingThreadPool.cc',
      }
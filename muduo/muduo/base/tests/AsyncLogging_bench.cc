@@ -0,0 +1,101 @@
+#include <muduo/base/AsyncLogging.h>
+#include <muduo/base/BinaryLogging.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Histogram.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+off_t kRollSize = 500*1000*1000;
+
+muduo::AsyncLogging* g_asyncLog = NULL;
+muduo::Histogram g_latency;
+bool g_binary = false;
+
+void asyncOutput(const char* msg, int len)
+{
+  g_asyncLog->append(msg, len);
+}
+
+void asyncBinaryOutput(const char* record, int len)
+{
+  g_asyncLog->appendBinary(record, len);
+}
+
+// every thread logs numLines at INFO as fast as it can,
+// latency is of each LOG_INFO statement, in microseconds.
+void threadFunc(muduo::CountDownLatch* latch, int numLines)
+{
+  latch->countDown();
+  latch->wait();
+  for (int i = 0; i < numLines; ++i)
+  {
+    muduo::Timestamp start(muduo::Timestamp::now());
+    if (g_binary)
+    {
+      LOG_BIN_INFO("Hello 0123456789 abcdefghijklmnopqrstuvwxyz %d", i);
+    }
+    else
+    {
+      LOG_INFO << "Hello 0123456789" << " abcdefghijklmnopqrstuvwxyz " << i;
+    }
+    muduo::Timestamp end(muduo::Timestamp::now());
+    g_latency.add(end.microSecondsSinceEpoch() - start.microSecondsSinceEpoch());
+  }
+}
+
+// usage: asynclogging_bench [threads [lines_per_thread [text|deferred|binary]]]
+// deferred and binary log with LOG_BIN_INFO.
+int main(int argc, char* argv[])
+{
+  int numThreads = argc > 1 ? atoi(argv[1]) : 4;
+  int numLines = argc > 2 ? atoi(argv[2]) : 1000*1000 / numThreads;
+  const char* mode = argc > 3 ? argv[3] : "text";
+
+  char name[256] = { 0 };
+  strncpy(name, argv[0], sizeof name - 1);
+  muduo::AsyncLogging log(::basename(name), "", kRollSize);
+  if (strcmp(mode, "deferred") == 0)
+  {
+    log.setMode(muduo::AsyncLogging::kDeferred);
+    g_binary = true;
+  }
+  else if (strcmp(mode, "binary") == 0)
+  {
+    log.setMode(muduo::AsyncLogging::kBinary);
+    g_binary = true;
+  }
+  log.start();
+  g_asyncLog = &log;
+  muduo::Logger::setOutput(asyncOutput);
+  muduo::BinaryLogger::setOutput(asyncBinaryOutput);
+
+  muduo::CountDownLatch latch(numThreads);
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  for (int i = 0; i < numThreads; ++i)
+  {
+    threads.emplace_back(new muduo::Thread(
+          std::bind(threadFunc, &latch, numLines)));
+  }
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (auto& thr : threads)
+  {
+    thr->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  double seconds = timeDifference(muduo::Timestamp::now(), start);
+  log.stop();
+
+  printf("%s threads %d lines %d: %.0f lines/s\n", mode, numThreads, numThreads * numLines,
+         numThreads * numLines / seconds);
+  printf("latency %s\n", g_latency.toString().c_str());
+}
@@ -55,7 +55,7 @@ int main(int argc, char* argv[])
 
   char name[256] = { 0 };
   strncpy(name, argv[0], sizeof name - 1);
-  muduo::AsyncLogging log(::basename(name), kRollSize);
+  muduo::AsyncLogging log(::basename(name), "", kRollSize);
   log.start();
   g_asyncLog = &log;
 
@@ -0,0 +1,174 @@
+#include <muduo/base/BinaryLogging.h>
+
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::BinaryLogDecoder;
+using muduo::BinaryLogger;
+using muduo::string;
+
+std::vector<string> g_records;
+
+void captureOutput(const char* record, int len)
+{
+  g_records.push_back(string(record, len));
+}
+
+// text between level name and " - file:line"
+string message(const string& line)
+{
+  size_t begin = line.find("INFO  ");
+  size_t end = line.rfind(" - ");
+  assert(begin != string::npos && end != string::npos);
+  return line.substr(begin + 6, end - begin - 6);
+}
+
+string lastMessage()
+{
+  assert(!g_records.empty());
+  string line;
+  BinaryLogger::formatRecord(g_records.back().data(),
+                             static_cast<int>(g_records.back().size()), &line);
+  printf("%s", line.c_str());
+  assert(line.find(" - BinaryLogging_unittest.cc:") != string::npos);
+  assert(line[line.size() - 1] == '\n');
+  return message(line);
+}
+
+void testFormat()
+{
+  LOG_BIN_INFO("hello");
+  assert(lastMessage() == "hello");
+
+  LOG_BIN_INFO("int %d, unsigned %u, long %ld, hex %#x, neg %5d|", 42, 7u, -1L, 255, -3);
+  assert(lastMessage() == "int 42, unsigned 7, long -1, hex 0xff, neg    -3|");
+
+  LOG_BIN_INFO("double %.3f %g, char %c, 100%%", 3.14159, 0.5, 'x');
+  assert(lastMessage() == "double 3.142 0.5, char x, 100%");
+
+  string s("world");
+  muduo::StringPiece piece("piece");
+  LOG_BIN_INFO("%s %s %-6s| %.2s", "hello", s, piece, "abcdef");
+  assert(lastMessage() == "hello world piece | ab");
+
+  const char* nullString = NULL;
+  LOG_BIN_INFO("null %s", nullString);
+  assert(lastMessage() == "null ");
+
+  muduo::Timestamp t(1234567890123456);
+  LOG_BIN_INFO("at %s", t);
+  assert(lastMessage() == "at " + t.toFormattedString());
+}
+
+void testMismatch()
+{
+  // types come from the record, wrong conversions still print the value.
+  LOG_BIN_INFO("%s and %d", 42, "str");
+  assert(lastMessage() == "42 and str");
+
+  LOG_BIN_INFO("missing %d %s", 1);
+  assert(lastMessage() == "missing 1 %s");
+
+  LOG_BIN_INFO("extra %d", 1, 2, "three");
+  assert(lastMessage() == "extra 1 2 three");
+
+  LOG_BIN_INFO("star %*d %n", 1, 2);
+  assert(lastMessage() == "star %*d %n 1 2");
+
+  LOG_BIN_INFO("trailing %");
+  assert(lastMessage() == "trailing %");
+}
+
+void testTruncate()
+{
+  string big(2 * BinaryLogger::kMaxRecordSize, 'x');
+  LOG_BIN_INFO("%s %d", big, 1);
+  assert(g_records.back().size() <= static_cast<size_t>(BinaryLogger::kMaxRecordSize));
+  string msg = lastMessage();
+  assert(msg.size() < static_cast<size_t>(BinaryLogger::kMaxRecordSize));
+  assert(msg.substr(msg.size() - 3) == " %d");
+}
+
+// a framed stream, as AsyncLogging writes it in kBinary mode.
+void testStream()
+{
+  g_records.clear();
+  for (int i = 0; i < 3; ++i)
+  {
+    LOG_BIN_INFO("loop %d", i);
+  }
+  LOG_BIN_INFO("done");
+
+  string stream;
+  std::vector<bool> sitesWritten;
+  for (const string& record : g_records)
+  {
+    uint32_t id = 0;
+    memcpy(&id, record.data(), sizeof id);
+    if (id >= sitesWritten.size() || !sitesWritten[id])
+    {
+      BinaryLogger::appendSiteEntry(*BinaryLogger::site(id), &stream);
+      sitesWritten.resize(std::max<size_t>(sitesWritten.size(), id + 1));
+      sitesWritten[id] = true;
+    }
+    char header[BinaryLogger::kEntryHeaderSize];
+    BinaryLogger::makeEntryHeader(BinaryLogger::kRecordEntry, record.size(), header);
+    stream.append(header, sizeof header);
+    stream.append(record);
+  }
+  string text("plain text line\n");
+  char header[BinaryLogger::kEntryHeaderSize];
+  BinaryLogger::makeEntryHeader(BinaryLogger::kTextEntry, text.size(), header);
+  stream.append(header, sizeof header);
+  stream.append(text);
+
+  // offline, sites come from the stream only.
+  BinaryLogDecoder decoder(false);
+  string out;
+  assert(decoder.decodeEntry(stream.data(), 3, &out) == 0);
+  const char* p = stream.data();
+  const char* end = p + stream.size();
+  while (p < end)
+  {
+    // incomplete entry asks for more.
+    assert(decoder.decodeEntry(p, 6, &out) == 0);
+    int n = decoder.decodeEntry(p, static_cast<size_t>(end - p), &out);
+    assert(n > 0);
+    p += n;
+  }
+  printf("%s", out.c_str());
+  assert(out.find("loop 0 - BinaryLogging_unittest.cc:") != string::npos);
+  assert(out.find("loop 2 - BinaryLogging_unittest.cc:") != string::npos);
+  assert(out.find("done - BinaryLogging_unittest.cc:") != string::npos);
+  assert(out.find("plain text line\n") == out.size() - text.size());
+
+  string corrupt("X\0\0\0\0", 5);
+  assert(decoder.decodeEntry(corrupt.data(), corrupt.size(), &out) == -1);
+
+  // without site entries, records can not be decoded.
+  BinaryLogDecoder another(false);
+  string record;
+  BinaryLogger::makeEntryHeader(BinaryLogger::kRecordEntry, g_records[0].size(), header);
+  record.append(header, sizeof header);
+  record.append(g_records[0]);
+  out.clear();
+  int n = another.decodeEntry(record.data(), record.size(), &out);
+  printf("%d %s", n, out.c_str());
+  assert(n == static_cast<int>(record.size()));
+  assert(out == "corrupt binary log record\n");
+}
+
+int main()
+{
+  // default output formats at once to Logger's output.
+  LOG_BIN_INFO("default output %d", 1);
+
+  BinaryLogger::setOutput(captureOutput);
+  testFormat();
+  testMismatch();
+  testTruncate();
+  testStream();
+}
@@ -1,106 +1,146 @@
 #include <muduo/base/BlockingQueue.h>
+#include <muduo/base/BoundedBlockingQueue.h>
 #include <muduo/base/CountDownLatch.h>
+#include <muduo/base/FutexBlockingQueue.h>
+#include <muduo/base/Histogram.h>
+#include <muduo/base/LockFreeQueue.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/Timestamp.h>
 
-#include <map>
 #include <string>
 #include <vector>
 #include <stdio.h>
 #include <unistd.h>
 
+const size_t kCapacity = 1024;
+
+// Measures hop latency (put to take) and throughput of Queue,
+// with numConsumers taking and numProducers putting.
+template<typename Queue>
 class Bench
 {
  public:
-  Bench(int numThreads)
-    : latch_(numThreads)
+  Bench(const char* name, Queue* queue, int numConsumers, int numProducers)
+    : name_(name),
+      queue_(queue),
+      latch_(numConsumers),
+      numProducers_(numProducers)
   {
-    threads_.reserve(numThreads);
-    for (int i = 0; i < numThreads; ++i)
+    consumers_.reserve(numConsumers);
+    for (int i = 0; i < numConsumers; ++i)
     {
-      char name[32];
-      snprintf(name, sizeof name, "work thread %d", i);
-      threads_.emplace_back(new muduo::Thread(
-            std::bind(&Bench::threadFunc, this), muduo::string(name)));
+      char threadName[32];
+      snprintf(threadName, sizeof threadName, "consumer %d", i);
+      consumers_.emplace_back(new muduo::Thread(
+            std::bind(&Bench::consume, this), muduo::string(threadName)));
     }
-    for (auto& thr : threads_)
+    for (auto& thr : consumers_)
     {
       thr->start();
     }
   }
 
-  void run(int times)
+  void run(int times, int intervalUs)
   {
-    printf("waiting for count down latch\n");
     latch_.wait();
-    printf("all threads started\n");
-    for (int i = 0; i < times; ++i)
+    muduo::Timestamp start(muduo::Timestamp::now());
+    std::vector<std::unique_ptr<muduo::Thread>> producers;
+    for (int i = 0; i < numProducers_; ++i)
     {
-      muduo::Timestamp now(muduo::Timestamp::now());
-      queue_.put(now);
-      usleep(1000);
+      char threadName[32];
+      snprintf(threadName, sizeof threadName, "producer %d", i);
+      producers.emplace_back(new muduo::Thread(
+            std::bind(&Bench::produce, this, times, intervalUs),
+            muduo::string(threadName)));
+      producers.back()->start();
     }
-  }
-
-  void joinAll()
-  {
-    for (size_t i = 0; i < threads_.size(); ++i)
+    for (auto& thr : producers)
     {
-      queue_.put(muduo::Timestamp::invalid());
+      thr->join();
     }
 
-    for (auto& thr : threads_)
+    for (size_t i = 0; i < consumers_.size(); ++i)
+    {
+      queue_->put(muduo::Timestamp::invalid());
+    }
+    for (auto& thr : consumers_)
     {
       thr->join();
     }
+    double seconds = timeDifference(muduo::Timestamp::now(), start);
+    printf("%-28s %10.0f items/s  %s\n", name_,
+           static_cast<double>(delays_.count()) / seconds,
+           delays_.toString().c_str());
   }
 
  private:
 
-  void threadFunc()
+  void produce(int times, int intervalUs)
   {
-    printf("tid=%d, %s started\n",
-           muduo::CurrentThread::tid(),
-           muduo::CurrentThread::name());
+    for (int i = 0; i < times; ++i)
+    {
+      queue_->put(muduo::Timestamp::now());
+      if (intervalUs > 0)
+      {
+        usleep(intervalUs);
+      }
+    }
+  }
 
-    std::map<int, int> delays;
+  void consume()
+  {
     latch_.countDown();
     bool running = true;
     while (running)
     {
-      muduo::Timestamp t(queue_.take());
-      muduo::Timestamp now(muduo::Timestamp::now());
+      muduo::Timestamp t(queue_->take());
       if (t.valid())
       {
-        int delay = static_cast<int>(timeDifference(now, t) * 1000000);
-        // printf("tid=%d, latency = %d us\n",
-        //        muduo::CurrentThread::tid(), delay);
-        ++delays[delay];
+        muduo::Timestamp now(muduo::Timestamp::now());
+        delays_.add(now.microSecondsSinceEpoch() - t.microSecondsSinceEpoch());
       }
       running = t.valid();
     }
-
-    printf("tid=%d, %s stopped\n",
-           muduo::CurrentThread::tid(),
-           muduo::CurrentThread::name());
-    for (const auto& delay : delays)
-    {
-      printf("tid = %d, delay = %d, count = %d\n",
-             muduo::CurrentThread::tid(),
-             delay.first, delay.second);
-    }
   }
 
-  muduo::BlockingQueue<muduo::Timestamp> queue_;
+  const char* name_;
+  std::unique_ptr<Queue> queue_;
   muduo::CountDownLatch latch_;
-  std::vector<std::unique_ptr<muduo::Thread>> threads_;
+  const int numProducers_;
+  std::vector<std::unique_ptr<muduo::Thread>> consumers_;
+  muduo::Histogram delays_;
 };
 
+template<typename Queue>
+void bench(const char* name, Queue* queue, int consumers, int producers, int times, int intervalUs)
+{
+  Bench<Queue> b(name, queue, consumers, producers);
+  b.run(times, intervalUs);
+}
+
+// usage: blockingqueue_bench [consumers [producers [interval_us]]]
+// interval_us = 0 puts as fast as possible, for throughput.
 int main(int argc, char* argv[])
 {
-  int threads = argc > 1 ? atoi(argv[1]) : 1;
+  using muduo::Timestamp;
+  int consumers = argc > 1 ? atoi(argv[1]) : 1;
+  int producers = argc > 2 ? atoi(argv[2]) : 1;
+  int intervalUs = argc > 3 ? atoi(argv[3]) : 1000;
+  int times = intervalUs > 0 ? 10000 : 1000000 / producers;
+  printf("consumers %d producers %d interval %dus, %d items per producer\n",
+         consumers, producers, intervalUs, times);
 
-  Bench t(threads);
-  t.run(10000);
-  t.joinAll();
+  bench("BlockingQueue", new muduo::BlockingQueue<Timestamp>,
+        consumers, producers, times, intervalUs);
+  bench("BoundedBlockingQueue", new muduo::BoundedBlockingQueue<Timestamp>(kCapacity),
+        consumers, producers, times, intervalUs);
+  if (consumers == 1 && producers == 1)
+  {
+    typedef muduo::FutexBlockingQueue<muduo::SpscQueue<Timestamp>> SpscBlockingQueue;
+    bench("FutexBlockingQueue<Spsc>", new SpscBlockingQueue(kCapacity),
+          consumers, producers, times, intervalUs);
+  }
+  typedef muduo::FutexBlockingQueue<muduo::MpmcQueue<Timestamp>> MpmcBlockingQueue;
+  bench("FutexBlockingQueue<Mpmc>", new MpmcBlockingQueue(kCapacity),
+        consumers, producers, times, intervalUs);
 }
@@ -0,0 +1,127 @@
+#include <muduo/base/Futex.h>
+#include <muduo/base/Thread.h>
+
+#include <atomic>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+const int kThreads = 4;
+const int kCount = 100*1000;
+
+FutexSemaphore g_items;
+std::atomic<int> g_consumed(0);
+
+void consume()
+{
+  for (int i = 0; i < kCount; ++i)
+  {
+    g_items.wait();
+    g_consumed.fetch_add(1);
+  }
+}
+
+FutexLatch g_latch(kThreads);
+FutexLatch g_go(1);
+
+void arrive()
+{
+  g_go.wait();
+  g_latch.countDown();
+}
+
+FutexEvent g_event;
+std::atomic<int> g_value(0);
+
+// waits for every value from 1 to kCount.
+void watch()
+{
+  int expected = 1;
+  while (expected <= kCount)
+  {
+    int32_t key = g_event.prepareWait();
+    int value = g_value.load();
+    if (value >= expected)
+    {
+      g_event.cancelWait();
+      expected = value + 1;
+    }
+    else
+    {
+      g_event.wait(key);
+    }
+  }
+}
+
+void testSemaphore()
+{
+  FutexSemaphore sem(2);
+  assert(sem.tryWait());
+  sem.wait();
+  assert(!sem.tryWait());
+  sem.post(3);
+  assert(sem.getCount() == 3);
+
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new Thread(consume));
+    threads.back()->start();
+  }
+  for (int i = 0; i < kThreads * kCount; ++i)
+  {
+    g_items.post();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  assert(g_consumed.load() == kThreads * kCount);
+  assert(g_items.getCount() == 0);
+}
+
+void testLatch()
+{
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new Thread(arrive));
+    threads.back()->start();
+  }
+  // let them park.
+  usleep(100*1000);
+  assert(g_latch.getCount() == kThreads);
+  g_go.countDown();
+  g_latch.wait();
+  assert(g_latch.getCount() == 0);
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  // already open.
+  g_latch.wait();
+}
+
+void testEvent()
+{
+  Thread thr(watch);
+  thr.start();
+  for (int i = 1; i <= kCount; ++i)
+  {
+    g_value.store(i);
+    g_event.notify();
+  }
+  thr.join();
+}
+
+int main()
+{
+  testSemaphore();
+  testLatch();
+  testEvent();
+  printf("done\n");
+}
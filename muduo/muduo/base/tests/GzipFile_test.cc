@@ -1,8 +1,97 @@
 #include <muduo/base/GzipFile.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/base/ParallelGzipFile.h>
+#include <muduo/base/ThreadPool.h>
+#include <muduo/base/Timestamp.h>
 
-int main()
+#include <algorithm>
+
+#include <assert.h>
+
+// log like lines, compressible as real logs are.
+muduo::string makeLog(size_t size)
+{
+  muduo::string log;
+  log.reserve(size + 256);
+  unsigned seed = 1;
+  for (int i = 0; log.size() < size; ++i)
+  {
+    char buf[256];
+    seed = seed * 1103515245 + 12345;
+    snprintf(buf, sizeof buf,
+             "20181019 12:34:%02d.%06d %5d INFO connection %u from 10.0.%u.%u:%u bytes %u - TcpServer.cc:%d\n",
+             i / 100000 % 60, i % 1000000, 4000 + i % 8, seed >> 20, (seed >> 8) & 0xff,
+             seed & 0xff, 1024 + (seed >> 16), (seed >> 4) & 0xffff, 80 + i % 7);
+    log += buf;
+  }
+  return log;
+}
+
+muduo::string readAll(const char* filename)
+{
+  muduo::string result;
+  muduo::GzipFile reader = muduo::GzipFile::openForRead(filename);
+  char buf[64*1024];
+  int nr = 0;
+  while (reader.valid() && (nr = reader.read(buf, sizeof buf)) > 0)
+  {
+    result.append(buf, nr);
+  }
+  return result;
+}
+
+// GzipFile vs. ParallelGzipFile, written in 64KiB pieces as LogFile does.
+void benchmark(int numThreads)
+{
+  const char* filename = "/tmp/gzipfile_bench.gz";
+  const muduo::string log = makeLog(32*1024*1024);
+  const size_t kPiece = 64*1024;
+
+  muduo::Timestamp start(muduo::Timestamp::now());
+  off_t gzipBytes = 0;
+  {
+  muduo::GzipFile writer = muduo::GzipFile::openForWriteTruncate(filename);
+  for (size_t i = 0; i < log.size(); i += kPiece)
+  {
+    writer.write(muduo::StringPiece(log.data() + i, static_cast<int>(std::min(kPiece, log.size() - i))));
+  }
+  }
+  double gzip = timeDifference(muduo::Timestamp::now(), start);
+
+  muduo::ThreadPool pool("gzip");
+  pool.start(numThreads);
+  start = muduo::Timestamp::now();
+  {
+  muduo::ParallelGzipFile writer(filename, &pool);
+  for (size_t i = 0; i < log.size(); i += kPiece)
+  {
+    writer.append(muduo::StringPiece(log.data() + i, static_cast<int>(std::min(kPiece, log.size() - i))));
+  }
+  if (!writer.close())
+  {
+    printf("FAILED to write parallel\n");
+    abort();
+  }
+  gzipBytes = writer.offset();
+  }
+  double parallel = timeDifference(muduo::Timestamp::now(), start);
+  pool.stop();
+
+  if (readAll(filename) != log)
+  {
+    printf("FAILED parallel content\n");
+    abort();
+  }
+  printf("%zd bytes to %ld: GzipFile %.1f MB/s, ParallelGzipFile of %d threads %.1f MB/s\n",
+         log.size(), static_cast<long>(gzipBytes),
+         static_cast<double>(log.size()) / gzip / 1e6,
+         numThreads, static_cast<double>(log.size()) / parallel / 1e6);
+  ::unlink(filename);
+}
+
+// usage: gzipfile_test [bench]
+int main(int argc, char* argv[])
 {
   const char* filename = "/tmp/gzipfile_test.gz";
   ::unlink(filename);
@@ -51,4 +140,31 @@ int main()
     printf("FAILED\n");
   }
   }
+
+  {
+  // empty, sizes around block boundary, a pool of no thread.
+  muduo::ThreadPool pool;
+  pool.start(0);
+  const muduo::string log = makeLog(300*1000);
+  const size_t sizes[] = { 0, 1, 32*1024, 128*1024, 128*1024 + 1, log.size() };
+  for (size_t size : sizes)
+  {
+    {
+    muduo::ParallelGzipFile writer(filename, &pool, 9, 32*1024);
+    writer.append(muduo::StringPiece(log.data(), static_cast<int>(size)));
+    assert(writer.tell() == static_cast<off_t>(size));
+    }
+    if (readAll(filename) != log.substr(0, size))
+    {
+      printf("FAILED ParallelGzipFile %zd\n", size);
+      abort();
+    }
+  }
+  printf("ParallelGzipFile PASSED\n");
+  }
+
+  if (argc > 1)
+  {
+    benchmark(4);
+  }
 }
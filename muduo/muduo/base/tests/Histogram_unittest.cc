@@ -0,0 +1,33 @@
+#include <muduo/base/Histogram.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::Histogram;
+
+int main()
+{
+  Histogram h;
+  assert(h.count() == 0);
+  assert(h.percentile(50) == 0);
+
+  for (int i = 1; i <= 1000; ++i)
+  {
+    h.add(i);
+  }
+  printf("%s\n", h.toString().c_str());
+  assert(h.count() == 1000);
+  assert(h.max() == 1000);
+  assert(h.average() == 500.5);
+  // within 2x
+  assert(h.percentile(50) >= 500 && h.percentile(50) <= 1000);
+  assert(h.percentile(99) >= 990 && h.percentile(99) <= 1000);
+  assert(h.percentile(1) <= 16);
+
+  h.add(0);
+  h.add(int64_t(1) << 50);
+  assert(h.max() == int64_t(1) << 50);
+
+  h.reset();
+  assert(h.count() == 0 && h.max() == 0);
+}
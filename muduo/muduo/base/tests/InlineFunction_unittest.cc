@@ -0,0 +1,133 @@
+#include <muduo/base/InlineFunction.h>
+#include <muduo/base/Types.h>
+
+#include <memory>
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::InlineFunction;
+using muduo::string;
+
+typedef InlineFunction<void()> Functor;
+
+int g_called = 0;
+
+void inc()
+{
+  ++g_called;
+}
+
+void append(string* s, const string& t)
+{
+  s->append(t);
+}
+
+int add(int a, int b)
+{
+  return a + b;
+}
+
+struct Counted
+{
+  static int alive;
+  Counted() { ++alive; }
+  Counted(const Counted&) { ++alive; }
+  Counted(Counted&&) noexcept { ++alive; }
+  ~Counted() { --alive; }
+  void operator()() const { ++g_called; }
+};
+int Counted::alive = 0;
+
+struct Big
+{
+  char data[256];
+  void operator()() const { ++g_called; }
+};
+
+struct MoveOnly
+{
+  std::unique_ptr<int> p;
+  explicit MoveOnly(int x) : p(new int(x)) { }
+  void operator()() const { g_called += *p; }
+};
+
+void testBasic()
+{
+  Functor f;
+  assert(!f);
+  Functor g(inc);
+  assert(g);
+  g();
+  assert(g_called == 1);
+
+  void (*null)() = NULL;
+  Functor h(null);
+  assert(!h);
+  std::function<void()> empty;
+  Functor e(empty);
+  assert(!e);
+
+  InlineFunction<int(int, int)> sum(add);
+  assert(sum(1, 2) == 3);
+
+  string s;
+  Functor a(std::bind(append, &s, string("hello")));
+  a();
+  assert(s == "hello");
+}
+
+void testInline()
+{
+  static_assert(Functor::fitsInline<Counted>::value, "Counted fits");
+  static_assert(!Functor::fitsInline<Big>::value, "Big is too big");
+  typedef decltype(std::bind(append, static_cast<string*>(NULL), string())) StringBind;
+  static_assert(Functor::fitsInline<StringBind>::value, "string bind fits");
+  typedef decltype(std::bind(std::function<void (const std::shared_ptr<int>&)>(),
+                             std::shared_ptr<int>())) CallbackBind;
+  static_assert(Functor::fitsInline<CallbackBind>::value, "callback bind fits");
+
+  g_called = 0;
+  {
+    Functor f((Counted()));
+    assert(Counted::alive == 1);
+    Functor g(std::move(f));
+    assert(!f && g);
+    assert(Counted::alive == 1);
+    g();
+    f = std::move(g);
+    assert(!g && f);
+    f();
+    f = nullptr;
+    assert(Counted::alive == 0);
+    f = Counted();
+  }
+  assert(Counted::alive == 0);
+  assert(g_called == 2);
+}
+
+void testHeap()
+{
+  g_called = 0;
+  Big big = Big();
+  Functor f(big);
+  Functor g(std::move(f));
+  assert(!f);
+  g();
+  assert(g_called == 1);
+
+  Functor m(MoveOnly(41));
+  Functor n;
+  n.swap(m);
+  assert(!m && n);
+  n();
+  assert(g_called == 42);
+}
+
+int main()
+{
+  testBasic();
+  testInline();
+  testHeap();
+  printf("sizeof(Functor) = %zd\n", sizeof(Functor));
+}
@@ -0,0 +1,121 @@
+#include <muduo/base/KeyValueLogging.h>
+#include <muduo/base/Timestamp.h>
+
+#include <string>
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+
+std::string g_line;
+
+void captureOutput(const char* msg, int len)
+{
+  g_line.assign(msg, len);
+  fwrite(msg, 1, len, stdout);
+}
+
+void nullOutput(const char*, int)
+{
+}
+
+bool endsWith(const std::string& line, const std::string& suffix)
+{
+  return line.size() >= suffix.size()
+      && line.compare(line.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// text between level and " - file:line"
+std::string pairs(const std::string& line)
+{
+  size_t begin = line.find("INFO  ");
+  size_t end = line.rfind(" - ");
+  assert(begin != std::string::npos && end != std::string::npos);
+  return line.substr(begin + 6, end - begin - 6);
+}
+
+void testLogfmt()
+{
+  muduo::string name("conn#1");
+  LOG_INFO_KV("conn", name)("bytes", 1234)("ok", true)("ratio", 0.25);
+  assert(pairs(g_line) == "conn=conn#1 bytes=1234 ok=true ratio=0.25");
+  assert(g_line.find(" - KeyValueLogging_unittest.cc:") != std::string::npos);
+
+  LOG_INFO_KV("msg", "hello world")("empty", "")("eq", "a=b")("quote", "say \"hi\"\n");
+  assert(pairs(g_line) == "msg=\"hello world\" empty=\"\" eq=\"a=b\" quote=\"say \\\"hi\\\"\\n\"");
+
+  const char* nullString = NULL;
+  muduo::StringPiece piece("piece");
+  LOG_INFO_KV("null", nullString)("piece", piece)("char", 'c')("neg", -5L)("big", 18446744073709551615ULL);
+  assert(pairs(g_line) == "null=\"\" piece=piece char=c neg=-5 big=18446744073709551615");
+
+  // other types go through LogStream.
+  int x = 0;
+  LOG_INFO_KV("ptr", static_cast<void*>(&x));
+  assert(pairs(g_line).compare(0, 6, "ptr=0x") == 0);
+
+  LOG_WARN_KV("level", "warn");
+  assert(g_line.find(" WARN  level=warn - ") != std::string::npos);
+}
+
+void testJson()
+{
+  muduo::Logger::setKeyValueFormat(muduo::Logger::kJson);
+  LOG_INFO_KV("conn", "conn#1")("bytes", 1234)("ok", false)("ratio", 0.5);
+  assert(g_line.compare(0, 9, "{\"time\":\"") == 0);
+  assert(g_line.find("\"level\":\"INFO\",\"file\":\"KeyValueLogging_unittest.cc\",\"line\":") != std::string::npos);
+  assert(endsWith(g_line, ",\"conn\":\"conn#1\",\"bytes\":1234,\"ok\":false,\"ratio\":0.5}\n"));
+
+  std::string control("tab\there\x01\x7f");
+  LOG_INFO_KV("control", control)("nan", NAN)("inf", -INFINITY)("null", static_cast<const char*>(NULL));
+  assert(endsWith(g_line,
+      ",\"control\":\"tab\\there\\u0001\\u007f\",\"nan\":null,\"inf\":null,\"null\":null}\n"));
+
+  LOG_INFO_KV("utf8", "\xe4\xb8\xad")("key \"quoted\"", 1);
+  assert(endsWith(g_line, ",\"utf8\":\"\xe4\xb8\xad\",\"key \\\"quoted\\\"\":1}\n"));
+
+  // a line is dropped below the log level, as LOG_DEBUG.
+  g_line.clear();
+  LOG_DEBUG_KV("debug", 1);
+  assert(g_line.empty());
+  muduo::Logger::setKeyValueFormat(muduo::Logger::kLogfmt);
+}
+
+void bench()
+{
+  const int kLines = 1000*1000;
+  muduo::Logger::setOutput(nullOutput);
+  muduo::string name("127.0.0.1:2007#1");
+
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (int i = 0; i < kLines; ++i)
+  {
+    LOG_INFO << "conn " << name << " bytes " << i << " ok " << true;
+  }
+  muduo::Timestamp text(muduo::Timestamp::now());
+  for (int i = 0; i < kLines; ++i)
+  {
+    LOG_INFO_KV("conn", name)("bytes", i)("ok", true);
+  }
+  muduo::Timestamp logfmt(muduo::Timestamp::now());
+  muduo::Logger::setKeyValueFormat(muduo::Logger::kJson);
+  for (int i = 0; i < kLines; ++i)
+  {
+    LOG_INFO_KV("conn", name)("bytes", i)("ok", true);
+  }
+  muduo::Timestamp json(muduo::Timestamp::now());
+  muduo::Logger::setKeyValueFormat(muduo::Logger::kLogfmt);
+
+  printf("ns per line: text %.1f, logfmt %.1f, json %.1f\n",
+         timeDifference(text, start) * 1e9 / kLines,
+         timeDifference(logfmt, text) * 1e9 / kLines,
+         timeDifference(json, logfmt) * 1e9 / kLines);
+}
+
+int main()
+{
+  muduo::Logger::setOutput(captureOutput);
+  testLogfmt();
+  testJson();
+  bench();
+}
@@ -0,0 +1,206 @@
+#include <muduo/base/FutexBlockingQueue.h>
+#include <muduo/base/LockFreeQueue.h>
+#include <muduo/base/Thread.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+using muduo::FutexBlockingQueue;
+using muduo::MpmcQueue;
+using muduo::SpscQueue;
+
+const int kItems = 200 * 1000;
+
+template<typename Queue>
+void testSingleThread()
+{
+  Queue q(5);
+  assert(q.capacity() == 8);
+  assert(q.empty());
+
+  for (int i = 0; i < 8; ++i)
+  {
+    bool ok = q.tryPush(i);
+    assert(ok);
+    (void)ok;
+  }
+  assert(!q.tryPush(8));
+  assert(q.size() == 8);
+
+  int x = -1;
+  for (int i = 0; i < 3; ++i)
+  {
+    bool ok = q.tryPop(&x);
+    assert(ok && x == i);
+    (void)ok;
+  }
+
+  // wraps around
+  int in[5] = { 8, 9, 10, 11, 12 };
+  size_t pushed = q.tryPushBatch(in, 5);
+  assert(pushed == 3);
+
+  int out[16];
+  size_t popped = q.tryPopBatch(out, 16);
+  printf("pushed %zd popped %zd\n", pushed, popped);
+  assert(popped == 8);
+  for (size_t i = 0; i < popped; ++i)
+  {
+    assert(out[i] == static_cast<int>(i) + 3);
+  }
+  assert(!q.tryPop(&x));
+  assert(q.empty());
+}
+
+void testMoveOnly()
+{
+  MpmcQueue<std::unique_ptr<int>> q(4);
+  q.tryPush(std::unique_ptr<int>(new int(42)));
+  std::unique_ptr<int> p;
+  bool ok = q.tryPop(&p);
+  assert(ok && p && *p == 42);
+  printf("move only %d\n", *p);
+  (void)ok;
+
+  SpscQueue<std::string> s(4);
+  std::string hello("hello");
+  s.tryPush(hello);
+  s.tryPush(std::move(hello));
+  std::string x;
+  s.tryPop(&x);
+  s.tryPop(&x);
+  assert(x == "hello");
+}
+
+template<typename Queue>
+void produce(FutexBlockingQueue<Queue>* q, int p, bool batch)
+{
+  int base = p * kItems;
+  if (batch)
+  {
+    int items[7];
+    for (int i = 0; i < kItems; i += 7)
+    {
+      int n = std::min(7, kItems - i);
+      for (int j = 0; j < n; ++j)
+      {
+        items[j] = base + i + j;
+      }
+      q->putBatch(items, static_cast<size_t>(n));
+    }
+  }
+  else
+  {
+    for (int i = 0; i < kItems; ++i)
+    {
+      q->put(base + i);
+    }
+  }
+}
+
+// checks that items from each producer come in order.
+template<typename Queue>
+void consume(FutexBlockingQueue<Queue>* q, int numProducers, bool batch, int64_t* sum)
+{
+  std::vector<int> last(numProducers, -1);
+  int items[5];
+  bool running = true;
+  while (running)
+  {
+    size_t n = 1;
+    if (batch)
+    {
+      n = q->takeBatch(items, 5);
+    }
+    else
+    {
+      items[0] = q->take();
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+      if (items[i] < 0)
+      {
+        // one stop sign for each consumer, give back the extra ones.
+        if (!running)
+        {
+          q->put(-1);
+        }
+        running = false;
+        continue;
+      }
+      int p = items[i] / kItems;
+      assert(items[i] > last[p]);
+      last[p] = items[i];
+      *sum += items[i];
+    }
+  }
+}
+
+template<typename Queue>
+void testThreads(int numProducers, int numConsumers, bool batch)
+{
+  FutexBlockingQueue<Queue> q(64);
+  std::vector<int64_t> sums(numConsumers);
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+
+  for (int p = 0; p < numProducers; ++p)
+  {
+    threads.emplace_back(new muduo::Thread(
+          std::bind(&produce<Queue>, &q, p, batch)));
+  }
+  for (int c = 0; c < numConsumers; ++c)
+  {
+    threads.emplace_back(new muduo::Thread(
+          std::bind(&consume<Queue>, &q, numProducers, batch, &sums[c])));
+  }
+
+  for (auto& thr : threads)
+  {
+    thr->start();
+  }
+  for (int p = 0; p < numProducers; ++p)
+  {
+    threads[p]->join();
+  }
+  for (int c = 0; c < numConsumers; ++c)
+  {
+    q.put(-1);
+  }
+  for (int c = 0; c < numConsumers; ++c)
+  {
+    threads[numProducers + c]->join();
+  }
+
+  int64_t total = 0;
+  for (int64_t sum : sums)
+  {
+    total += sum;
+  }
+  int64_t n = static_cast<int64_t>(numProducers) * kItems;
+  printf("producers %d consumers %d batch %d items %" PRId64 " sum %" PRId64 "\n",
+         numProducers, numConsumers, batch, n, total);
+  assert(total == n * (n - 1) / 2);
+  assert(q.size() == 0);
+}
+
+int main()
+{
+  testSingleThread<SpscQueue<int>>();
+  testSingleThread<MpmcQueue<int>>();
+  testMoveOnly();
+
+  testThreads<SpscQueue<int>>(1, 1, false);
+  testThreads<SpscQueue<int>>(1, 1, true);
+  testThreads<MpmcQueue<int>>(1, 1, false);
+  testThreads<MpmcQueue<int>>(4, 4, false);
+  testThreads<MpmcQueue<int>>(4, 4, true);
+  testThreads<MpmcQueue<int>>(1, 3, true);
+  testThreads<MpmcQueue<int>>(3, 1, false);
+}
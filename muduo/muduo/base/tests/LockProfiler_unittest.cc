@@ -0,0 +1,146 @@
+#include <muduo/base/LockProfiler.h>
+#include <muduo/base/Condition.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+
+MutexLock g_mutex("g_mutex");
+CountDownLatch* g_locked;
+
+void holdForAWhile()
+{
+  MutexLockGuard lock(g_mutex);
+  g_locked->countDown();
+  ::usleep(20*1000);
+}
+
+void testContended()
+{
+  assert(LockProfiler::stats("g_mutex")->acquisitions() == 0);
+
+  // not counted while disabled
+  {
+  MutexLockGuard lock(g_mutex);
+  }
+  assert(LockProfiler::stats("g_mutex")->acquisitions() == 0);
+
+  LockProfiler::setEnabled(true);
+  CountDownLatch locked(1);
+  g_locked = &locked;
+  Thread holder(holdForAWhile);
+  holder.start();
+  locked.wait();
+  {
+  MutexLockGuard lock(g_mutex);  // waits for holder
+  }
+  holder.join();
+  std::unique_ptr<LockStats> stats = LockProfiler::stats("g_mutex");
+  printf("%s\n", stats->toString().c_str());
+  assert(stats->acquisitions() == 2);
+  assert(stats->contended() == 1);
+  assert(stats->waitTime().count() == 1);
+  assert(stats->waitTime().max() >= 10*1000*1000);
+  // first acquisition is sampled, and the contended one.
+  assert(stats->holdTime().count() == 2);
+  assert(stats->holdTime().max() >= 10*1000*1000);
+
+  LockProfiler::reset();
+  stats = LockProfiler::stats("g_mutex");
+  assert(stats->acquisitions() == 0);
+  assert(stats->holdTime().count() == 0);
+  LockProfiler::setEnabled(false);
+}
+
+// locks of a name count on their own, and are summed by name.
+void testSharedName()
+{
+  assert(!LockProfiler::stats("shard"));
+  MutexLock shard1("shard");
+  LockProfiler::setEnabled(true);
+  {
+  MutexLock shard2("shard");
+  for (int i = 0; i < 100; ++i)
+  {
+    MutexLockGuard lock(i % 2 ? shard1 : shard2);
+  }
+  std::unique_ptr<LockStats> stats = LockProfiler::stats("shard");
+  printf("%s\n", stats->toString().c_str());
+  assert(stats->acquisitions() == 100);
+  assert(stats->contended() == 0);
+  // 50 each, sampled on their own.
+  assert(stats->holdTime().count() == 2 * (50 / LockProfiler::kHoldSampling + 1));
+  }
+  // counts of shard2 stay after it is gone.
+  {
+  MutexLockGuard lock(shard1);
+  }
+  assert(LockProfiler::stats("shard")->acquisitions() == 101);
+  LockProfiler::setEnabled(false);
+}
+
+// time spent in Condition::wait() is not held.
+void testCondition()
+{
+  MutexLock mutex("cond");
+  Condition cond(mutex);
+  LockProfiler::setEnabled(true);
+  {
+  MutexLockGuard lock(mutex);
+  cond.waitForSeconds(0.02);
+  }
+  std::unique_ptr<LockStats> stats = LockProfiler::stats("cond");
+  printf("%s\n", stats->toString().c_str());
+  assert(stats->acquisitions() == 1);
+  assert(stats->holdTime().count() == 1);
+  assert(stats->holdTime().max() < 10*1000*1000);
+  LockProfiler::setEnabled(false);
+
+  string report = LockProfiler::report();
+  printf("%s", report.c_str());
+  assert(report.find("cond acquisitions 1 contended 0") != string::npos);
+}
+
+void bench()
+{
+  const int kCount = 10*1000*1000;
+  MutexLock plain;
+  MutexLock named("bench");
+
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kCount; ++i)
+  {
+    MutexLockGuard lock(plain);
+  }
+  Timestamp t1(Timestamp::now());
+  for (int i = 0; i < kCount; ++i)
+  {
+    MutexLockGuard lock(named);
+  }
+  Timestamp t2(Timestamp::now());
+  LockProfiler::setEnabled(true);
+  for (int i = 0; i < kCount; ++i)
+  {
+    MutexLockGuard lock(named);
+  }
+  Timestamp t3(Timestamp::now());
+  LockProfiler::setEnabled(false);
+  printf("ns per lock/unlock: unnamed %.1f, named disabled %.1f, named enabled %.1f\n",
+         timeDifference(t1, start) * 1e9 / kCount,
+         timeDifference(t2, t1) * 1e9 / kCount,
+         timeDifference(t3, t2) * 1e9 / kCount);
+}
+
+int main()
+{
+  LockProfiler::setEnabled(false);
+  testContended();
+  testSharedName();
+  testCondition();
+  bench();
+}
@@ -1,6 +1,8 @@
 #include <muduo/base/LogFile.h>
 #include <muduo/base/Logging.h>
 
+#include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 std::unique_ptr<muduo::LogFile> g_logFile;
@@ -15,11 +17,19 @@ void flushFunc()
   g_logFile->flush();
 }
 
+// usage: logfile_test [stdio|block|direct [compress]]
 int main(int argc, char* argv[])
 {
+  muduo::LogFile::Options options;
+  const char* sink = argc > 1 ? argv[1] : "stdio";
+  options.blockWrite = strcmp(sink, "stdio") != 0;
+  options.directIO = strcmp(sink, "direct") == 0;
+  options.compress = argc > 2 && strcmp(argv[2], "compress") == 0;
+  options.latency = true;
+
   char name[256] = { 0 };
   strncpy(name, argv[0], sizeof name - 1);
-  g_logFile.reset(new muduo::LogFile(::basename(name), 200*1000));
+  g_logFile.reset(new muduo::LogFile(::basename(name), "", 200*1000, options));
   muduo::Logger::setOutput(outputFunc);
   muduo::Logger::setFlush(flushFunc);
 
@@ -31,4 +41,7 @@ int main(int argc, char* argv[])
 
     usleep(1000);
   }
+
+  printf("%s write latency %s\n", sink, g_logFile->writeLatency().toString().c_str());
+  printf("%s flush latency %s\n", sink, g_logFile->flushLatency().toString().c_str());
 }
@@ -55,6 +55,90 @@ void benchLogStream()
   printf("benchLogStream %f\n", timeDifference(end, start));
 }
 
+// fractional values, as in metrics logs.
+double metric(size_t i)
+{
+  return static_cast<double>(i) * 0.001 + 0.1;
+}
+
+void benchPrintfMetric()
+{
+  char buf[32];
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < N; ++i)
+    snprintf(buf, sizeof buf, "%.12g", metric(i));
+  Timestamp end(Timestamp::now());
+
+  printf("benchPrintf %f\n", timeDifference(end, start));
+}
+
+void benchLogStreamMetric()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << metric(i);
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchLogStream %f\n", timeDifference(end, start));
+}
+
+void benchPrintfRoundTrip()
+{
+  char buf[32];
+  Timestamp start(Timestamp::now());
+  for (size_t i = 0; i < N; ++i)
+    snprintf(buf, sizeof buf, "%.17g", metric(i));
+  Timestamp end(Timestamp::now());
+
+  printf("benchPrintf %%.17g %f\n", timeDifference(end, start));
+}
+
+void benchRoundTrip()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << RoundTrip(metric(i));
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchRoundTrip %f\n", timeDifference(end, start));
+}
+
+void benchFmtHex()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << Fmt("%X", static_cast<unsigned>(i * 2654435761u));
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchFmt %f\n", timeDifference(end, start));
+}
+
+void benchHex()
+{
+  Timestamp start(Timestamp::now());
+  LogStream os;
+  for (size_t i = 0; i < N; ++i)
+  {
+    os << Hex(static_cast<unsigned>(i * 2654435761u));
+    os.resetBuffer();
+  }
+  Timestamp end(Timestamp::now());
+
+  printf("benchHex %f\n", timeDifference(end, start));
+}
+
 int main()
 {
   benchPrintf<int>("%d");
@@ -79,4 +163,13 @@ int main()
   benchStringStream<void*>();
   benchLogStream<void*>();
 
+  puts("double metric");
+  benchPrintfMetric();
+  benchLogStreamMetric();
+  benchPrintfRoundTrip();
+  benchRoundTrip();
+
+  puts("hex");
+  benchFmtHex();
+  benchHex();
 }
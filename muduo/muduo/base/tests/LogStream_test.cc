@@ -167,6 +167,51 @@ BOOST_AUTO_TEST_CASE(testLogStreamFloats)
   os << -123.456;
   BOOST_CHECK_EQUAL(buf.toString(), string("-123.456"));
   os.resetBuffer();
+
+  // same as "%.12g"
+  os << 1234567890123.0 << ' ' << 1e21 << ' ' << 1e-7 << ' ' << -0.0;
+  BOOST_CHECK_EQUAL(buf.toString(), string("1.23456789012e+12 1e+21 1e-07 -0"));
+  os.resetBuffer();
+
+  os << 999999999999.5 << ' ' << 0.000123456789012345;
+  BOOST_CHECK_EQUAL(buf.toString(), string("1e+12 0.000123456789012"));
+  os.resetBuffer();
+
+  os << 5e-324 << ' ' << std::numeric_limits<double>::infinity();
+  BOOST_CHECK_EQUAL(buf.toString(), string("4.94065645841e-324 inf"));
+  os.resetBuffer();
+}
+
+BOOST_AUTO_TEST_CASE(testLogStreamRoundTrip)
+{
+  muduo::LogStream os;
+  const muduo::LogStream::Buffer& buf = os.buffer();
+
+  os << muduo::RoundTrip(0.1 + 0.05) << ' ' << muduo::RoundTrip(0.15);
+  BOOST_CHECK_EQUAL(buf.toString(), string("0.15000000000000002 0.15"));
+  os.resetBuffer();
+
+  os << muduo::RoundTrip(1.0 / 3) << ' ' << muduo::RoundTrip(-1e100);
+  BOOST_CHECK_EQUAL(buf.toString(), string("0.3333333333333333 -1e+100"));
+  os.resetBuffer();
+
+  os << muduo::RoundTrip(5e-324) << ' ' << muduo::RoundTrip(1.7976931348623157e308);
+  BOOST_CHECK_EQUAL(buf.toString(), string("5e-324 1.7976931348623157e+308"));
+  os.resetBuffer();
+}
+
+BOOST_AUTO_TEST_CASE(testLogStreamHex)
+{
+  muduo::LogStream os;
+  const muduo::LogStream::Buffer& buf = os.buffer();
+
+  os << muduo::Hex(0) << ' ' << muduo::Hex(255) << ' ' << muduo::Hex(-1);
+  BOOST_CHECK_EQUAL(buf.toString(), string("0 FF FFFFFFFF"));
+  os.resetBuffer();
+
+  os << muduo::Hex(std::numeric_limits<uint64_t>::max());
+  BOOST_CHECK_EQUAL(buf.toString(), string("FFFFFFFFFFFFFFFF"));
+  os.resetBuffer();
 }
 
 BOOST_AUTO_TEST_CASE(testLogStreamVoid)
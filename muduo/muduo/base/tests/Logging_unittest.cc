@@ -0,0 +1,129 @@
+// statements below DEBUG are compiled out.
+#define MUDUO_LOG_MIN_LEVEL 1
+#include <muduo/base/Logging.h>
+
+#include <string>
+#include <vector>
+
+#include <assert.h>
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+muduo::LogModule g_testLog("test");
+muduo::LogModule g_otherLog("other");
+
+std::vector<std::string> g_lines;
+
+void captureOutput(const char* msg, int len)
+{
+  g_lines.push_back(std::string(msg, len));
+  fwrite(msg, 1, len, stdout);
+}
+
+int count(const char* word)
+{
+  int n = 0;
+  for (const auto& line : g_lines)
+  {
+    if (line.find(word) != std::string::npos)
+    {
+      ++n;
+    }
+  }
+  return n;
+}
+
+void testLevels()
+{
+  muduo::Logger::setLogLevel(muduo::Logger::TRACE);
+  LOG_TRACE << "compiled out";
+  LOG_DEBUG << "debug";
+  assert(count("compiled out") == 0);
+  assert(count("debug") == 1);
+
+  muduo::Logger::setLogLevel(muduo::Logger::ERROR);
+  LOG_INFO << "info";
+  LOG_WARN << "warn";
+  LOG_ERROR << "error";
+  assert(count("info") == 0);
+  assert(count("warn") == 0);
+  assert(count("error") == 1);
+}
+
+void testModules()
+{
+  muduo::Logger::setLogLevel(muduo::Logger::INFO);
+  LOG_MODULE(g_testLog, DEBUG) << "test module debug";
+  LOG_MODULE(g_testLog, INFO) << "test module info";
+  assert(count("test module debug") == 0);
+  assert(count("test module info") == 1);
+
+  muduo::Logger::setLogLevel("test", muduo::Logger::DEBUG);
+  muduo::Logger::setLogLevel(muduo::Logger::WARN);
+  assert(g_testLog.level() == muduo::Logger::DEBUG);
+  assert(g_otherLog.level() == muduo::Logger::WARN);
+  LOG_MODULE(g_testLog, DEBUG) << "test module debug";
+  LOG_MODULE(g_otherLog, INFO) << "other module info";
+  assert(count("test module debug") == 1);
+  assert(count("other module info") == 0);
+
+  // modules created later see levels set by name, the last one.
+  muduo::Logger::setLogLevel("test", muduo::Logger::WARN);
+  muduo::Logger::setLogLevel("test", muduo::Logger::DEBUG);
+  muduo::LogModule later("test");
+  assert(later.level() == muduo::Logger::DEBUG);
+  muduo::Logger::setLogLevel(muduo::Logger::INFO);
+}
+
+void testEveryN()
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    LOG_EVERY_N(INFO, 10) << "every ten " << i;
+  }
+  printf("every ten %d\n", count("every ten"));
+  assert(count("every ten") == 10);
+  assert(count("every ten 90 ") == 1);
+
+  // n <= 0 logs every time, instead of dividing by zero.
+  for (int i = 0; i < 3; ++i)
+  {
+    LOG_EVERY_N(INFO, 0) << "every zero";
+  }
+  assert(count("every zero") == 3);
+}
+
+void testEverySec()
+{
+  muduo::Timestamp start(muduo::Timestamp::now());
+  int statements = 0;
+  while (timeDifference(muduo::Timestamp::now(), start) < 0.5)
+  {
+    LOG_EVERY_SEC(WARN, 0.2) << "storm";
+    ++statements;
+    ::usleep(1000);
+  }
+  int logged = count("storm");
+  printf("storm %d of %d, skipped %d\n", logged, statements, count("skipped]"));
+  assert(logged >= 2 && logged <= 4);
+  assert(count("skipped] storm") == logged - 1);
+
+  // errno is left for the caller.
+  for (int i = 0; i < 3; ++i)
+  {
+    errno = EPIPE;
+    LOG_SYSERR_EVERY_SEC(100) << "syserr storm";
+    assert(errno == EPIPE);
+  }
+  assert(count("syserr storm") == 1);
+}
+
+int main()
+{
+  muduo::Logger::setOutput(captureOutput);
+  testLevels();
+  testModules();
+  testEveryN();
+  testEverySec();
+}
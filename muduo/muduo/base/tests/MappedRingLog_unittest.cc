@@ -0,0 +1,163 @@
+#include <muduo/base/MappedRingLog.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+
+#include <memory>
+#include <vector>
+
+#include <assert.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using muduo::MappedRingLog;
+using muduo::string;
+
+std::vector<string> g_lines;
+
+void collect(const char* line, int len)
+{
+  g_lines.push_back(string(line, len));
+}
+
+string tempName()
+{
+  char name[64];
+  snprintf(name, sizeof name, "/tmp/mappedringlog_unittest.%d.ring", getpid());
+  return name;
+}
+
+void testWrap()
+{
+  string filename = tempName();
+  {
+  MappedRingLog ring(filename, 10000);
+  assert(ring.capacity() == 12288);
+  char buf[64];
+  for (int i = 0; i < 10000; ++i)
+  {
+    int n = snprintf(buf, sizeof buf, "line %d %*s\n", i, i % 17, "");
+    ring.append(buf, n);
+  }
+  // longer than a quarter of the ring, truncated.
+  string big(10000, 'x');
+  ring.append(big.data(), static_cast<int>(big.size()));
+  }
+
+  g_lines.clear();
+  int n = MappedRingLog::readFile(filename, collect);
+  printf("wrap: %d lines, first %s", n, g_lines.front().c_str());
+  assert(n == static_cast<int>(g_lines.size()));
+  assert(n > 50);
+  assert(g_lines.back() == string(3072, 'x'));
+  g_lines.pop_back();
+  int last = 9999;
+  for (auto it = g_lines.rbegin(); it != g_lines.rend(); ++it)
+  {
+    char expected[64];
+    snprintf(expected, sizeof expected, "line %d %*s\n", last, last % 17, "");
+    assert(*it == expected);
+    --last;
+  }
+  ::unlink(filename.c_str());
+}
+
+MappedRingLog* g_ring = NULL;
+
+void threadFunc(int id)
+{
+  char buf[64];
+  for (int i = 0; i < 20000; ++i)
+  {
+    int n = snprintf(buf, sizeof buf, "%d %d\n", id, i);
+    g_ring->append(buf, n);
+  }
+}
+
+void testThreads()
+{
+  string filename = tempName();
+  g_ring = new MappedRingLog(filename, 64*1024);
+  std::vector<std::unique_ptr<muduo::Thread>> threads;
+  const int kThreads = 4;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new muduo::Thread(std::bind(threadFunc, i)));
+    threads.back()->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  delete g_ring;
+  g_ring = NULL;
+
+  g_lines.clear();
+  int n = MappedRingLog::readFile(filename, collect);
+  printf("threads: %d lines\n", n);
+  assert(n > 1000);
+  // lines of one thread come in order. the ring holds a few thousand of
+  // 80000 lines, so a thread that finished early may be overwritten
+  // entirely, only the thread that appended last surely ends at 19999.
+  std::vector<int> next(kThreads, -1);
+  int lastId = -1;
+  for (const string& line : g_lines)
+  {
+    int id = -1, i = -1;
+    int fields = sscanf(line.c_str(), "%d %d", &id, &i);
+    assert(fields == 2 && id >= 0 && id < kThreads);
+    (void)fields;
+    assert(i > next[id]);
+    next[id] = i;
+    lastId = id;
+  }
+  assert(lastId >= 0 && next[lastId] == 19999);
+  (void)lastId;
+  ::unlink(filename.c_str());
+}
+
+void ringOutput(const char* msg, int len)
+{
+  g_ring->append(msg, len);
+}
+
+// lines logged by a process are there after it is SIGKILLed.
+void testKill()
+{
+  string filename = tempName();
+  pid_t child = ::fork();
+  assert(child >= 0);
+  if (child == 0)
+  {
+    g_ring = new MappedRingLog(filename, 1024*1024);
+    muduo::Logger::setOutput(ringOutput);
+    for (int i = 0; i < 1000; ++i)
+    {
+      LOG_INFO << "before kill " << i;
+    }
+    ::kill(::getpid(), SIGKILL);
+    abort();
+  }
+  int status = 0;
+  ::waitpid(child, &status, 0);
+  assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL);
+
+  g_lines.clear();
+  int n = MappedRingLog::readFile(filename, collect);
+  printf("kill: %d lines, last %s", n, g_lines.back().c_str());
+  assert(n == 1000);
+  assert(g_lines.back().find("before kill 999 - MappedRingLog_unittest.cc:") != string::npos);
+  ::unlink(filename.c_str());
+
+  assert(MappedRingLog::readFile(filename, collect) == -1);
+  assert(MappedRingLog::readFile("/proc/self/exe", collect) == -1);
+}
+
+int main()
+{
+  testWrap();
+  testThreads();
+  testKill();
+}
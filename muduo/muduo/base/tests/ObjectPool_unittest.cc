@@ -0,0 +1,183 @@
+#include <muduo/base/ObjectPool.h>
+#include <muduo/base/Atomic.h>
+#include <muduo/base/BlockingQueue.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <vector>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+const int kCount = 10*1000*1000;
+
+AtomicInt32 g_alive;
+
+class Foo
+{
+ public:
+  Foo(int x, const string& name)
+    : x_(x), name_(name)
+  {
+    g_alive.increment();
+  }
+
+  ~Foo()
+  {
+    g_alive.decrement();
+  }
+
+  int x() const { return x_; }
+  const string& name() const { return name_; }
+
+ private:
+  int x_;
+  string name_;
+};
+
+class Thrower
+{
+ public:
+  explicit Thrower(bool fail)
+  {
+    if (fail)
+    {
+      throw 1;
+    }
+  }
+};
+
+BlockingQueue<Foo*> g_queue;
+
+// frees in another thread than allocating.
+void consume(int n)
+{
+  for (int i = 0; i < n; ++i)
+  {
+    Foo* foo = g_queue.take();
+    assert(foo->x() == i);
+    ObjectPool<Foo>::destroy(foo);
+  }
+}
+
+void testCreate()
+{
+  Foo* foo = ObjectPool<Foo>::create(42, "foo");
+  assert(foo->x() == 42 && foo->name() == "foo");
+  assert(g_alive.get() == 1);
+  ObjectPool<Foo>::destroy(foo);
+  assert(g_alive.get() == 0);
+  // recycled in same thread, LIFO.
+  Foo* foo2 = ObjectPool<Foo>::create(43, "bar");
+  assert(foo2 == foo);
+  ObjectPool<Foo>::destroy(foo2);
+  ObjectPool<Foo>::destroy(NULL);
+
+  {
+  ObjectPool<Foo>::UniquePtr p = ObjectPool<Foo>::makeUnique(1, "unique");
+  assert(g_alive.get() == 1);
+  }
+  assert(g_alive.get() == 0);
+
+  try
+  {
+    ObjectPool<Thrower>::create(true);
+    assert(false);
+  }
+  catch (int)
+  {
+  }
+  Thrower* t = ObjectPool<Thrower>::create(false);
+  ObjectPool<Thrower>::destroy(t);
+}
+
+void testCrossThread()
+{
+  const int n = 100*1000;
+  Thread thr(std::bind(consume, n));
+  thr.start();
+  for (int i = 0; i < n; ++i)
+  {
+    g_queue.put(ObjectPool<Foo>::create(i, "cross"));
+  }
+  thr.join();
+  assert(g_alive.get() == 0);
+  int64_t blocks = ObjectPool<Foo>::blocks();
+  printf("%" PRId64 " blocks after cross thread\n", blocks);
+
+  // consumer gave its blocks back when exited, they are reused.
+  std::vector<Foo*> foos;
+  for (int64_t i = 0; i < blocks; ++i)
+  {
+    foos.push_back(ObjectPool<Foo>::create(static_cast<int>(i), "reuse"));
+  }
+  assert(ObjectPool<Foo>::blocks() == blocks);
+  for (Foo* foo : foos)
+  {
+    ObjectPool<Foo>::destroy(foo);
+  }
+}
+
+void testShared()
+{
+  std::weak_ptr<Foo> weak;
+  {
+  std::shared_ptr<Foo> foo = makeShared<Foo>(7, "shared");
+  assert(foo->x() == 7);
+  weak = foo;
+  assert(g_alive.get() == 1);
+  }
+  assert(g_alive.get() == 0);
+  assert(weak.expired());
+}
+
+void benchmark()
+{
+  Timestamp start(Timestamp::now());
+  for (int i = 0; i < kCount; ++i)
+  {
+    Foo* foo = new Foo(i, string());
+    delete foo;
+  }
+  double heap = timeDifference(Timestamp::now(), start);
+
+  start = Timestamp::now();
+  for (int i = 0; i < kCount; ++i)
+  {
+    Foo* foo = ObjectPool<Foo>::create(i, string());
+    ObjectPool<Foo>::destroy(foo);
+  }
+  double pool = timeDifference(Timestamp::now(), start);
+
+  start = Timestamp::now();
+  for (int i = 0; i < kCount; ++i)
+  {
+    std::shared_ptr<Foo> foo = std::make_shared<Foo>(i, string());
+  }
+  double sharedHeap = timeDifference(Timestamp::now(), start);
+
+  start = Timestamp::now();
+  for (int i = 0; i < kCount; ++i)
+  {
+    std::shared_ptr<Foo> foo = makeShared<Foo>(i, string());
+  }
+  double sharedPool = timeDifference(Timestamp::now(), start);
+
+  printf("ns per object: new %.2f, ObjectPool %.2f, make_shared %.2f, makeShared %.2f\n",
+         heap * 1e9 / kCount, pool * 1e9 / kCount,
+         sharedHeap * 1e9 / kCount, sharedPool * 1e9 / kCount);
+}
+
+int main()
+{
+  testCreate();
+  testCrossThread();
+  testShared();
+  benchmark();
+  assert(g_alive.get() == 0);
+}
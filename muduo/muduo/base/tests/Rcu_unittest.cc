@@ -0,0 +1,248 @@
+#include <muduo/base/Rcu.h>
+#include <muduo/base/SeqLock.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+using namespace muduo;
+
+// routing table, the read-mostly object of the benchmark.
+typedef std::map<int, int> Routes;
+
+const int kAlive = 0x5a5a5a5a;
+
+struct Checked
+{
+  int alive;
+  Routes routes;
+
+  Checked() : alive(kAlive) { }
+  Checked(const Checked& rhs) : alive(kAlive), routes(rhs.routes) { }
+  ~Checked() { alive = 0; }
+};
+
+std::atomic<bool> g_running(true);
+
+void addRoute(int key, Checked* checked)
+{
+  checked->routes[key] = key * 2;
+}
+
+void snapshotReader(SnapshotPtr<Checked>* snapshot, std::atomic<int64_t>* reads)
+{
+  int64_t n = 0;
+  size_t last = 0;
+  while (g_running.load(std::memory_order_relaxed))
+  {
+    Rcu::ReadGuard guard;
+    const Checked* c = snapshot->get();
+    assert(c->alive == kAlive);
+    assert(c->routes.size() >= last);
+    last = c->routes.size();
+    (void)last;
+    {
+    Rcu::ReadGuard nested;
+    assert(snapshot->get()->alive == kAlive);
+    }
+    for (const auto& it : c->routes)
+    {
+      assert(it.second == it.first * 2);
+      (void)it;
+    }
+    assert(c->alive == kAlive);
+    ++n;
+  }
+  *reads += n;
+}
+
+// readers never see a deleted snapshot.
+void testSnapshot()
+{
+  SnapshotPtr<Checked> snapshot(std::unique_ptr<Checked>(new Checked));
+  std::atomic<int64_t> reads(0);
+  std::vector<std::unique_ptr<Thread>> readers;
+  for (int i = 0; i < 3; ++i)
+  {
+    readers.emplace_back(new Thread(std::bind(snapshotReader, &snapshot, &reads), "reader"));
+    readers.back()->start();
+  }
+  for (int i = 0; i < 1000; ++i)
+  {
+    snapshot.modify(std::bind(addRoute, i, std::placeholders::_1));
+  }
+  g_running = false;
+  for (auto& thr : readers)
+  {
+    thr->join();
+  }
+  {
+  Rcu::ReadGuard guard;
+  assert(snapshot.get()->routes.size() == 1000);
+  }
+  printf("%" PRId64 " reads over 1000 updates\n", reads.load());
+}
+
+// read throughput of a small routing table, while a writer updates every ms.
+class Bench
+{
+ public:
+  virtual ~Bench() = default;
+  virtual int lookup(int key) = 0;
+  virtual void update(int version) = 0;
+};
+
+Routes makeRoutes(int version)
+{
+  Routes routes;
+  for (int i = 0; i < 16; ++i)
+  {
+    routes[i] = version;
+  }
+  return routes;
+}
+
+// the copy on write idiom of examples/asio/chat/server_threaded_efficient.cc
+class CowBench : public Bench
+{
+ public:
+  CowBench() : routes_(new Routes(makeRoutes(0))) { }
+
+  int lookup(int key) override
+  {
+    std::shared_ptr<Routes> routes;
+    {
+    MutexLockGuard lock(mutex_);
+    routes = routes_;
+    }
+    return routes->find(key)->second;
+  }
+
+  void update(int version) override
+  {
+    std::shared_ptr<Routes> routes(new Routes(makeRoutes(version)));
+    MutexLockGuard lock(mutex_);
+    routes_.swap(routes);
+  }
+
+ private:
+  MutexLock mutex_;
+  std::shared_ptr<Routes> routes_;
+};
+
+class RcuBench : public Bench
+{
+ public:
+  RcuBench() : routes_(std::unique_ptr<Routes>(new Routes(makeRoutes(0)))) { }
+
+  int lookup(int key) override
+  {
+    Rcu::ReadGuard guard;
+    return routes_.get()->find(key)->second;
+  }
+
+  void update(int version) override
+  {
+    routes_.update(std::unique_ptr<Routes>(new Routes(makeRoutes(version))));
+  }
+
+ private:
+  SnapshotPtr<Routes> routes_;
+};
+
+// a POD stands for the table, as SeqLock can't hold a map.
+struct Pod
+{
+  int values[16];
+};
+
+class SeqLockBench : public Bench
+{
+ public:
+  int lookup(int key) override
+  {
+    return pod_.load().values[key];
+  }
+
+  void update(int version) override
+  {
+    Pod pod;
+    for (int& v : pod.values)
+    {
+      v = version;
+    }
+    pod_.store(pod);
+  }
+
+ private:
+  SeqLock<Pod> pod_;
+};
+
+void benchReader(Bench* bench, std::atomic<bool>* running, std::atomic<int64_t>* lookups)
+{
+  int64_t n = 0;
+  int sum = 0;
+  while (running->load(std::memory_order_relaxed))
+  {
+    sum += bench->lookup(static_cast<int>(n & 15));
+    ++n;
+  }
+  assert(sum >= 0);
+  (void)sum;
+  *lookups += n;
+}
+
+double runBench(Bench* bench, int numThreads)
+{
+  const double kSeconds = 0.5;
+  std::atomic<bool> running(true);
+  std::atomic<int64_t> lookups(0);
+  std::vector<std::unique_ptr<Thread>> readers;
+  for (int i = 0; i < numThreads; ++i)
+  {
+    readers.emplace_back(new Thread(std::bind(benchReader, bench, &running, &lookups), "reader"));
+    readers.back()->start();
+  }
+  Timestamp start(Timestamp::now());
+  int version = 0;
+  while (timeDifference(Timestamp::now(), start) < kSeconds)
+  {
+    bench->update(++version);
+    CurrentThread::sleepUsec(1000);
+  }
+  running = false;
+  for (auto& thr : readers)
+  {
+    thr->join();
+  }
+  return static_cast<double>(lookups.load()) / timeDifference(Timestamp::now(), start);
+}
+
+// usage: rcu_unittest [bench]
+int main(int argc, char* argv[])
+{
+  testSnapshot();
+  if (argc < 2)
+  {
+    return 0;
+  }
+
+  CowBench cow;
+  RcuBench rcu;
+  SeqLockBench seqlock;
+  for (int threads = 1; threads <= 4; threads *= 2)
+  {
+    printf("%d readers, M lookups/s: mutex+shared_ptr %.2f, SnapshotPtr %.2f, SeqLock %.2f\n",
+           threads,
+           runBench(&cow, threads) / 1e6,
+           runBench(&rcu, threads) / 1e6,
+           runBench(&seqlock, threads) / 1e6);
+  }
+}
@@ -0,0 +1,87 @@
+#include <muduo/base/SeqLock.h>
+#include <muduo/base/Thread.h>
+
+#include <atomic>
+#include <vector>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+struct Quote
+{
+  int64_t seq;
+  double bid;
+  double ask;
+  int64_t check;  // = seq, a torn read would show
+};
+
+SeqLock<Quote> g_quote;
+std::atomic<bool> g_running(true);
+std::atomic<int64_t> g_reads(0);
+
+void reader()
+{
+  int64_t reads = 0;
+  while (g_running.load(std::memory_order_relaxed))
+  {
+    Quote q = g_quote.load();
+    (void)q;
+    assert(q.seq == q.check);
+    assert(q.seq == 0 || (q.bid == static_cast<double>(q.seq) && q.ask == q.bid + 1));
+    ++reads;
+  }
+  g_reads += reads;
+}
+
+void writer(int id)
+{
+  for (int64_t i = 1; i <= 100000; ++i)
+  {
+    Quote q = { i * 2 + id, 0, 0, 0 };
+    q.bid = static_cast<double>(q.seq);
+    q.ask = q.bid + 1;
+    q.check = q.seq;
+    g_quote.store(q);
+  }
+}
+
+int main()
+{
+  static_assert(SeqLock<Quote>::kWords == 4, "");
+  Quote q = g_quote.load();
+  assert(q.seq == 0 && q.check == 0);
+  assert(g_quote.version() == 1);
+
+  SeqLock<char> c('x');
+  assert(c.load() == 'x');
+  c.store('y');
+  assert(c.load() == 'y' && c.version() == 2);
+
+  std::vector<std::unique_ptr<Thread>> readers;
+  for (int i = 0; i < 3; ++i)
+  {
+    readers.emplace_back(new Thread(reader, "reader"));
+    readers.back()->start();
+  }
+  // writers are serialized by seq_, not by caller.
+  Thread writer0(std::bind(writer, 0), "writer0");
+  Thread writer1(std::bind(writer, 1), "writer1");
+  writer0.start();
+  writer1.start();
+  writer0.join();
+  writer1.join();
+  g_running = false;
+  for (auto& thr : readers)
+  {
+    thr->join();
+  }
+  printf("%" PRId64 " reads, version %u\n", g_reads.load(), g_quote.version());
+  assert(g_quote.version() == 1 + 200000);
+  q = g_quote.load();
+  assert(q.seq == 200000 || q.seq == 200001);
+}
@@ -0,0 +1,113 @@
+#include <muduo/base/ShardedCounter.h>
+#include <muduo/base/Atomic.h>
+#include <muduo/base/Thread.h>
+#include <muduo/base/Timestamp.h>
+
+#include <vector>
+
+#include <assert.h>
+#include <stdio.h>
+
+using namespace muduo;
+
+const int kThreads = 4;
+const int kCount = 10*1000*1000;
+
+ShardedCounter g_requests("test.requests");
+ShardedGauge g_connections("test.connections");
+AtomicInt64 g_atomic;
+
+void addSharded()
+{
+  for (int i = 0; i < kCount; ++i)
+  {
+    g_requests.increment();
+  }
+}
+
+void addAtomic()
+{
+  for (int i = 0; i < kCount; ++i)
+  {
+    g_atomic.increment();
+  }
+}
+
+void addRelaxed()
+{
+  for (int i = 0; i < kCount; ++i)
+  {
+    g_atomic.addRelaxed(1);
+  }
+}
+
+void upAndDown()
+{
+  for (int i = 0; i < 1000; ++i)
+  {
+    g_connections.increment();
+  }
+  for (int i = 0; i < 990; ++i)
+  {
+    g_connections.decrement();
+  }
+}
+
+double run(void (*func)())
+{
+  Timestamp start(Timestamp::now());
+  std::vector<std::unique_ptr<Thread>> threads;
+  for (int i = 0; i < kThreads; ++i)
+  {
+    threads.emplace_back(new Thread(func));
+    threads.back()->start();
+  }
+  for (auto& thr : threads)
+  {
+    thr->join();
+  }
+  return timeDifference(Timestamp::now(), start);
+}
+
+int main()
+{
+  printf("%d shards\n", ShardedStats::numShards());
+  assert(ShardedStats::numShards() >= 1);
+  assert((ShardedStats::numShards() & (ShardedStats::numShards() - 1)) == 0);
+
+  run(upAndDown);
+  assert(g_connections.value() == kThreads * 10);
+  g_connections.add(-5);
+  assert(g_connections.value() == kThreads * 10 - 5);
+
+  {
+  // same name is summed, unnamed is not shown.
+  ShardedCounter other("test.requests");
+  ShardedCounter unnamed;
+  other.add(7);
+  unnamed.add(3);
+  assert(ShardedStats::value("test.requests") == 7);
+  string report = ShardedStats::report();
+  printf("%s", report.c_str());
+  assert(report.find("test.connections 35\ntest.requests 7\n") != string::npos);
+  assert(ShardedStats::report("test.c") == "test.connections 35\n");
+  assert(ShardedStats::report("nothing").empty());
+  }
+  assert(ShardedStats::value("test.requests") == 0);
+
+  double sharded = run(addSharded);
+  assert(g_requests.value() == static_cast<int64_t>(kThreads) * kCount);
+  double atomic = run(addAtomic);
+  assert(g_atomic.get() == static_cast<int64_t>(kThreads) * kCount);
+  double relaxed = run(addRelaxed);
+  assert(g_atomic.getRelaxed() == 2 * static_cast<int64_t>(kThreads) * kCount);
+  printf("%d threads, ns per increment: ShardedCounter %.2f, AtomicInt64 %.2f, relaxed %.2f\n",
+         kThreads,
+         sharded * 1e9 / kCount / kThreads,
+         atomic * 1e9 / kCount / kThreads,
+         relaxed * 1e9 / kCount / kThreads);
+
+  g_requests.reset();
+  assert(g_requests.value() == 0);
+  assert(g_atomic.incrementAndGetRelaxed() == 2 * static_cast<int64_t>(kThreads) * kCount + 1);
+}
@@ -1,7 +1,13 @@
 #include <muduo/base/ThreadPool.h>
+#include <muduo/base/WorkStealingThreadPool.h>
 #include <muduo/base/CountDownLatch.h>
 #include <muduo/base/CurrentThread.h>
 #include <muduo/base/Logging.h>
+#include <muduo/base/Timestamp.h>
+
+#include <atomic>
+
+#include <assert.h>
 
 #include <stdio.h>
 #include <unistd.h>  // usleep
@@ -17,10 +23,11 @@ void printString(const std::string& str)
   usleep(100*1000);
 }
 
+template<typename Pool>
 void test(int maxSize)
 {
   LOG_WARN << "Test ThreadPool with max queue size = " << maxSize;
-  muduo::ThreadPool pool("MainThreadPool");
+  Pool pool("MainThreadPool");
   pool.setMaxQueueSize(maxSize);
   pool.start(5);
 
@@ -41,11 +48,177 @@ void test(int maxSize)
   pool.stop();
 }
 
-int main()
+void sleepTask(int ms)
+{
+  usleep(ms * 1000);
+}
+
+void testElastic()
+{
+  LOG_WARN << "Test elastic ThreadPool";
+  muduo::ThreadPool pool("ElasticThreadPool");
+  pool.setTargetQueueDelay(0.005);
+  pool.setIdleTimeout(0.5);
+  pool.startElastic(1, 8);
+  assert(pool.numThreads() == 1);
+
+  // burst
+  for (int i = 0; i < 200; ++i)
+  {
+    pool.run(std::bind(sleepTask, 5));
+  }
+  muduo::CountDownLatch latch(1);
+  pool.run(std::bind(&muduo::CountDownLatch::countDown, &latch));
+  latch.wait();
+  int busyThreads = pool.numThreads();
+  printf("threads after burst %d\n", busyThreads);
+  printf("queue delay  %s\n", pool.queueDelay().toString().c_str());
+  printf("service time %s\n", pool.serviceTime().toString().c_str());
+  assert(busyThreads == 8);
+
+  // idle
+  sleep(2);
+  int idleThreads = pool.numThreads();
+  printf("threads after idle %d\n", idleThreads);
+  assert(idleThreads == 1);
+  pool.stop();
+}
+
+// throughput of tiny tasks
+
+struct Counter
+{
+  std::atomic<int64_t> done;
+  int64_t total;
+  muduo::CountDownLatch latch;
+
+  explicit Counter(int64_t n)
+    : done(0), total(n), latch(1)
+  {
+  }
+};
+
+void tinyTask(Counter* counter)
+{
+  if (counter->done.fetch_add(1, std::memory_order_relaxed) + 1 == counter->total)
+  {
+    counter->latch.countDown();
+  }
+}
+
+// runs in pool, spawns children from worker thread
+template<typename Pool>
+void spawnTask(Pool* pool, Counter* counter, int children)
+{
+  for (int i = 0; i < children; ++i)
+  {
+    pool->run(std::bind(tinyTask, counter));
+  }
+  tinyTask(counter);
+}
+
+// ThreadPool has no runBatch(), batchSize is ignored.
+template<typename Pool>
+void runAll(Pool* pool, Counter* counter, int numTasks, int batchSize)
+{
+  for (int i = 0; i < numTasks; ++i)
+  {
+    pool->run(std::bind(tinyTask, counter));
+  }
+}
+
+template<>
+void runAll(muduo::WorkStealingThreadPool* pool, Counter* counter, int numTasks, int batchSize)
+{
+  if (batchSize <= 1)
+  {
+    for (int i = 0; i < numTasks; ++i)
+    {
+      pool->run(std::bind(tinyTask, counter));
+    }
+    return;
+  }
+  std::vector<muduo::WorkStealingThreadPool::Task> tasks;
+  tasks.reserve(batchSize);
+  for (int i = 0; i < numTasks; ++i)
+  {
+    tasks.push_back(std::bind(tinyTask, counter));
+    if (static_cast<int>(tasks.size()) == batchSize || i == numTasks - 1)
+    {
+      pool->runBatch(&tasks);
+    }
+  }
+}
+
+// runBatch() larger than max queue size blocks till workers take them.
+void testBatch()
+{
+  LOG_WARN << "Test WorkStealingThreadPool::runBatch with max queue size = 10";
+  muduo::WorkStealingThreadPool pool("BatchThreadPool");
+  pool.setMaxQueueSize(10);
+  pool.start(2);
+  Counter counter(1000);
+  runAll(&pool, &counter, 1000, 100);
+  counter.latch.wait();
+  assert(counter.done.load() == 1000);
+  pool.stop();
+}
+
+template<typename Pool>
+void bench(const char* name, int numThreads, int numTasks, int batchSize, int children)
 {
-  test(0);
-  test(1);
-  test(5);
-  test(10);
-  test(50);
+  Pool pool(name);
+  pool.start(numThreads);
+  Counter counter(children > 0 ? static_cast<int64_t>(numTasks) * (children + 1) : numTasks);
+
+  muduo::Timestamp start(muduo::Timestamp::now());
+  if (children > 0)
+  {
+    for (int i = 0; i < numTasks; ++i)
+    {
+      pool.run(std::bind(spawnTask<Pool>, &pool, &counter, children));
+    }
+  }
+  else
+  {
+    runAll(&pool, &counter, numTasks, batchSize);
+  }
+  counter.latch.wait();
+  double seconds = muduo::timeDifference(muduo::Timestamp::now(), start);
+  printf("%-24s threads %2d batch %4d spawn %3d %10.0f tasks/s\n",
+         name, numThreads, batchSize, children,
+         static_cast<double>(counter.total) / seconds);
+  pool.stop();
+}
+
+void benchAll()
+{
+  const int kTasks = 200 * 1000;
+  int threads[] = { 1, 4, 8, 32 };
+  for (int n : threads)
+  {
+    bench<muduo::ThreadPool>("ThreadPool", n, kTasks, 1, 0);
+    bench<muduo::WorkStealingThreadPool>("WorkStealingThreadPool", n, kTasks, 1, 0);
+    bench<muduo::WorkStealingThreadPool>("WorkStealingThreadPool", n, kTasks, 256, 0);
+    bench<muduo::ThreadPool>("ThreadPool", n, kTasks / 100, 1, 99);
+    bench<muduo::WorkStealingThreadPool>("WorkStealingThreadPool", n, kTasks / 100, 1, 99);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc > 1)
+  {
+    benchAll();
+    return 0;
+  }
+  test<muduo::ThreadPool>(0);
+  test<muduo::ThreadPool>(1);
+  test<muduo::ThreadPool>(5);
+  test<muduo::ThreadPool>(10);
+  test<muduo::ThreadPool>(50);
+  test<muduo::WorkStealingThreadPool>(0);
+  test<muduo::WorkStealingThreadPool>(10);
+  testElastic();
+  testBatch();
 }
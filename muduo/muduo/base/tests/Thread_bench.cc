@@ -1,4 +1,8 @@
+#include <muduo/base/BlockingQueue.h>
+#include <muduo/base/Condition.h>
+#include <muduo/base/CountDownLatch.h>
 #include <muduo/base/CurrentThread.h>
+#include <muduo/base/Futex.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Thread.h>
 #include <muduo/base/Timestamp.h>
@@ -49,9 +53,134 @@ void forkBench()
   printf("number of created processes %d\n", kProcesses);
 }
 
+const int kRounds = 1000*1000;
+
+muduo::BlockingQueue<int> g_ping;
+muduo::BlockingQueue<int> g_pong;
+muduo::FutexSemaphore g_pingSem;
+muduo::FutexSemaphore g_pongSem;
+
+void pongQueue()
+{
+  for (int i = 0; i < kRounds; ++i)
+  {
+    g_pong.put(g_ping.take());
+  }
+}
+
+void pongSemaphore()
+{
+  for (int i = 0; i < kRounds; ++i)
+  {
+    g_pingSem.wait();
+    g_pongSem.post();
+  }
+}
+
+void countDownLatch(muduo::CountDownLatch* latch)
+{
+  for (int i = 0; i < kRounds; ++i)
+  {
+    latch->countDown();
+  }
+}
+
+void countDownFutexLatch(muduo::FutexLatch* latch)
+{
+  for (int i = 0; i < kRounds; ++i)
+  {
+    latch->countDown();
+  }
+}
+
+// Condition, CountDownLatch and BlockingQueue vs. Futex.h
+void syncBench()
+{
+  // notify with nobody waiting, as in ThreadPool::run() and AsyncLogging::append().
+  muduo::MutexLock mutex;
+  muduo::Condition cond(mutex);
+  muduo::Timestamp start(muduo::Timestamp::now());
+  for (int i = 0; i < kRounds; ++i)
+  {
+    muduo::MutexLockGuard lock(mutex);
+    cond.notify();
+  }
+  double condition = timeDifference(muduo::Timestamp::now(), start);
+
+  muduo::FutexEvent event;
+  start = muduo::Timestamp::now();
+  for (int i = 0; i < kRounds; ++i)
+  {
+    event.notify();
+  }
+  double futexEvent = timeDifference(muduo::Timestamp::now(), start);
+  printf("notify without waiter: Condition %.2f ns, FutexEvent %.2f ns\n",
+         condition * 1e9 / kRounds, futexEvent * 1e9 / kRounds);
+
+  // ping-pong between two threads, every round may block.
+  start = muduo::Timestamp::now();
+  {
+  muduo::Thread thr(pongQueue);
+  thr.start();
+  for (int i = 0; i < kRounds; ++i)
+  {
+    g_ping.put(i);
+    g_pong.take();
+  }
+  thr.join();
+  }
+  double queue = timeDifference(muduo::Timestamp::now(), start);
+
+  start = muduo::Timestamp::now();
+  {
+  muduo::Thread thr(pongSemaphore);
+  thr.start();
+  for (int i = 0; i < kRounds; ++i)
+  {
+    g_pingSem.post();
+    g_pongSem.wait();
+  }
+  thr.join();
+  }
+  double semaphore = timeDifference(muduo::Timestamp::now(), start);
+  printf("ping-pong round trip: BlockingQueue %.2f us, FutexSemaphore %.2f us\n",
+         queue * 1e6 / kRounds, semaphore * 1e6 / kRounds);
+
+  // two threads counting down, main thread waiting.
+  start = muduo::Timestamp::now();
+  {
+  muduo::CountDownLatch latch(2 * kRounds);
+  muduo::Thread t1(std::bind(countDownLatch, &latch));
+  muduo::Thread t2(std::bind(countDownLatch, &latch));
+  t1.start();
+  t2.start();
+  latch.wait();
+  t1.join();
+  t2.join();
+  }
+  double countDown = timeDifference(muduo::Timestamp::now(), start);
+
+  start = muduo::Timestamp::now();
+  {
+  muduo::FutexLatch latch(2 * kRounds);
+  muduo::Thread t1(std::bind(countDownFutexLatch, &latch));
+  muduo::Thread t2(std::bind(countDownFutexLatch, &latch));
+  t1.start();
+  t2.start();
+  latch.wait();
+  t1.join();
+  t2.join();
+  }
+  double futexLatch = timeDifference(muduo::Timestamp::now(), start);
+  printf("countDown: CountDownLatch %.2f ns, FutexLatch %.2f ns\n",
+         countDown * 1e9 / kRounds / 2, futexLatch * 1e9 / kRounds / 2);
+}
+
 int main(int argc, char* argv[])
 {
   printf("pid=%d, tid=%d\n", ::getpid(), muduo::CurrentThread::tid());
+  syncBench();
+
   muduo::Timestamp start(muduo::Timestamp::now());
 
   int kThreads = 100*1000;
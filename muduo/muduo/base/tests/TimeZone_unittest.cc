@@ -1,10 +1,17 @@
 #include <muduo/base/TimeZone.h>
+#include <muduo/base/Timestamp.h>
 #include <muduo/base/Types.h>
 
+#include <vector>
+
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
 
+using muduo::string;
 using muduo::TimeZone;
 
 struct tm getTm(int year, int month, int day,
@@ -265,6 +272,101 @@ void testFixedTimezone()
   }
 }
 
+string format(const struct tm& tm)
+{
+  char buf[64];
+  strftime(buf, sizeof buf, "%F %T %j%z(%Z)", &tm);
+  return string(buf) + (tm.tm_isdst ? " dst" : "");
+}
+
+// cached toLocalTime() of two zones in turn, and bulk toLocalTime(), against
+// localtime_r() of glibc.
+void testCached()
+{
+  setenv("TZ", ":America/New_York", 1);
+  tzset();
+  TimeZone newYork("/usr/share/zoneinfo/America/New_York");
+  TimeZone sydney("/usr/share/zoneinfo/Australia/Sydney");
+
+  std::vector<time_t> seconds;
+  for (time_t t = getGmt("2006-01-01 00:00:00"); t < getGmt("2012-01-01 00:00:00"); t += 997)
+  {
+    seconds.push_back(t);
+  }
+  // backwards too, leaves intervals on the other side.
+  seconds.insert(seconds.end(), seconds.rbegin(), seconds.rend());
+
+  std::vector<struct tm> bulk(seconds.size());
+  newYork.toLocalTime(seconds.data(), seconds.size(), bulk.data());
+  for (size_t i = 0; i < seconds.size(); ++i)
+  {
+    struct tm expected;
+    localtime_r(&seconds[i], &expected);
+    struct tm local = newYork.toLocalTime(seconds[i]);
+    sydney.toLocalTime(seconds[i]);
+    if (format(local) != format(expected) || format(bulk[i]) != format(expected))
+    {
+      printf("WRONG: %ld %s %s %s\n", static_cast<long>(seconds[i]),
+             format(expected).c_str(), format(local).c_str(), format(bulk[i]).c_str());
+      assert(0);
+    }
+    assert(newYork.fromLocalTime(local) == seconds[i] || local.tm_isdst);
+  }
+
+  TimeZone invalid("/notexist");
+  struct tm local = invalid.toLocalTime(seconds[0]);
+  assert(local.tm_year == 0 && local.tm_zone == NULL);
+  (void) local;
+  printf("testCached %zd PASSED\n", seconds.size());
+}
+
+// seconds of a day of logs, 10 lines per second.
+void benchToLocalTime()
+{
+  std::vector<time_t> seconds;
+  const time_t start = getGmt("2011-11-06 00:00:00");
+  for (int i = 0; i < 10*24*3600; ++i)
+  {
+    seconds.push_back(start + i / 10);
+  }
+  TimeZone tz("/usr/share/zoneinfo/America/New_York");
+  std::vector<struct tm> localTimes(seconds.size());
+  int64_t sum = 0;
+
+  muduo::Timestamp begin(muduo::Timestamp::now());
+  for (size_t i = 0; i < seconds.size(); ++i)
+  {
+    localtime_r(&seconds[i], &localTimes[i]);
+    sum += localTimes[i].tm_sec;
+  }
+  double glibc = timeDifference(muduo::Timestamp::now(), begin);
+
+  begin = muduo::Timestamp::now();
+  for (size_t i = 0; i < seconds.size(); ++i)
+  {
+    gmtime_r(&seconds[i], &localTimes[i]);
+    sum += localTimes[i].tm_sec;
+  }
+  double gmtime = timeDifference(muduo::Timestamp::now(), begin);
+
+  begin = muduo::Timestamp::now();
+  for (size_t i = 0; i < seconds.size(); ++i)
+  {
+    localTimes[i] = tz.toLocalTime(seconds[i]);
+    sum += localTimes[i].tm_sec;
+  }
+  double single = timeDifference(muduo::Timestamp::now(), begin);
+
+  begin = muduo::Timestamp::now();
+  tz.toLocalTime(seconds.data(), seconds.size(), localTimes.data());
+  double bulk = timeDifference(muduo::Timestamp::now(), begin);
+
+  const double n = static_cast<double>(seconds.size());
+  printf("ns per conversion: localtime_r %.1f, gmtime_r %.1f, "
+         "toLocalTime %.1f, bulk toLocalTime %.1f (%" PRId64 ")\n",
+         glibc * 1e9 / n, gmtime * 1e9 / n, single * 1e9 / n, bulk * 1e9 / n, sum);
+}
+
 int main()
 {
   testNewYork();
@@ -273,4 +375,6 @@ int main()
   testHongKong();
   testFixedTimezone();
   testUtc();
+  testCached();
+  benchToLocalTime();
 }
@@ -15,6 +15,7 @@
 #include <muduo/net/SocketsOps.h>
 
 #include <errno.h>
+#include <stdlib.h>
 
 using namespace muduo;
 using namespace muduo::net;
@@ -26,7 +27,10 @@ Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
     serverAddr_(serverAddr),
     connect_(false),
     state_(kDisconnected),
-    retryDelayMs_(kInitRetryDelayMs)
+    initRetryDelayMs_(kInitRetryDelayMs),
+    maxRetryDelayMs_(kMaxRetryDelayMs),
+    retryDelayMs_(kInitRetryDelayMs),
+    retryJitter_(false)
 {
   LOG_DEBUG << "ctor[" << this << "]";
 }
@@ -116,11 +120,18 @@ void Connector::connect()
   }
 }
 
+void Connector::setRetryDelay(double initSeconds, double maxSeconds)
+{
+  initRetryDelayMs_ = std::max(1, static_cast<int>(initSeconds * 1000));
+  maxRetryDelayMs_ = std::max(initRetryDelayMs_, static_cast<int>(maxSeconds * 1000));
+  retryDelayMs_ = initRetryDelayMs_;
+}
+
 void Connector::restart()
 {
   loop_->assertInLoopThread();
   setState(kDisconnected);
-  retryDelayMs_ = kInitRetryDelayMs;
+  retryDelayMs_ = initRetryDelayMs_;
   connect_ = true;
   startInLoop();
 }
@@ -210,11 +221,16 @@ void Connector::retry(int sockfd)
   setState(kDisconnected);
   if (connect_)
   {
+    int delayMs = retryDelayMs_;
+    if (retryJitter_)
+    {
+      delayMs = retryDelayMs_ / 2 + static_cast<int>(::random() % (retryDelayMs_ / 2 + 1));
+    }
     LOG_INFO << "Connector::retry - Retry connecting to " << serverAddr_.toIpPort()
-             << " in " << retryDelayMs_ << " milliseconds. ";
-    loop_->runAfter(retryDelayMs_/1000.0,
+             << " in " << delayMs << " milliseconds. ";
+    loop_->runAfter(delayMs/1000.0,
                     std::bind(&Connector::startInLoop, shared_from_this()));
-    retryDelayMs_ = std::min(retryDelayMs_ * 2, kMaxRetryDelayMs);
+    retryDelayMs_ = std::min(retryDelayMs_ * 2, maxRetryDelayMs_);
   }
   else
   {
@@ -56,8 +56,13 @@ private:
   ///> see start() --> startInLoop() --> connect() --> connecting() -->
   ///  handleWrite() --> newConnectionCallback_()
   NewConnectionCallback newConnectionCallback_;
-  ///> micro seconds of retry connection.
+  ///> milli seconds of retry connection, doubles from init to max.
+  int initRetryDelayMs_;
+  int maxRetryDelayMs_;
   int retryDelayMs_;
+  ///> randomize retry delay in [retryDelayMs_/2, retryDelayMs_], so that many
+  ///  connectors do not reconnect to a restarted server at the same time.
+  bool retryJitter_;
 
 public:
   Connector(EventLoop* loop, const InetAddress& serverAddr);
@@ -71,6 +76,10 @@ public:
   void stop();  // can be called in any thread
 
   const InetAddress& serverAddress() const { return serverAddr_; }
+  void enableRetryJitter() { retryJitter_ = true; }
+  /// Retry delay doubles from @c initSeconds to @c maxSeconds,
+  /// 0.5 to 30 seconds by default. Must be called before @c start
+  void setRetryDelay(double initSeconds, double maxSeconds);
 
 private:  
   void setState(States s) { state_ = s; }
@@ -0,0 +1,553 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_COROUTINE_H
+#define MUDUO_NET_COROUTINE_H
+
+// muduo itself is built with -std=c++11, this header is usable from
+// translation units compiled with -std=c++20 (or later), it is empty otherwise.
+#if defined(__cpp_impl_coroutine) && __cplusplus >= 202002L
+
+#include <muduo/base/Exception.h>
+#include <muduo/base/ThreadPool.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpConnection.h>
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace muduo
+{
+namespace net
+{
+
+namespace detail
+{
+
+/** class FramePool
+ * - Brief:
+ *    free lists of coroutine frames, one pool per thread, so one per loop.
+ *    frames are rounded up to kGranularity bytes, at most kMaxCached frames
+ *    of each size are kept, frames larger than kMaxFrameSize use malloc.
+ */
+class FramePool : noncopyable
+{
+public:
+  static const size_t kGranularity = 64;
+  static const size_t kNumClasses = 32;
+  static const size_t kMaxFrameSize = kGranularity * kNumClasses;
+  static const int kMaxCached = 256;
+
+private:
+  struct Node
+  {
+    Node* next;
+  };
+
+  Node* freeList_[kNumClasses] = {};
+  int numCached_[kNumClasses] = {};
+
+public:
+  FramePool() = default;
+  ~FramePool()
+  {
+    for (Node* head : freeList_)
+    {
+      while (head)
+      {
+        Node* next = head->next;
+        ::free(head);
+        head = next;
+      }
+    }
+  }
+
+  static FramePool& instance()
+  {
+    static thread_local FramePool pool;
+    return pool;
+  }
+
+  void* allocate(size_t size)
+  {
+    if (size > kMaxFrameSize)
+    {
+      return mallocOrThrow(size);
+    }
+    size_t index = classIndex(size);
+    if (Node* node = freeList_[index])
+    {
+      freeList_[index] = node->next;
+      --numCached_[index];
+      return node;
+    }
+    return mallocOrThrow((index + 1) * kGranularity);
+  }
+
+  void deallocate(void* p, size_t size)
+  {
+    if (size > kMaxFrameSize)
+    {
+      ::free(p);
+      return;
+    }
+    size_t index = classIndex(size);
+    if (numCached_[index] >= kMaxCached)
+    {
+      ::free(p);
+      return;
+    }
+    Node* node = static_cast<Node*>(p);
+    node->next = freeList_[index];
+    freeList_[index] = node;
+    ++numCached_[index];
+  }
+
+private:
+  static size_t classIndex(size_t size)
+  { return size == 0 ? 0 : (size - 1) / kGranularity; }
+
+  static void* mallocOrThrow(size_t size)
+  {
+    void* p = ::malloc(size);
+    if (p == NULL)
+    {
+      throw std::bad_alloc();
+    }
+    return p;
+  }
+};
+
+/// a detached task threw, nobody can catch it, same as a ThreadPool task.
+[[noreturn]] inline void abortDetached(std::exception_ptr exception) noexcept
+{
+  try
+  {
+    std::rethrow_exception(exception);
+  }
+  catch (const Exception& ex)
+  {
+    fprintf(stderr, "exception caught in detached Task\n");
+    fprintf(stderr, "reason: %s\n", ex.what());
+    fprintf(stderr, "stack trace: %s\n", ex.stackTrace());
+  }
+  catch (const std::exception& ex)
+  {
+    fprintf(stderr, "exception caught in detached Task\n");
+    fprintf(stderr, "reason: %s\n", ex.what());
+  }
+  catch (...)
+  {
+    fprintf(stderr, "unknown exception caught in detached Task\n");
+  }
+  abort();
+}
+
+struct PromiseBase
+{
+  std::coroutine_handle<> continuation;  ///< awaiting coroutine, if any.
+  std::exception_ptr exception;
+  bool detached = false;                 ///< frame frees itself when done.
+
+  struct FinalAwaiter
+  {
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+    {
+      PromiseBase& promise = h.promise();
+      if (promise.continuation)
+      {
+        return promise.continuation;
+      }
+      if (promise.detached)
+      {
+        std::exception_ptr exception = promise.exception;
+        h.destroy();
+        if (exception)
+        {
+          abortDetached(exception);
+        }
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept { }
+  };
+
+  static void* operator new(size_t size)
+  { return FramePool::instance().allocate(size); }
+  static void operator delete(void* p, size_t size)
+  { FramePool::instance().deallocate(p, size); }
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+
+  /// kept for the awaiting coroutine, or reported by FinalAwaiter of a
+  /// detached task after it frees the frame.
+  void unhandled_exception() noexcept
+  {
+    exception = std::current_exception();
+  }
+};
+
+template<typename T>
+struct Promise : PromiseBase
+{
+  std::optional<T> value;
+
+  template<typename U>
+  void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+  T result()
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+    return std::move(*value);
+  }
+};
+
+template<>
+struct Promise<void> : PromiseBase
+{
+  void return_void() const noexcept { }
+
+  void result()
+  {
+    if (exception)
+    {
+      std::rethrow_exception(exception);
+    }
+  }
+};
+
+///> resumes a suspended coroutine from EventLoop or ThreadPool.
+struct Resumer
+{
+  std::coroutine_handle<> handle;
+  void operator()() const { handle.resume(); }
+};
+
+}  // namespace detail
+
+/** class Task
+ * - Brief:
+ *    Task is a lazy coroutine, its frame comes from detail::FramePool of
+ *    the calling thread.
+ *    1) co_await task starts it, the caller is resumed when it finishes,
+ *       and gets its value or exception.
+ *    2) detach() starts a top level task (e.g. one per connection), the
+ *       frame is freed when it finishes, an exception out of it aborts
+ *       like one out of a ThreadPool task.
+ */
+template<typename T = void>
+class Task : noncopyable
+{
+public:
+  struct promise_type : detail::Promise<T>
+  {
+    Task get_return_object()
+    { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+  };
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+
+public:
+  Task(Task&& rhs) noexcept
+    : handle_(rhs.handle_)
+  {
+    rhs.handle_ = nullptr;
+  }
+
+  ~Task()
+  {
+    if (handle_)
+    {
+      handle_.destroy();
+    }
+  }
+
+  bool valid() const { return static_cast<bool>(handle_); }
+  bool done() const { return handle_.done(); }
+
+  /// Starts running in current thread, until its first suspension.
+  /// The task must not be awaited.
+  void detach()
+  {
+    assert(handle_);
+    std::coroutine_handle<promise_type> h = handle_;
+    handle_ = nullptr;
+    h.promise().detached = true;
+    h.resume();
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept
+  {
+    handle_.promise().continuation = caller;
+    return handle_;
+  }
+
+  T await_resume()
+  {
+    return handle_.promise().result();
+  }
+
+private:
+  explicit Task(std::coroutine_handle<promise_type> h)
+    : handle_(h)
+  {
+  }
+};
+
+/** class SleepAwaiter
+ * - Brief:
+ *    co_await asyncSleep(loop, seconds) resumes in loop after seconds.
+ */
+class SleepAwaiter
+{
+private:
+  EventLoop* loop_;
+  double seconds_;
+
+public:
+  SleepAwaiter(EventLoop* loop, double seconds)
+    : loop_(loop), seconds_(seconds)
+  {
+  }
+
+  bool await_ready() const noexcept { return seconds_ <= 0; }
+  void await_suspend(std::coroutine_handle<> h)
+  { loop_->runAfter(seconds_, detail::Resumer{h}); }
+  void await_resume() const noexcept { }
+};
+
+inline SleepAwaiter asyncSleep(EventLoop* loop, double seconds)
+{
+  return SleepAwaiter(loop, seconds);
+}
+
+/** class RunAwaiter
+ * - Brief:
+ *    co_await asyncRun(pool, f) runs f() in ThreadPool, then resumes in the
+ *    loop of current thread with the value (or exception) of f().
+ */
+template<typename F>
+class RunAwaiter
+{
+public:
+  typedef typename std::invoke_result<F>::type Result;
+
+private:
+  ThreadPool* pool_;
+  EventLoop* loop_;  ///< loop to resume in.
+  F func_;
+  detail::Promise<Result> result_;
+
+public:
+  RunAwaiter(ThreadPool* pool, EventLoop* loop, F func)
+    : pool_(pool), loop_(loop), func_(std::move(func))
+  {
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> h)
+  {
+    pool_->run(std::bind(&RunAwaiter::runInPool, this, h));
+  }
+
+  Result await_resume()
+  {
+    return result_.result();
+  }
+
+private:
+  void runInPool(std::coroutine_handle<> h)
+  {
+    try
+    {
+      if constexpr (std::is_void<Result>::value)
+      {
+        func_();
+      }
+      else
+      {
+        result_.return_value(func_());
+      }
+    }
+    catch (...)
+    {
+      result_.exception = std::current_exception();
+    }
+    loop_->queueInLoop(detail::Resumer{h});
+  }
+};
+
+/// Must be called in a loop thread.
+template<typename F>
+RunAwaiter<F> asyncRun(ThreadPool* pool, F func)
+{
+  EventLoop* loop = EventLoop::getEventLoopOfCurrentThread();
+  assert(loop != NULL);
+  return RunAwaiter<F>(pool, loop, std::move(func));
+}
+
+/** class CoConnection
+ * - Brief:
+ *    awaitable view of an established TcpConnection, replaces its
+ *    connection, message and write complete callbacks, so data is kept in
+ *    inputBuffer() until a coroutine reads it.
+ *    1) co_await readSome() returns inputBuffer() with some data, or NULL
+ *       after the connection was closed.
+ *    2) co_await readExactly(n) retrieves n bytes, or "" after the
+ *       connection was closed.
+ *    3) co_await drain() waits until outputBuffer() is empty, returns false
+ *       after the connection was closed.
+ *    Must be used in loop thread of the connection, one waiter at a time.
+ */
+class CoConnection : noncopyable
+{
+private:
+  struct State
+  {
+    std::coroutine_handle<> waiter;
+    size_t need = 0;        ///< bytes waiter needs, 0 if waiting for drain.
+    bool closed = false;
+  };
+  typedef std::shared_ptr<State> StatePtr;
+
+  TcpConnectionPtr conn_;
+  StatePtr state_;  ///< shared with callbacks, which may outlive this.
+
+public:
+  explicit CoConnection(const TcpConnectionPtr& conn)
+    : conn_(conn),
+      state_(std::make_shared<State>())
+  {
+    conn_->getLoop()->assertInLoopThread();
+    state_->closed = !conn_->connected();
+    conn_->setConnectionCallback(std::bind(&CoConnection::onConnection, state_, _1));
+    conn_->setMessageCallback(std::bind(&CoConnection::onMessage, state_, _1, _2));
+    conn_->setWriteCompleteCallback(std::bind(&CoConnection::onWriteComplete, state_, _1));
+  }
+
+  ~CoConnection()
+  {
+    state_->waiter = nullptr;
+  }
+
+  const TcpConnectionPtr& connection() const { return conn_; }
+  bool closed() const { return state_->closed; }
+
+  struct ReadAwaiter
+  {
+    State* state;
+    Buffer* buf;
+    size_t need;
+
+    bool await_ready() const noexcept
+    { return buf->readableBytes() >= need || state->closed; }
+    void await_suspend(std::coroutine_handle<> h) noexcept
+    {
+      assert(!state->waiter);
+      state->waiter = h;
+      state->need = need;
+    }
+  };
+
+  struct ReadSomeAwaiter : ReadAwaiter
+  {
+    Buffer* await_resume() const noexcept
+    { return buf->readableBytes() > 0 ? buf : NULL; }
+  };
+
+  struct ReadExactlyAwaiter : ReadAwaiter
+  {
+    string await_resume() const
+    { return buf->readableBytes() >= need ? buf->retrieveAsString(need) : string(); }
+  };
+
+  struct DrainAwaiter
+  {
+    State* state;
+    Buffer* buf;
+
+    bool await_ready() const noexcept
+    { return buf->readableBytes() == 0 || state->closed; }
+    void await_suspend(std::coroutine_handle<> h) noexcept
+    {
+      assert(!state->waiter);
+      state->waiter = h;
+      state->need = 0;
+    }
+    bool await_resume() const noexcept { return !state->closed; }
+  };
+
+  ReadSomeAwaiter readSome()
+  { return ReadSomeAwaiter{{get_pointer(state_), conn_->inputBuffer(), 1}}; }
+
+  ReadExactlyAwaiter readExactly(size_t n)
+  { return ReadExactlyAwaiter{{get_pointer(state_), conn_->inputBuffer(), n}}; }
+
+  DrainAwaiter drain()
+  { return DrainAwaiter{get_pointer(state_), conn_->outputBuffer()}; }
+
+private:
+  static void resume(const StatePtr& state)
+  {
+    std::coroutine_handle<> h = state->waiter;
+    state->waiter = nullptr;
+    h.resume();
+  }
+
+  static void onConnection(const StatePtr& state, const TcpConnectionPtr& conn)
+  {
+    if (!conn->connected())
+    {
+      state->closed = true;
+      if (state->waiter)
+      {
+        resume(state);
+      }
+    }
+  }
+
+  static void onMessage(const StatePtr& state, const TcpConnectionPtr&, Buffer* buf)
+  {
+    if (state->waiter && state->need > 0 && buf->readableBytes() >= state->need)
+    {
+      resume(state);
+    }
+  }
+
+  static void onWriteComplete(const StatePtr& state, const TcpConnectionPtr&)
+  {
+    if (state->waiter && state->need == 0)
+    {
+      resume(state);
+    }
+  }
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // MUDUO_NET_COROUTINE_H
@@ -14,6 +14,7 @@
 #include <muduo/net/Poller.h>
 #include <muduo/net/SocketsOps.h>
 #include <muduo/net/TimerQueue.h>
+#include <muduo/net/TimingWheel.h>
 
 #include <algorithm>
 
@@ -72,7 +73,8 @@ EventLoop::EventLoop()
     timerQueue_(new TimerQueue(this)),
     wakeupFd_(createEventfd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    currentActiveChannel_(NULL)
+    currentActiveChannel_(NULL),
+    mutex_("EventLoop")
 {
   LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
   if (t_loopInThisThread)
@@ -141,7 +143,7 @@ void EventLoop::quit()
   if (!isInLoopThread()) { wakeup(); }
 }
 
-void EventLoop::runInLoop(Functor cb)
+void EventLoop::runInLoop(InlineFunctor cb)
 {
   if (isInLoopThread())
   {
@@ -153,7 +155,7 @@ void EventLoop::runInLoop(Functor cb)
   }
 }
 
-void EventLoop::queueInLoop(Functor cb)
+void EventLoop::queueInLoop(InlineFunctor cb)
 {
   {
     MutexLockGuard lock(mutex_);
@@ -172,18 +174,18 @@ size_t EventLoop::queueSize() const
   return pendingFunctors_.size();
 }
 
-TimerId EventLoop::runAt(Timestamp time, TimerCallback cb)
+TimerId EventLoop::runAt(Timestamp time, InlineFunctor cb)
 {
   return timerQueue_->addTimer(std::move(cb), time, 0.0);
 }
 
-TimerId EventLoop::runAfter(double delay, TimerCallback cb)
+TimerId EventLoop::runAfter(double delay, InlineFunctor cb)
 {
   Timestamp time(addTime(Timestamp::now(), delay));
   return runAt(time, std::move(cb));
 }
 
-TimerId EventLoop::runEvery(double interval, TimerCallback cb)
+TimerId EventLoop::runEvery(double interval, InlineFunctor cb)
 {
   Timestamp time(addTime(Timestamp::now(), interval));
   return timerQueue_->addTimer(std::move(cb), time, interval);
@@ -194,6 +196,16 @@ void EventLoop::cancel(TimerId timerId)
   return timerQueue_->cancel(timerId);
 }
 
+TimingWheel* EventLoop::timingWheel()
+{
+  assertInLoopThread();
+  if (!timingWheel_)
+  {
+    timingWheel_.reset(new TimingWheel(this));
+  }
+  return get_pointer(timingWheel_);
+}
+
 void EventLoop::updateChannel(Channel* channel)
 {
   assert(channel->ownerLoop() == this);
@@ -251,18 +263,19 @@ void EventLoop::handleRead()
 
 void EventLoop::doPendingFunctors()
 {
-  std::vector<Functor> functors;
+  assert(runningFunctors_.empty());
   callingPendingFunctors_ = true;
 
   {
     MutexLockGuard lock(mutex_);
-    functors.swap(pendingFunctors_);
+    runningFunctors_.swap(pendingFunctors_);
   }
 
-  for (const Functor& functor : functors)
+  for (const InlineFunctor& functor : runningFunctors_)
   {
     functor();
   }
+  runningFunctors_.clear();
   callingPendingFunctors_ = false;
 }
 
@@ -17,6 +17,7 @@
 
 #include <boost/any.hpp>
 
+#include <muduo/base/InlineFunction.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/CurrentThread.h>
 #include <muduo/base/Timestamp.h>
@@ -31,6 +32,7 @@ namespace net
 class Channel;
 class Poller;
 class TimerQueue;
+class TimingWheel;
 
 ///
 /// Reactor, at most one per thread.
@@ -68,6 +70,11 @@ class EventLoop : noncopyable
 {
 public:
   typedef std::function<void()> Functor;
+  ///> what runInLoop() and timers take and keep, a Functor converts to it.
+  ///> move-only, common bind shapes are stored inline without allocation,
+  ///  as long as what they capture does not allocate itself, e.g. a string
+  ///  longer than its small string buffer (15 bytes in libstdc++).
+  typedef InlineFunction<void()> InlineFunctor;
 private:
   typedef std::vector<Channel*> ChannelList;
 
@@ -84,6 +91,8 @@ private:
   std::unique_ptr<Poller> poller_;
 
   std::unique_ptr<TimerQueue> timerQueue_;
+  ///> connection timeouts, created on first use. see timingWheel().
+  std::unique_ptr<TimingWheel> timingWheel_;
 
   ///> channels actived by epoll, then will call suitable handler.
   ChannelList activeChannels_;
@@ -96,7 +105,10 @@ private:
   ///> pend event function pointers. see EventLoop::runInLoop().
   ///> these tasks will be invoke in the thead of owner object. do not care
   ///  invoke runInLoop() in which thread.
-  std::vector<Functor> pendingFunctors_ /*GUARDED_BY(mutex_)*/;
+  std::vector<InlineFunctor> pendingFunctors_ /*GUARDED_BY(mutex_)*/;
+  ///> swapped with pendingFunctors_ in doPendingFunctors(), both keep their
+  ///  capacity, so queueing costs no allocation in steady state.
+  std::vector<InlineFunctor> runningFunctors_;
 
   boost::any context_; ///> custom data.
 
@@ -130,11 +142,11 @@ public:
   /// It wakes up the loop, and run the cb.
   /// If in the same loop thread, cb is run within the function.
   /// Safe to call from other threads.
-  void runInLoop(Functor cb);
+  void runInLoop(InlineFunctor cb);
   /// Queues callback in the loop thread.
   /// Runs after finish pooling.
   /// Safe to call from other threads.
-  void queueInLoop(Functor cb);
+  void queueInLoop(InlineFunctor cb);
 
   size_t queueSize() const;
 
@@ -144,22 +156,27 @@ public:
   /// Runs callback at 'time'.
   /// Safe to call from other threads.
   ///
-  TimerId runAt(Timestamp time, TimerCallback cb);
+  TimerId runAt(Timestamp time, InlineFunctor cb);
   ///
   /// Runs callback after @c delay seconds.
   /// Safe to call from other threads.
   ///
-  TimerId runAfter(double delay, TimerCallback cb);
+  TimerId runAfter(double delay, InlineFunctor cb);
   ///
   /// Runs callback every @c interval seconds.
   /// Safe to call from other threads.
   ///
-  TimerId runEvery(double interval, TimerCallback cb);
+  TimerId runEvery(double interval, InlineFunctor cb);
   ///
   /// Cancels the timer.
   /// Safe to call from other threads.
   ///
   void cancel(TimerId timerId);
+  ///
+  /// Coarse timing wheel (1 second tick) shared by connections of this loop.
+  /// Must be called in loop thread.
+  ///
+  TimingWheel* timingWheel();
 
   // internal usage
   ///> activate eventfd, let ::epoll_wait() retruned, then continua
@@ -0,0 +1,402 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/LogShipper.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/Endian.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpClient.h>
+#ifdef MUDUO_HAVE_ZLIB
+#include <muduo/net/ZlibStream.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+const double kStopSeconds = 3.0;
+const size_t kSpillChunk = 1024*1024;
+const uint32_t kMaxFrameLength = 256*1024*1024;
+
+struct FrameHeader
+{
+  uint32_t length;
+  uint32_t rawLength;
+  uint8_t flags;
+};
+
+void makeFrameHeader(uint32_t length, uint32_t rawLength, uint8_t flags, char* header)
+{
+  uint32_t be32 = sockets::hostToNetwork32(length);
+  memcpy(header, &be32, sizeof be32);
+  be32 = sockets::hostToNetwork32(rawLength);
+  memcpy(header + 4, &be32, sizeof be32);
+  header[8] = static_cast<char>(flags);
+}
+
+FrameHeader parseFrameHeader(const char* header)
+{
+  FrameHeader h;
+  uint32_t be32 = 0;
+  memcpy(&be32, header, sizeof be32);
+  h.length = sockets::networkToHost32(be32);
+  memcpy(&be32, header + 4, sizeof be32);
+  h.rawLength = sockets::networkToHost32(be32);
+  h.flags = static_cast<uint8_t>(header[8]);
+  return h;
+}
+
+bool validHeader(const FrameHeader& h)
+{
+  return h.length <= kMaxFrameLength
+      && h.rawLength <= kMaxFrameLength
+      && (h.flags & ~LogShipper::kCompressed) == 0
+      && ((h.flags & LogShipper::kCompressed) || h.length == h.rawLength);
+}
+
+}  // namespace
+
+LogShipper::LogShipper(const InetAddress& collectorAddr,
+                       const string& nameArg,
+                       const Options& options)
+  : options_(options),
+    loopThread_(EventLoopThread::ThreadInitCallback(), nameArg),
+    loop_(loopThread_.startLoop()),
+    client_(new TcpClient(loop_, collectorAddr, nameArg)),
+    spillFd_(-1),
+    spillRead_(0),
+    spillWrite_(0),
+    stopping_(false),
+    mutex_(),
+    cond_(mutex_),
+    stopped_(false),
+    sentBytes_(0),
+    spilledBytes_(0),
+    droppedBytes_(0)
+{
+#ifndef MUDUO_HAVE_ZLIB
+  if (options_.compress)
+  {
+    fprintf(stderr, "LogShipper: built without zlib, frames are not compressed\n");
+  }
+#endif
+  if (!options_.spillFile.empty())
+  {
+    spillFd_ = ::open(options_.spillFile.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (spillFd_ < 0)
+    {
+      fprintf(stderr, "LogShipper: open %s failed %s\n",
+              options_.spillFile.c_str(), strerror_tl(errno));
+    }
+    else
+    {
+      recoverSpill();
+    }
+  }
+  client_->setConnectionCallback(
+      std::bind(&LogShipper::onConnection, this, _1));
+  client_->setWriteCompleteCallback(
+      std::bind(&LogShipper::onWriteComplete, this, _1));
+  client_->enableRetry();
+  client_->connect();
+}
+
+LogShipper::~LogShipper()
+{
+  sendBatch();
+  loop_->runInLoop(std::bind(&LogShipper::stopInLoop, this));
+  {
+  MutexLockGuard lock(mutex_);
+  Timestamp deadline(addTime(Timestamp::now(), kStopSeconds));
+  while (!stopped_ && Timestamp::now() < deadline)
+  {
+    cond_.waitForSeconds(timeDifference(deadline, Timestamp::now()));
+  }
+  }
+  CountDownLatch latch(1);
+  loop_->runInLoop(std::bind(&LogShipper::closeInLoop, this, &latch));
+  latch.wait();
+  if (spillFd_ >= 0)
+  {
+    ::close(spillFd_);
+  }
+}
+
+void LogShipper::append(const char* data, size_t len)
+{
+  batch_.append(data, len);
+  if (batch_.readableBytes() >= options_.batchBytes)
+  {
+    sendBatch();
+  }
+}
+
+void LogShipper::flush()
+{
+  sendBatch();
+}
+
+void LogShipper::sendBatch()
+{
+  if (batch_.readableBytes() == 0)
+  {
+    return;
+  }
+  const uint32_t rawLength = static_cast<uint32_t>(batch_.readableBytes());
+  string frame(kFrameHeaderSize, '\0');
+  uint8_t flags = 0;
+#ifdef MUDUO_HAVE_ZLIB
+  if (options_.compress)
+  {
+    Buffer compressed;
+    {
+    ZlibOutputStream stream(&compressed);
+    stream.write(StringPiece(batch_.peek(), static_cast<int>(rawLength)));
+    stream.finish();
+    }
+    flags = kCompressed;
+    frame.append(compressed.peek(), compressed.readableBytes());
+  }
+  else
+#endif
+  {
+    frame.append(batch_.peek(), rawLength);
+  }
+  batch_.retrieveAll();
+  makeFrameHeader(static_cast<uint32_t>(frame.size() - kFrameHeaderSize),
+                  rawLength, flags, &*frame.begin());
+  loop_->runInLoop(std::bind(&LogShipper::sendInLoop, this, std::move(frame)));
+}
+
+bool LogShipper::writable() const
+{
+  return connection_ && connection_->connected()
+      && connection_->outputBuffer()->readableBytes() < options_.highWaterMark;
+}
+
+void LogShipper::sendInLoop(const string& frame)
+{
+  loop_->assertInLoopThread();
+  // spilled frames go first.
+  if (spillRead_ == spillWrite_ && writable())
+  {
+    connection_->send(frame);
+    sentBytes_ += static_cast<int64_t>(frame.size());
+  }
+  else
+  {
+    spillInLoop(frame);
+  }
+}
+
+void LogShipper::spillInLoop(const string& frame)
+{
+  const off_t size = static_cast<off_t>(frame.size());
+  if (spillFd_ < 0 || spillWrite_ - spillRead_ + size > options_.maxSpillBytes)
+  {
+    droppedBytes_ += size;
+    return;
+  }
+  ssize_t n = ::pwrite(spillFd_, frame.data(), frame.size(), spillWrite_);
+  if (n != static_cast<ssize_t>(frame.size()))
+  {
+    LOG_SYSERR_EVERY_SEC(1.0) << "LogShipper::spillInLoop";
+    droppedBytes_ += size;
+    return;
+  }
+  spillWrite_ += size;
+  spilledBytes_ += size;
+}
+
+void LogShipper::drainSpillInLoop()
+{
+  loop_->assertInLoopThread();
+  string chunk;
+  while (spillRead_ < spillWrite_ && writable())
+  {
+    // whole frames only, a new connection must start at a frame.
+    chunk.resize(static_cast<size_t>(std::min<off_t>(spillWrite_ - spillRead_, kSpillChunk)));
+    ssize_t n = ::pread(spillFd_, &*chunk.begin(), chunk.size(), spillRead_);
+    if (n < kFrameHeaderSize)
+    {
+      LOG_SYSERR_EVERY_SEC(1.0) << "LogShipper::drainSpillInLoop";
+      spillRead_ = spillWrite_;
+      break;
+    }
+    size_t end = 0;
+    while (end + kFrameHeaderSize <= static_cast<size_t>(n))
+    {
+      size_t frameLen = kFrameHeaderSize + parseFrameHeader(chunk.data() + end).length;
+      if (end + frameLen > static_cast<size_t>(n))
+      {
+        break;
+      }
+      end += frameLen;
+    }
+    if (end == 0)
+    {
+      // a frame larger than kSpillChunk
+      size_t frameLen = kFrameHeaderSize + parseFrameHeader(chunk.data()).length;
+      chunk.resize(frameLen);
+      n = ::pread(spillFd_, &*chunk.begin(), chunk.size(), spillRead_);
+      if (n != static_cast<ssize_t>(frameLen))
+      {
+        LOG_SYSERR_EVERY_SEC(1.0) << "LogShipper::drainSpillInLoop";
+        spillRead_ = spillWrite_;
+        break;
+      }
+      end = frameLen;
+    }
+    connection_->send(chunk.data(), static_cast<int>(end));
+    sentBytes_ += static_cast<int64_t>(end);
+    spillRead_ += static_cast<off_t>(end);
+  }
+  if (spillFd_ >= 0 && spillRead_ == spillWrite_ && spillWrite_ > 0)
+  {
+    // all sent, start over.
+    if (::ftruncate(spillFd_, 0) != 0)
+    {
+      LOG_SYSERR_EVERY_SEC(1.0) << "LogShipper::drainSpillInLoop ftruncate";
+    }
+    spillRead_ = spillWrite_ = 0;
+  }
+}
+
+void LogShipper::recoverSpill()
+{
+  char header[kFrameHeaderSize];
+  off_t offset = 0;
+  off_t fileSize = ::lseek(spillFd_, 0, SEEK_END);
+  while (offset + kFrameHeaderSize <= fileSize
+         && ::pread(spillFd_, header, sizeof header, offset) == kFrameHeaderSize)
+  {
+    FrameHeader h = parseFrameHeader(header);
+    if (!validHeader(h) || offset + kFrameHeaderSize + h.length > fileSize)
+    {
+      break;
+    }
+    offset += kFrameHeaderSize + h.length;
+  }
+  if (offset < fileSize && ::ftruncate(spillFd_, offset) != 0)
+  {
+    LOG_SYSERR << "LogShipper::recoverSpill ftruncate";
+  }
+  spillWrite_ = offset;
+  if (offset > 0)
+  {
+    LOG_INFO << "LogShipper " << options_.spillFile << " has " << offset << " bytes to send";
+  }
+}
+
+void LogShipper::onConnection(const TcpConnectionPtr& conn)
+{
+  loop_->assertInLoopThread();
+  if (conn->connected())
+  {
+    connection_ = conn;
+    drainSpillInLoop();
+  }
+  else
+  {
+    connection_.reset();
+    if (stopping_)
+    {
+      stoppedInLoop();
+    }
+  }
+}
+
+void LogShipper::onWriteComplete(const TcpConnectionPtr& /*conn*/)
+{
+  drainSpillInLoop();
+  if (stopping_ && spillRead_ == spillWrite_ && connection_)
+  {
+    client_->disconnect();
+  }
+}
+
+void LogShipper::stopInLoop()
+{
+  loop_->assertInLoopThread();
+  stopping_ = true;
+  if (connection_ && connection_->connected())
+  {
+    drainSpillInLoop();
+    if (spillRead_ == spillWrite_)
+    {
+      // shutdown after output buffer is written, see onConnection().
+      client_->disconnect();
+    }
+    // or once more spilled frames are written, see onWriteComplete().
+  }
+  else
+  {
+    stoppedInLoop();
+  }
+}
+
+void LogShipper::stoppedInLoop()
+{
+  MutexLockGuard lock(mutex_);
+  stopped_ = true;
+  cond_.notify();
+}
+
+void LogShipper::closeInLoop(CountDownLatch* latch)
+{
+  client_->stop();
+  client_.reset();
+  connection_.reset();
+  latch->countDown();
+}
+
+int LogShipper::decodeFrame(const char* data, size_t len, string* out)
+{
+  if (len < kFrameHeaderSize)
+  {
+    return 0;
+  }
+  FrameHeader h = parseFrameHeader(data);
+  if (!validHeader(h))
+  {
+    return -1;
+  }
+  if (len < kFrameHeaderSize + h.length)
+  {
+    return 0;
+  }
+  const char* payload = data + kFrameHeaderSize;
+  if (h.flags & kCompressed)
+  {
+#ifdef MUDUO_HAVE_ZLIB
+    size_t oldSize = out->size();
+    out->resize(oldSize + h.rawLength);
+    uLongf rawLength = h.rawLength;
+    if (::uncompress(reinterpret_cast<Bytef*>(&*out->begin() + oldSize), &rawLength,
+                     reinterpret_cast<const Bytef*>(payload), h.length) != Z_OK
+        || rawLength != h.rawLength)
+    {
+      out->resize(oldSize);
+      return -1;
+    }
+#else
+    return -1;
+#endif
+  }
+  else
+  {
+    out->append(payload, h.length);
+  }
+  return static_cast<int>(kFrameHeaderSize + h.length);
+}
@@ -0,0 +1,135 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_LOGSHIPPER_H
+#define MUDUO_NET_LOGSHIPPER_H
+
+#include <muduo/base/AsyncLogging.h>
+#include <muduo/base/Condition.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/net/Buffer.h>
+#include <muduo/net/EventLoopThread.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpConnection.h>
+
+#include <atomic>
+
+namespace muduo
+{
+namespace net
+{
+
+class TcpClient;
+
+/** class LogShipper
+ * - Brief:
+ *    LogSink of AsyncLogging that ships log to a collector over TCP, instead
+ *    of writing a local file, see AsyncLogging::setSink().
+ *    1) log is batched to batchBytes, or till AsyncLogging flushes, every
+ *       batch is one frame, optionally zlib compressed:
+ *       u32 length, u32 rawLength, u8 flags, then length bytes of payload,
+ *       network byte order, rawLength is the uncompressed length.
+ *    2) frames are sent by a TcpClient in an io thread of its own, which
+ *       reconnects when the collector goes away.
+ *    3) when not connected, or more than highWaterMark bytes wait in the
+ *       connection, frames go to spillFile, at most maxSpillBytes, then they
+ *       are dropped and counted. spilled frames are sent first when the
+ *       connection drains, left ones are sent by the next LogShipper on the
+ *       same spillFile.
+ *    bytes left in a broken connection are lost, frames are never split.
+ *    kBinary site entries are sent once, the collector keeps one stream for
+ *    the process.
+ */
+class LogShipper : public LogSink
+{
+public:
+  static const int kFrameHeaderSize = 9;
+  enum FrameFlags
+  {
+    kCompressed = 1,
+  };
+
+  struct Options
+  {
+    size_t batchBytes;     ///< frame is made when batch reaches this.
+    bool compress;         ///< needs zlib.
+    size_t highWaterMark;  ///< bytes in connection before spilling.
+    string spillFile;      ///< empty for no spilling.
+    off_t maxSpillBytes;
+
+    Options()
+      : batchBytes(1024*1024),
+        compress(false),
+        highWaterMark(8*1024*1024),
+        maxSpillBytes(256*1024*1024)
+    {
+    }
+  };
+
+private:
+  const Options options_;
+  EventLoopThread loopThread_;
+  EventLoop* loop_;
+  std::unique_ptr<TcpClient> client_;
+  Buffer batch_;  ///< log thread only.
+
+  ///> in loop thread
+  TcpConnectionPtr connection_;
+  int spillFd_;
+  off_t spillRead_;   ///< next frame to send.
+  off_t spillWrite_;  ///< end of spilled frames.
+  bool stopping_;
+
+  MutexLock mutex_;
+  Condition cond_ GUARDED_BY(mutex_);
+  bool stopped_ GUARDED_BY(mutex_);
+
+  std::atomic<int64_t> sentBytes_;
+  std::atomic<int64_t> spilledBytes_;
+  std::atomic<int64_t> droppedBytes_;
+
+public:
+  LogShipper(const InetAddress& collectorAddr,
+             const string& nameArg,
+             const Options& options = Options());
+  /// Sends what is batched, waits a while for the connection to drain.
+  ~LogShipper() override;
+
+  void append(const char* data, size_t len) override;
+  void flush() override;
+  int rollCount() const override { return 0; }
+
+  /// frame bytes, all thread safe.
+  int64_t sentBytes() const { return sentBytes_; }
+  int64_t spilledBytes() const { return spilledBytes_; }
+  int64_t droppedBytes() const { return droppedBytes_; }
+
+  /// Decodes the frame at data, payload is appended to out, uncompressed.
+  /// Returns size of the frame, 0 if incomplete, -1 if corrupt or compressed
+  /// without zlib.
+  static int decodeFrame(const char* data, size_t len, string* out);
+
+private:
+  void sendBatch();
+  /// Not thread safe, but in loop
+  void sendInLoop(const string& frame);
+  void spillInLoop(const string& frame);
+  void drainSpillInLoop();
+  void onConnection(const TcpConnectionPtr& conn);
+  void onWriteComplete(const TcpConnectionPtr& conn);
+  void stopInLoop();
+  void stoppedInLoop();
+  void closeInLoop(CountDownLatch* latch);
+  bool writable() const;
+  /// Frames already in spill file, a torn one at the end is cut off.
+  void recoverSpill();
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_LOGSHIPPER_H
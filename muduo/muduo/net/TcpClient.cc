@@ -10,6 +10,7 @@
 #include <muduo/net/TcpClient.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/base/ObjectPool.h>
 #include <muduo/net/Connector.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/SocketsOps.h>
@@ -140,12 +141,11 @@ void TcpClient::newConnection(int sockfd)
 
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
-  // FIXME use make_shared if necessary
-  TcpConnectionPtr conn (new TcpConnection(loop_,
-                                            connName,
-                                            sockfd,
-                                            localAddr,
-                                            peerAddr));
+  TcpConnectionPtr conn = makeShared<TcpConnection>(loop_,
+                                                   connName,
+                                                   sockfd,
+                                                   localAddr,
+                                                   peerAddr);
 
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
@@ -0,0 +1,477 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <muduo/net/TcpClientPool.h>
+
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Mutex.h>
+#include <muduo/base/ObjectPool.h>
+#include <muduo/base/WeakCallback.h>
+#include <muduo/net/Connector.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThreadPool.h>
+#include <muduo/net/SocketsOps.h>
+
+#include <inttypes.h>
+#include <stdio.h>  // snprintf
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+namespace
+{
+
+__thread uint64_t t_random = 0;
+
+// xorshift64*, good enough for picking members
+uint64_t fastRandom()
+{
+  if (t_random == 0)
+  {
+    t_random = static_cast<uint64_t>(CurrentThread::tid()) * 0x9E3779B97F4A7C15ULL + 1;
+  }
+  t_random ^= t_random >> 12;
+  t_random ^= t_random << 25;
+  t_random ^= t_random >> 27;
+  return t_random * 2685821657736338717ULL;
+}
+
+void keepConnector(const ConnectorPtr& /*connector*/)
+{
+}
+
+}  // namespace
+
+struct TcpClientPool::Member : noncopyable
+{
+  const int id;
+  EventLoop* const loop;
+  ConnectorPtr connector;
+  std::atomic<bool> connect; ///< false after stop(), no more reconnection.
+
+  mutable MutexLock mutex;
+  TcpConnectionPtr connection GUARDED_BY(mutex);
+
+  std::atomic<bool> connected;
+  std::atomic<int> outstanding;
+  std::atomic<int64_t> requests;
+  std::atomic<int> connects;
+  std::atomic<int> disconnects;
+  ///> always in loop thread
+  bool warm;
+  double retryDelay;
+  int nextConnId;
+
+  Member(int idArg, EventLoop* loopArg, const InetAddress& serverAddr,
+         double initRetryDelay, double maxRetryDelay)
+    : id(idArg),
+      loop(loopArg),
+      connector(new Connector(loopArg, serverAddr)),
+      connect(true),
+      connected(false),
+      outstanding(0),
+      requests(0),
+      connects(0),
+      disconnects(0),
+      warm(false),
+      retryDelay(initRetryDelay),
+      nextConnId(1)
+  {
+    connector->enableRetryJitter();
+    // failed connect attempts, at warm up or while an endpoint is down.
+    connector->setRetryDelay(initRetryDelay, maxRetryDelay);
+  }
+
+  TcpConnectionPtr getConnection() const
+  {
+    MutexLockGuard lock(mutex);
+    return connection;
+  }
+
+  void reconnect()
+  {
+    loop->assertInLoopThread();
+    if (connect)
+    {
+      LOG_INFO << "TcpClientPool - member " << id << " reconnecting to "
+               << connector->serverAddress().toIpPort();
+      connector->restart();
+    }
+  }
+
+  void stop()
+  {
+    loop->assertInLoopThread();
+    connector->stop();
+    TcpConnectionPtr conn(getConnection());
+    if (conn)
+    {
+      conn->shutdown();
+    }
+  }
+
+  ///> disconnect for good, counts down @c latch when everything is released.
+  void destroy(CountDownLatch* latch)
+  {
+    loop->assertInLoopThread();
+    connect = false;
+    TcpConnectionPtr conn(getConnection());
+    if (conn)
+    {
+      conn->setCloseCallback(std::bind(&finishDestroy, latch, _1));
+      conn->forceClose();
+    }
+    else
+    {
+      connector->stop();
+      // FIXME: HACK, same as TcpClient::~TcpClient()
+      loop->runAfter(1, std::bind(&keepConnector, connector));
+      if (latch)
+      {
+        latch->countDown();
+      }
+    }
+  }
+
+  static void finishDestroy(CountDownLatch* latch, const TcpConnectionPtr& conn)
+  {
+    conn->getLoop()->queueInLoop(
+        std::bind(&Member::destroyConnection, latch, conn));
+  }
+
+  static void destroyConnection(CountDownLatch* latch, const TcpConnectionPtr& conn)
+  {
+    conn->connectDestroyed();
+    if (latch)
+    {
+      latch->countDown();
+    }
+  }
+};
+
+TcpClientPool::TcpClientPool(EventLoop* baseLoop,
+                             const string& nameArg,
+                             SelectPolicy policy)
+  : baseLoop_(CHECK_NOTNULL(baseLoop)),
+    name_(nameArg),
+    policy_(policy),
+    threadPool_(new EventLoopThreadPool(baseLoop, nameArg)),
+    connectionCallback_(defaultConnectionCallback),
+    messageCallback_(defaultMessageCallback),
+    initRetryDelay_(0.5),
+    maxRetryDelay_(30.0),
+    started_(false),
+    connect_(false),
+    numWarm_(0),
+    numConnected_(0),
+    nextRoundRobin_(0)
+{
+}
+
+TcpClientPool::~TcpClientPool()
+{
+  LOG_INFO << "TcpClientPool::~TcpClientPool [" << name_ << "] destructing";
+  connect_ = false;
+  // wait for members in io threads, before threadPool_ quits their loops.
+  int numOtherThreads = 0;
+  for (const MemberPtr& member : members_)
+  {
+    if (!member->loop->isInLoopThread())
+    {
+      ++numOtherThreads;
+    }
+  }
+  CountDownLatch latch(numOtherThreads);
+  for (const MemberPtr& member : members_)
+  {
+    CountDownLatch* l = member->loop->isInLoopThread() ? NULL : &latch;
+    member->loop->runInLoop(std::bind(&Member::destroy, member, l));
+  }
+  latch.wait();
+}
+
+void TcpClientPool::setThreadNum(int numThreads)
+{
+  assert(0 <= numThreads);
+  assert(!started_);
+  threadPool_->setThreadNum(numThreads);
+}
+
+void TcpClientPool::addEndpoint(const InetAddress& serverAddr, int numConnections)
+{
+  assert(!started_);
+  assert(numConnections > 0);
+  endpoints_.push_back(std::make_pair(serverAddr, numConnections));
+}
+
+void TcpClientPool::start(const ThreadInitCallback& cb)
+{
+  if (started_.exchange(true))
+  {
+    return;
+  }
+  baseLoop_->assertInLoopThread();
+  threadPool_->start(cb);
+  connect_ = true;
+
+  // members of one endpoint interleave with others over loops.
+  int maxConnections = 0;
+  for (const auto& endpoint : endpoints_)
+  {
+    maxConnections = std::max(maxConnections, endpoint.second);
+  }
+  {
+  // stats() may read members_ from another thread meanwhile.
+  MutexLockGuard lock(mutex_);
+  for (int i = 0; i < maxConnections; ++i)
+  {
+    for (const auto& endpoint : endpoints_)
+    {
+      if (i < endpoint.second)
+      {
+        int id = static_cast<int>(members_.size());
+        members_.push_back(MemberPtr(new Member(id, threadPool_->getNextLoop(),
+                                                endpoint.first, initRetryDelay_,
+                                                maxRetryDelay_)));
+      }
+    }
+  }
+  }
+
+  LOG_INFO << "TcpClientPool::start [" << name_ << "] - warming up "
+           << members_.size() << " connections to "
+           << endpoints_.size() << " endpoints";
+  for (const MemberPtr& member : members_)
+  {
+    Member* m = get_pointer(member);
+    m->connector->setNewConnectionCallback(
+        std::bind(&TcpClientPool::newConnection, this, m, _1)); // FIXME: unsafe
+    m->connector->start();
+  }
+}
+
+void TcpClientPool::stop()
+{
+  connect_ = false;
+  for (const MemberPtr& member : members_)
+  {
+    member->connect = false;
+    member->loop->runInLoop(std::bind(&Member::stop, member));
+  }
+}
+
+void TcpClientPool::newConnection(Member* member, int sockfd)
+{
+  EventLoop* loop = member->loop;
+  loop->assertInLoopThread();
+  InetAddress peerAddr(sockets::getPeerAddr(sockfd));
+  char buf[64];
+  snprintf(buf, sizeof buf, ":%s#%d.%d",
+           peerAddr.toIpPort().c_str(), member->id, member->nextConnId);
+  ++member->nextConnId;
+  string connName = name_ + buf;
+
+  InetAddress localAddr(sockets::getLocalAddr(sockfd));
+  TcpConnectionPtr conn = makeShared<TcpConnection>(loop,
+                                                   connName,
+                                                   sockfd,
+                                                   localAddr,
+                                                   peerAddr);
+  conn->setConnectionCallback(connectionCallback_);
+  conn->setMessageCallback(messageCallback_);
+  conn->setWriteCompleteCallback(writeCompleteCallback_);
+  conn->setCloseCallback(
+      std::bind(&TcpClientPool::removeConnection, this, member, _1)); // FIXME: unsafe
+  {
+    MutexLockGuard lock(member->mutex);
+    member->connection = conn;
+  }
+  member->retryDelay = initRetryDelay_;
+  ++member->connects;
+  ++numConnected_;
+  member->connected = true;
+  conn->connectEstablished();
+
+  if (!member->warm)
+  {
+    member->warm = true;
+    if (++numWarm_ == size())
+    {
+      LOG_INFO << "TcpClientPool [" << name_ << "] - all "
+               << size() << " connections are warm";
+      if (warmUpCallback_)
+      {
+        warmUpCallback_();
+      }
+    }
+  }
+}
+
+void TcpClientPool::removeConnection(Member* member, const TcpConnectionPtr& conn)
+{
+  EventLoop* loop = member->loop;
+  loop->assertInLoopThread();
+  assert(loop == conn->getLoop());
+  member->connected = false;
+  --numConnected_;
+  ++member->disconnects;
+  {
+    MutexLockGuard lock(member->mutex);
+    assert(member->connection == conn);
+    member->connection.reset();
+  }
+  loop->queueInLoop(std::bind(&TcpConnection::connectDestroyed, conn));
+
+  if (connect_ && member->connect)
+  {
+    // full jitter in [delay/2, delay]
+    double delay = member->retryDelay * (0.5 + 0.5 * static_cast<double>(::random()) / RAND_MAX);
+    member->retryDelay = std::min(member->retryDelay * 2, maxRetryDelay_);
+    LOG_INFO << "TcpClientPool [" << name_ << "] - member " << member->id
+             << " lost " << conn->name() << ", reconnecting in " << delay << " seconds";
+    loop->runAfter(delay, makeWeakCallback(members_[member->id], &Member::reconnect));
+  }
+}
+
+bool TcpClientPool::available(int id) const
+{
+  return members_[id]->connected;
+}
+
+int TcpClientPool::selectMember()
+{
+  const int n = size();
+  if (n == 0 || numConnected_ == 0)
+  {
+    return -1;
+  }
+
+  int selected = -1;
+  switch (policy_)
+  {
+    case kRoundRobin:
+      for (int i = 0; i < n && selected < 0; ++i)
+      {
+        int id = static_cast<int>(nextRoundRobin_++ % n);
+        if (available(id))
+        {
+          selected = id;
+        }
+      }
+      break;
+
+    case kLeastOutstanding:
+      {
+        // start from random position, spread ties.
+        int start = static_cast<int>(fastRandom() % n);
+        int least = 0;
+        for (int i = 0; i < n; ++i)
+        {
+          int id = (start + i) % n;
+          if (available(id))
+          {
+            int outstanding = members_[id]->outstanding.load();
+            if (selected < 0 || outstanding < least)
+            {
+              selected = id;
+              least = outstanding;
+            }
+          }
+        }
+      }
+      break;
+
+    case kPowerOfTwoChoices:
+      {
+        for (int retry = 0; retry < 4 && selected < 0; ++retry)
+        {
+          uint64_t r = fastRandom();
+          int a = static_cast<int>(r % n);
+          int b = static_cast<int>((r >> 32) % n);
+          bool okA = available(a);
+          bool okB = available(b);
+          if (okA && okB)
+          {
+            selected = members_[a]->outstanding <= members_[b]->outstanding ? a : b;
+          }
+          else if (okA || okB)
+          {
+            selected = okA ? a : b;
+          }
+        }
+        // unlucky, most members are down
+        for (int id = 0; id < n && selected < 0; ++id)
+        {
+          if (available(id))
+          {
+            selected = id;
+          }
+        }
+      }
+      break;
+  }
+  return selected;
+}
+
+int TcpClientPool::acquire(TcpConnectionPtr* conn)
+{
+  // the connection may be lost between select and getConnection, try again.
+  for (int retry = 0; retry < 3; ++retry)
+  {
+    int id = selectMember();
+    if (id < 0)
+    {
+      break;
+    }
+    Member* member = get_pointer(members_[id]);
+    *conn = member->getConnection();
+    if (*conn)
+    {
+      ++member->outstanding;
+      ++member->requests;
+      return id;
+    }
+  }
+  conn->reset();
+  return -1;
+}
+
+void TcpClientPool::release(int id)
+{
+  assert(0 <= id && id < size());
+  --members_[id]->outstanding;
+}
+
+string TcpClientPool::stats() const
+{
+  MutexLockGuard lock(mutex_);
+  string result;
+  result.reserve(128 * (members_.size() + 1));
+  char buf[256];
+  static const char* policyNames[] = { "round-robin", "least-outstanding", "power-of-two-choices" };
+  snprintf(buf, sizeof buf, "TcpClientPool %s, %s, %d/%d connected, %d warm\n",
+           name_.c_str(), policyNames[policy_], numConnected_.load(), size(), numWarm_.load());
+  result += buf;
+  result += "   id endpoint               state  outstanding     requests connects disconnects\n";
+  for (const MemberPtr& member : members_)
+  {
+    snprintf(buf, sizeof buf, "%5d %-22s %-6s %11d %12" PRId64 " %8d %11d\n",
+             member->id,
+             member->connector->serverAddress().toIpPort().c_str(),
+             member->connected ? "UP" : "DOWN",
+             member->outstanding.load(),
+             member->requests.load(),
+             member->connects.load(),
+             member->disconnects.load());
+    result += buf;
+  }
+  return result;
+}
@@ -0,0 +1,155 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_TCPCLIENTPOOL_H
+#define MUDUO_NET_TCPCLIENTPOOL_H
+
+#include <muduo/base/Mutex.h>
+#include <muduo/net/TcpConnection.h>
+
+#include <atomic>
+#include <vector>
+
+namespace muduo
+{
+namespace net
+{
+
+class Connector;
+class EventLoopThreadPool;
+typedef std::shared_ptr<Connector> ConnectorPtr;
+
+///
+/// Pool of client connections to several endpoints, spread over io loops.
+///
+/// This is an interface class, so don't expose too much details.
+
+/** class TcpClientPool
+ * - Brief:
+ *    TcpClientPool is a TcpClient with many connections. every endpoint has
+ *    N members, one member is one Connector + one TcpConnection, members are
+ *    assigned to loops of threadPool_ on a round-robin basis.
+ *    1) start() connects all members at once (warm up), warmUpCallback_ is
+ *       invoked when every member has been connected.
+ *    2) acquire() picks an established member by SelectPolicy and counts one
+ *       outstanding request on it, release() finishes it.
+ *    3) a broken member reconnects after a jittered exponential backoff.
+ *    4) stats() is a text page for Inspector, see Inspector::addClientPool().
+ */
+class TcpClientPool : noncopyable
+{
+public:
+  typedef std::function<void(EventLoop*)> ThreadInitCallback;
+  typedef std::function<void()> WarmUpCallback;
+  enum SelectPolicy
+  {
+    kRoundRobin,
+    kLeastOutstanding,
+    kPowerOfTwoChoices,
+  };
+
+private:
+  struct Member;
+  typedef std::shared_ptr<Member> MemberPtr;
+
+  EventLoop* baseLoop_;
+  const string name_;
+  const SelectPolicy policy_;
+  std::unique_ptr<EventLoopThreadPool> threadPool_;
+  ///> endpoints and connections per endpoint, see addEndpoint().
+  std::vector<std::pair<InetAddress, int>> endpoints_;
+  mutable MutexLock mutex_;
+  std::vector<MemberPtr> members_; ///< filled by start() under mutex_, fixed after.
+
+  ConnectionCallback connectionCallback_;
+  MessageCallback messageCallback_;
+  WriteCompleteCallback writeCompleteCallback_;
+  WarmUpCallback warmUpCallback_;
+
+  ///> seconds of reconnect backoff.
+  double initRetryDelay_;
+  double maxRetryDelay_;
+
+  std::atomic<bool> started_;
+  std::atomic<bool> connect_;
+  std::atomic<int> numWarm_;       ///< members that have ever been connected.
+  std::atomic<int> numConnected_;  ///< members that are connected now.
+  std::atomic<uint64_t> nextRoundRobin_;
+
+public:
+  TcpClientPool(EventLoop* baseLoop,
+                const string& nameArg,
+                SelectPolicy policy = kLeastOutstanding);
+  ~TcpClientPool();  // force out-line dtor, for std::unique_ptr members.
+
+  const string& name() const { return name_; }
+  EventLoop* getLoop() const { return baseLoop_; }
+
+  /// Set the number of io threads, same as TcpServer::setThreadNum().
+  /// Must be called before @c start
+  void setThreadNum(int numThreads);
+
+  /// Add @c numConnections members to @c serverAddr.
+  /// Must be called before @c start
+  void addEndpoint(const InetAddress& serverAddr, int numConnections);
+
+  /// Reconnect backoff, delay doubles from @c initSeconds to @c maxSeconds,
+  /// each delay is randomized to [delay/2, delay]. Applies after a lost
+  /// connection and between failed connect attempts.
+  /// Must be called before @c start
+  void setRetryDelay(double initSeconds, double maxSeconds)
+  { initRetryDelay_ = initSeconds; maxRetryDelay_ = maxSeconds; }
+
+  /// Connects all members.
+  /// Must be called in loop thread of @c baseLoop
+  void start(const ThreadInitCallback& cb = ThreadInitCallback());
+  /// Disconnects all members, no more reconnection.
+  /// Thread safe.
+  void stop();
+
+  /// Picks an established connection and counts one outstanding request on
+  /// it, returns its member id, or -1 if no connection is established.
+  /// Thread safe.
+  int acquire(TcpConnectionPtr* conn);
+  /// Request on member @c id is finished.
+  /// Thread safe.
+  void release(int id);
+
+  int numConnected() const { return numConnected_; }
+  int size() const { return static_cast<int>(members_.size()); }
+
+  /// Plain text statistics of every member.
+  /// Thread safe, may be called while @c start is running.
+  string stats() const;
+
+  /// Not thread safe.
+  void setConnectionCallback(ConnectionCallback cb)
+  { connectionCallback_ = std::move(cb); }
+  /// Not thread safe.
+  void setMessageCallback(MessageCallback cb)
+  { messageCallback_ = std::move(cb); }
+  /// Not thread safe.
+  void setWriteCompleteCallback(WriteCompleteCallback cb)
+  { writeCompleteCallback_ = std::move(cb); }
+  /// Invoked once in some io loop, when every member has been connected.
+  /// Not thread safe.
+  void setWarmUpCallback(WarmUpCallback cb)
+  { warmUpCallback_ = std::move(cb); }
+
+private:
+  /// Not thread safe, but in loop
+  void newConnection(Member* member, int sockfd);
+  /// Not thread safe, but in loop
+  void removeConnection(Member* member, const TcpConnectionPtr& conn);
+  int selectMember();
+  bool available(int id) const;
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_TCPCLIENTPOOL_H
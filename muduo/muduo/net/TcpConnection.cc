@@ -17,6 +17,8 @@
 
 #include <errno.h>
 
+#include <algorithm>
+
 using namespace muduo;
 using namespace muduo::net;
 
@@ -48,7 +50,12 @@ TcpConnection::TcpConnection(EventLoop* loop,
     channel_(new Channel(loop, sockfd)),
     localAddr_(localAddr),
     peerAddr_(peerAddr),
-    highWaterMark_(64*1024*1024)
+    highWaterMark_(64*1024*1024),
+    idleTimeout_(0),
+    readTimeout_(0),
+    writeTimeout_(0),
+    lastReadTick_(0),
+    lastWriteTick_(0)
 {
   channel_->setReadCallback(
       std::bind(&TcpConnection::handleRead, this, _1));
@@ -58,6 +65,8 @@ TcpConnection::TcpConnection(EventLoop* loop,
       std::bind(&TcpConnection::handleClose, this));
   channel_->setErrorCallback(
       std::bind(&TcpConnection::handleError, this));
+  timeoutEntry_.setExpireCallback(
+      std::bind(&TcpConnection::checkTimeout, this, _1));
   LOG_DEBUG << "TcpConnection::ctor[" <<  name_ << "] at " << this
             << " fd=" << sockfd;
   socket_->setKeepAlive(true);
@@ -153,6 +162,10 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
     nwrote = sockets::write(channel_->fd(), data, len);
     if (nwrote >= 0)
     {
+      if (timeoutEntry_.linked())
+      {
+        lastWriteTick_ = timeoutEntry_.wheel()->now();
+      }
       remaining = len - nwrote;
       if (remaining == 0 && writeCompleteCallback_)
       {
@@ -164,7 +177,7 @@ void TcpConnection::sendInLoop(const void* data, size_t len)
       nwrote = 0;
       if (errno != EWOULDBLOCK)
       {
-        LOG_SYSERR << "TcpConnection::sendInLoop";
+        LOG_SYSERR_EVERY_SEC(1.0) << "TcpConnection::sendInLoop";
         if (errno == EPIPE || errno == ECONNRESET) // FIXME: any others?
         {
           faultError = true;
@@ -320,6 +333,16 @@ void TcpConnection::stopReadInLoop()
   }
 }
 
+void TcpConnection::setTimeouts(double idleSeconds,
+                                double readSeconds,
+                                double writeSeconds)
+{
+  assert(state_ == kConnecting);
+  idleTimeout_ = idleSeconds;
+  readTimeout_ = readSeconds;
+  writeTimeout_ = writeSeconds;
+}
+
 void TcpConnection::connectEstablished()
 {
   loop_->assertInLoopThread();
@@ -328,6 +351,13 @@ void TcpConnection::connectEstablished()
   channel_->tie(shared_from_this());
   channel_->enableReading();
 
+  if (hasTimeout())
+  {
+    TimingWheel* wheel = loop_->timingWheel();
+    lastReadTick_ = lastWriteTick_ = wheel->now();
+    wheel->schedule(&timeoutEntry_, checkTimeout(wheel->now()));
+  }
+
   connectionCallback_(shared_from_this());
 }
 
@@ -341,6 +371,7 @@ void TcpConnection::connectDestroyed()
 
     connectionCallback_(shared_from_this());
   }
+  timeoutEntry_.unlink();
   channel_->remove();
 }
 
@@ -351,6 +382,10 @@ void TcpConnection::handleRead(Timestamp receiveTime)
   ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
   if (n > 0)
   {
+    if (timeoutEntry_.linked())
+    {
+      lastReadTick_ = timeoutEntry_.wheel()->now();
+    }
     messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
   }
   else if (n == 0)
@@ -360,7 +395,7 @@ void TcpConnection::handleRead(Timestamp receiveTime)
   else
   {
     errno = savedErrno;
-    LOG_SYSERR << "TcpConnection::handleRead";
+    LOG_SYSERR_EVERY_SEC(1.0) << "TcpConnection::handleRead";
     handleError();
   }
 }
@@ -375,6 +410,10 @@ void TcpConnection::handleWrite()
                                outputBuffer_.readableBytes());
     if (n > 0)
     {
+      if (timeoutEntry_.linked())
+      {
+        lastWriteTick_ = timeoutEntry_.wheel()->now();
+      }
       outputBuffer_.retrieve(n);
       if (outputBuffer_.readableBytes() == 0)
       {
@@ -391,7 +430,7 @@ void TcpConnection::handleWrite()
     }
     else
     {
-      LOG_SYSERR << "TcpConnection::handleWrite";
+      LOG_SYSERR_EVERY_SEC(1.0) << "TcpConnection::handleWrite";
       // if (state_ == kDisconnecting)
       // {
       //   shutdownInLoop();
@@ -413,6 +452,7 @@ void TcpConnection::handleClose()
   // we don't close fd, leave it to dtor, so we can find leaks easily.
   setState(kDisconnected);
   channel_->disableAll();
+  timeoutEntry_.unlink();
 
   TcpConnectionPtr guardThis(shared_from_this());
   connectionCallback_(guardThis);
@@ -427,3 +467,57 @@ void TcpConnection::handleError()
             << "] - SO_ERROR = " << err << " " << strerror_tl(err);
 }
 
+
+int64_t TcpConnection::checkTimeout(int64_t now)
+{
+  loop_->assertInLoopThread();
+  if (state_ == kDisconnected || !hasTimeout())
+  {
+    return 0;
+  }
+
+  TimingWheel* wheel = loop_->timingWheel();
+  int64_t deadline = INT64_MAX;
+  if (idleTimeout_ > 0)
+  {
+    int64_t lastActive = std::max(lastReadTick_, lastWriteTick_);
+    deadline = std::min(deadline, lastActive + wheel->toTicks(idleTimeout_));
+  }
+  if (readTimeout_ > 0)
+  {
+    deadline = std::min(deadline, lastReadTick_ + wheel->toTicks(readTimeout_));
+  }
+  if (writeTimeout_ > 0)
+  {
+    // nothing to write, check it again later.
+    int64_t since = outputBuffer_.readableBytes() > 0 ? lastWriteTick_ : now;
+    deadline = std::min(deadline, since + wheel->toTicks(writeTimeout_));
+  }
+
+  if (deadline > now)
+  {
+    return deadline;
+  }
+
+  LOG_DEBUG << "TcpConnection::checkTimeout [" << name_ << "] timeout,"
+            << " lastRead = " << lastReadTick_
+            << " lastWrite = " << lastWriteTick_
+            << " now = " << now;
+  TcpConnectionPtr guardThis(shared_from_this());
+  if (timeoutCallback_)
+  {
+    timeoutCallback_(guardThis);
+  }
+  else
+  {
+    forceCloseInLoop();
+  }
+
+  if (state_ == kDisconnected)
+  {
+    return 0;
+  }
+  // user keeps it alive, restart counting.
+  lastReadTick_ = lastWriteTick_ = now;
+  return checkTimeout(now);
+}
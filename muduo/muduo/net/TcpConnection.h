@@ -17,6 +17,7 @@
 #include <muduo/net/Callbacks.h>
 #include <muduo/net/Buffer.h>
 #include <muduo/net/InetAddress.h>
+#include <muduo/net/TimingWheel.h>
 
 #include <memory>
 
@@ -75,8 +76,19 @@ private:
   HighWaterMarkCallback highWaterMarkCallback_;
   CloseCallback closeCallback_;
 
+  TimeoutCallback timeoutCallback_;
+
   size_t highWaterMark_;
 
+  ///> timeouts in seconds, 0 means disabled. see checkTimeout().
+  double idleTimeout_;  ///< neither read nor write
+  double readTimeout_;  ///< no read
+  double writeTimeout_; ///< output buffer is pending without progress
+  ///> ticks of loop_->timingWheel(), not Timestamp, so it is cheap.
+  int64_t lastReadTick_;
+  int64_t lastWriteTick_;
+  TimingWheel::Entry timeoutEntry_;
+
   ///> buffer
   Buffer inputBuffer_;
   Buffer outputBuffer_; // FIXME: use list<Buffer> as output buffer.
@@ -144,6 +156,13 @@ public:
   void setHighWaterMarkCallback(const HighWaterMarkCallback& cb, size_t highWaterMark)
   { highWaterMarkCallback_ = cb; highWaterMark_ = highWaterMark; }
 
+  /// Set timeouts in seconds, 0 means disabled.
+  /// Default timeout action is forceClose(), unless TimeoutCallback is set.
+  /// Not thread safe, must be called before connectEstablished().
+  void setTimeouts(double idleSeconds, double readSeconds, double writeSeconds);
+  void setTimeoutCallback(const TimeoutCallback& cb)
+  { timeoutCallback_ = cb; }
+
   /// Advanced interface
   Buffer* inputBuffer()
   { return &inputBuffer_; }
@@ -175,6 +194,10 @@ private:
   const char* stateToString() const;
   void startReadInLoop();
   void stopReadInLoop();
+  ///> invoked by TimingWheel, return next deadline tick.
+  int64_t checkTimeout(int64_t now);
+  bool hasTimeout() const
+  { return idleTimeout_ > 0 || readTimeout_ > 0 || writeTimeout_ > 0; }
 };
 
 }  // namespace net
@@ -9,6 +9,7 @@
 #include <muduo/net/TcpServer.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/base/ObjectPool.h>
 #include <muduo/net/Acceptor.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/EventLoopThreadPool.h>
@@ -30,6 +31,9 @@ TcpServer::TcpServer(EventLoop* loop,
     threadPool_(new EventLoopThreadPool(loop, name_)),
     connectionCallback_(defaultConnectionCallback),
     messageCallback_(defaultMessageCallback),
+    idleTimeout_(0),
+    readTimeout_(0),
+    writeTimeout_(0),
     nextConnId_(1)
 {
   acceptor_->setNewConnectionCallback(
@@ -82,16 +86,17 @@ void TcpServer::newConnection(int sockfd, const InetAddress& peerAddr)
            << "] from " << peerAddr.toIpPort();
   InetAddress localAddr(sockets::getLocalAddr(sockfd));
   // FIXME poll with zero timeout to double confirm the new connection
-  // FIXME use make_shared if necessary
-  TcpConnectionPtr conn(new TcpConnection(ioLoop,
-                                          connName,
-                                          sockfd,
-                                          localAddr,
-                                          peerAddr));
+  TcpConnectionPtr conn = makeShared<TcpConnection>(ioLoop,
+                                                   connName,
+                                                   sockfd,
+                                                   localAddr,
+                                                   peerAddr);
   connections_[connName] = conn;
   conn->setConnectionCallback(connectionCallback_);
   conn->setMessageCallback(messageCallback_);
   conn->setWriteCompleteCallback(writeCompleteCallback_);
+  conn->setTimeoutCallback(timeoutCallback_);
+  conn->setTimeouts(idleTimeout_, readTimeout_, writeTimeout_);
   conn->setCloseCallback(
       std::bind(&TcpServer::removeConnection, this, _1)); // FIXME: unsafe
   ioLoop->runInLoop(std::bind(&TcpConnection::connectEstablished, conn));
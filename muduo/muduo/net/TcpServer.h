@@ -87,6 +87,13 @@ private:
   ///> TcpConnection object will invoke it. see TcpServer::newConnection().
   ///> callback will be invoked when TcpConnection completely send a new message.
   WriteCompleteCallback writeCompleteCallback_;
+  ///> invoked when a connection is timeout, default is forceClose().
+  TimeoutCallback timeoutCallback_;
+  ///> timeouts in seconds for every new connection, 0 means disabled.
+  ///> checked by TimingWheel of io loop, no timer per connection.
+  double idleTimeout_;
+  double readTimeout_;
+  double writeTimeout_;
   ///> threads of threadPool_ object will invoke it. see TcpServer::start().
   ThreadInitCallback threadInitCallback_;
   ///> if server is started. see TcpServer::start().
@@ -148,6 +155,26 @@ public:
   void setWriteCompleteCallback(const WriteCompleteCallback& cb)
   { writeCompleteCallback_ = cb; }
 
+  /// Close connection which has no input and no output for @c seconds.
+  /// Precision is 1 second. Not thread safe.
+  void setIdleTimeout(double seconds)
+  { idleTimeout_ = seconds; }
+
+  /// Close connection which has no input for @c seconds.
+  /// Not thread safe.
+  void setReadTimeout(double seconds)
+  { readTimeout_ = seconds; }
+
+  /// Close connection whose pending output makes no progress for @c seconds.
+  /// Not thread safe.
+  void setWriteTimeout(double seconds)
+  { writeTimeout_ = seconds; }
+
+  /// Set timeout callback, replaces default action forceClose().
+  /// Not thread safe.
+  void setTimeoutCallback(const TimeoutCallback& cb)
+  { timeoutCallback_ = cb; }
+
 private:
   /// Not thread safe, but in loop
   void newConnection(int sockfd, const InetAddress& peerAddr);
@@ -12,6 +12,7 @@
 #define MUDUO_NET_TIMER_H
 
 #include <muduo/base/Atomic.h>
+#include <muduo/base/InlineFunction.h>
 #include <muduo/base/Timestamp.h>
 #include <muduo/net/Callbacks.h>
 
@@ -27,7 +28,7 @@ class Timer : noncopyable
 {
 private:
   ///> expiration callback
-  const TimerCallback callback_;
+  const InlineFunction<void()> callback_;
   ///> expiration time
   Timestamp expiration_;
   ///> interval for repeat, metric is seconds.
@@ -39,7 +40,7 @@ private:
   static AtomicInt64 s_numCreated_;
 
 public:
-  Timer(TimerCallback cb, Timestamp when, double interval)
+  Timer(InlineFunction<void()> cb, Timestamp when, double interval)
     : callback_(std::move(cb)),
       expiration_(when),
       interval_(interval),
@@ -13,6 +13,7 @@
 #include <muduo/net/TimerQueue.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/base/ObjectPool.h>
 #include <muduo/net/EventLoop.h>
 #include <muduo/net/Timer.h>
 #include <muduo/net/TimerId.h>
@@ -108,15 +109,15 @@ TimerQueue::~TimerQueue()
   // do not remove channel, since we're in EventLoop::dtor();
   for (const Entry& timer : timers_)
   {
-    delete timer.second;
+    ObjectPool<Timer>::destroy(timer.second);
   }
 }
 
-TimerId TimerQueue::addTimer(TimerCallback cb,
+TimerId TimerQueue::addTimer(InlineFunction<void()> cb,
                              Timestamp when,
                              double interval)
 {
-  Timer* timer = new Timer(std::move(cb), when, interval);
+  Timer* timer = ObjectPool<Timer>::create(std::move(cb), when, interval);
   loop_->runInLoop( std::bind(&TimerQueue::addTimerInLoop, this, timer) );
   return TimerId(timer, timer->sequence());
 }
@@ -149,7 +150,7 @@ void TimerQueue::cancelInLoop(TimerId timerId)
   {
     size_t n = timers_.erase(Entry(it->first->expiration(), it->first));
     assert(n == 1); (void)n;
-    delete it->first; // FIXME: no delete please
+    ObjectPool<Timer>::destroy(it->first);
     activeTimers_.erase(it);
   }
   else if (callingExpiredTimers_)
@@ -217,8 +218,7 @@ void TimerQueue::reset(const std::vector<Entry>& expired, Timestamp now)
     }
     else
     {
-      // FIXME move to a free list
-      delete it.second; // FIXME: no delete please
+      ObjectPool<Timer>::destroy(it.second);
     }
   }
 
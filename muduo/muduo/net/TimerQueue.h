@@ -14,6 +14,7 @@
 #include <set>
 #include <vector>
 
+#include <muduo/base/InlineFunction.h>
 #include <muduo/base/Mutex.h>
 #include <muduo/base/Timestamp.h>
 #include <muduo/net/Callbacks.h>
@@ -122,7 +123,7 @@ public:
   ///
   /// Must be thread safe. Usually be called from other threads.
   ///> see addTimerInLoop().
-  TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+  TimerId addTimer(InlineFunction<void()> cb, Timestamp when, double interval);
   ///> see cancelInLoop().
   void cancel(TimerId timerId);
 
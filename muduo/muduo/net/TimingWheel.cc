@@ -0,0 +1,126 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+
+#include <muduo/net/TimingWheel.h>
+
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+
+#include <math.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void TimingWheel::Entry::unlink()
+{
+  if (wheel_)
+  {
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
+    prev_ = next_ = NULL;
+    wheel_ = NULL;
+  }
+}
+
+TimingWheel::TimingWheel(EventLoop* loop, double tickSeconds)
+  : loop_(CHECK_NOTNULL(loop)),
+    tickSeconds_(tickSeconds),
+    currentTick_(1),
+    started_(false)
+{
+  assert(tickSeconds_ > 0);
+  for (Slot& slot : wheel_)
+  {
+    slot.head.prev_ = slot.head.next_ = &slot.head;
+  }
+}
+
+TimingWheel::~TimingWheel()
+{
+  for (Slot& slot : wheel_)
+  {
+    Entry* head = &slot.head;
+    while (head->next_ != head)
+    {
+      Entry* entry = head->next_;
+      head->next_ = entry->next_;
+      entry->prev_ = entry->next_ = NULL;
+      entry->wheel_ = NULL;
+    }
+  }
+}
+
+int64_t TimingWheel::toTicks(double seconds) const
+{
+  int64_t ticks = static_cast<int64_t>(ceil(seconds / tickSeconds_));
+  return ticks > 0 ? ticks : 1;
+}
+
+void TimingWheel::schedule(Entry* entry, int64_t deadline)
+{
+  loop_->assertInLoopThread();
+  assert(entry->expireCallback_);
+  entry->unlink();
+  // never schedule into slot being visited, it wouldn't be seen for a round.
+  entry->deadline_ = deadline > currentTick_ ? deadline : currentTick_ + 1;
+  entry->wheel_ = this;
+  link(entry);
+
+  if (!started_)
+  {
+    started_ = true;
+    loop_->runEvery(tickSeconds_, std::bind(&TimingWheel::onTick, this));
+  }
+}
+
+void TimingWheel::link(Entry* entry)
+{
+  Entry* head = slotHead(entry->deadline_);
+  entry->prev_ = head->prev_;
+  entry->next_ = head;
+  head->prev_->next_ = entry;
+  head->prev_ = entry;
+}
+
+void TimingWheel::onTick()
+{
+  loop_->assertInLoopThread();
+  ++currentTick_;
+  Entry* head = slotHead(currentTick_);
+  if (head->next_ == head)
+  {
+    return;
+  }
+
+  // move whole slot to a local list, callbacks may unlink or schedule any
+  // entry (include themselves) safely.
+  Entry expiring;
+  expiring.prev_ = head->prev_;
+  expiring.next_ = head->next_;
+  expiring.prev_->next_ = &expiring;
+  expiring.next_->prev_ = &expiring;
+  head->prev_ = head->next_ = head;
+
+  while (expiring.next_ != &expiring)
+  {
+    Entry* entry = expiring.next_;
+    if (entry->deadline_ > currentTick_)
+    {
+      // not in this round
+      entry->prev_->next_ = entry->next_;
+      entry->next_->prev_ = entry->prev_;
+      link(entry);
+      continue;
+    }
+
+    entry->unlink();
+    int64_t next = entry->expireCallback_(currentTick_);
+    if (next > 0 && !entry->linked())
+    {
+      schedule(entry, next);
+    }
+  }
+  expiring.prev_ = expiring.next_ = NULL;
+}
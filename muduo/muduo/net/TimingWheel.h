@@ -0,0 +1,117 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+//
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is a public header file, it must only include public header files.
+
+#ifndef MUDUO_NET_TIMINGWHEEL_H
+#define MUDUO_NET_TIMINGWHEEL_H
+
+#include <muduo/base/noncopyable.h>
+#include <muduo/base/Types.h>
+
+#include <functional>
+
+namespace muduo
+{
+namespace net
+{
+
+class EventLoop;
+
+///
+/// Hashed timing wheel for coarse connection timeouts, one per EventLoop.
+///
+/// This is an interface class, so don't expose too much details.
+
+/** class TimingWheel
+ * - Brief:
+ *    TimingWheel is a replacement of examples/idleconnection, it keeps
+ *    timeouts of many connections with one repeat timer.
+ *    1) wheel_ is kNumSlots intrusive lists, an Entry is linked into slot
+ *       of (deadline % kNumSlots). no allocation, no shared_ptr.
+ *    2) currentTick_ is increased by timer every tickSeconds_, owner of
+ *       Entry reads it (not Timestamp::now()) when data arrived.
+ *    3) owner does NOT relink its Entry on every message, it only records
+ *       the tick. when slot of old deadline is visited, expireCallback_
+ *       tells new deadline and Entry is moved (lazy rescheduling).
+ *       so it is O(1) per message and amortized O(1) per tick.
+ */
+class TimingWheel : noncopyable
+{
+public:
+  class Entry : noncopyable
+  {
+  public:
+    ///> invoked in loop thread when deadline is reached, argument is current
+    ///  tick. return next deadline (> now) to rearm, or 0 to be unlinked.
+    typedef std::function<int64_t (int64_t now)> ExpireCallback;
+
+  private:
+    friend class TimingWheel;
+    Entry* prev_;
+    Entry* next_;
+    TimingWheel* wheel_; ///< NULL if not linked.
+    int64_t deadline_;
+    ExpireCallback expireCallback_;
+
+  public:
+    Entry()
+      : prev_(NULL),
+        next_(NULL),
+        wheel_(NULL),
+        deadline_(0)
+    {
+    }
+    ~Entry() { unlink(); }
+
+    void setExpireCallback(ExpireCallback cb)
+    { expireCallback_ = std::move(cb); }
+
+    bool linked() const { return wheel_ != NULL; }
+    TimingWheel* wheel() const { return wheel_; }
+    int64_t deadline() const { return deadline_; }
+    ///> remove from wheel, harmless if not linked.
+    void unlink();
+  };
+
+  static const int kNumSlots = 64; // must be power of 2
+
+private:
+  struct Slot
+  {
+    Entry head; ///< sentinel of circular list.
+  };
+
+  EventLoop* loop_;
+  const double tickSeconds_;
+  int64_t currentTick_;
+  bool started_; ///< repeat timer is running.
+  Slot wheel_[kNumSlots];
+
+public:
+  TimingWheel(EventLoop* loop, double tickSeconds = 1.0);
+  ~TimingWheel();
+
+  double tickSeconds() const { return tickSeconds_; }
+  ///> coarse clock, cheap enough to read on every message.
+  int64_t now() const { return currentTick_; }
+  ///> seconds to ticks, at least one tick.
+  int64_t toTicks(double seconds) const;
+
+  ///> link or relink @c entry to expire at tick @c deadline.
+  /// Not thread safe, but in loop
+  void schedule(Entry* entry, int64_t deadline);
+
+private:
+  void onTick();
+  void link(Entry* entry);
+  Entry* slotHead(int64_t tick)
+  { return &wheel_[static_cast<size_t>(tick & (kNumSlots - 1))].head; }
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_TIMINGWHEEL_H
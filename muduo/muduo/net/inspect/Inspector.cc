@@ -10,10 +10,13 @@
 #include <muduo/net/inspect/Inspector.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/base/ShardedCounter.h>
 #include <muduo/base/Thread.h>
 #include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpClientPool.h>
 #include <muduo/net/http/HttpRequest.h>
 #include <muduo/net/http/HttpResponse.h>
+#include <muduo/net/inspect/LockInspector.h>
 #include <muduo/net/inspect/ProcessInspector.h>
 #include <muduo/net/inspect/PerformanceInspector.h>
 #include <muduo/net/inspect/SystemInspector.h>
@@ -55,6 +58,12 @@ std::vector<string> split(const string& str)
   return result;
 }
 
+// /stats/counters/<prefix>
+string counters(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  return ShardedStats::report(args.empty() ? StringPiece() : StringPiece(args[0]));
+}
+
 }  // namespace
 
 extern char favicon[1743];
@@ -64,7 +73,8 @@ Inspector::Inspector(EventLoop* loop,
                      const string& name)
     : server_(loop, httpAddr, "Inspector:"+name),
       processInspector_(new ProcessInspector),
-      systemInspector_(new SystemInspector)
+      systemInspector_(new SystemInspector),
+      lockInspector_(new LockInspector)
 {
   assert(CurrentThread::isMainThread());
   assert(g_globalInspector == 0);
@@ -72,6 +82,8 @@ Inspector::Inspector(EventLoop* loop,
   server_.setHttpCallback(std::bind(&Inspector::onRequest, this, _1, _2));
   processInspector_->registerCommands(this);
   systemInspector_->registerCommands(this);
+  lockInspector_->registerCommands(this);
+  add("stats", "counters", counters, "named sharded counters and gauges, /prefix to filter");
 #ifdef HAVE_TCMALLOC
   performanceInspector_.reset(new PerformanceInspector);
   performanceInspector_->registerCommands(this);
@@ -106,6 +118,13 @@ void Inspector::remove(const string& module, const string& command)
   }
 }
 
+void Inspector::addClientPool(const TcpClientPool* pool)
+{
+  // extra arguments (method, args) are discarded by std::bind
+  add("pool", pool->name(), std::bind(&TcpClientPool::stats, pool),
+      "connections, outstanding requests of client pool");
+}
+
 void Inspector::start()
 {
   server_.start();
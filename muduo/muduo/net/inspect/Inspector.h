@@ -22,9 +22,11 @@ namespace muduo
 namespace net
 {
 
+class LockInspector;
 class ProcessInspector;
 class PerformanceInspector;
 class SystemInspector;
+class TcpClientPool;
 
 // An internal inspector of the running process, usually a singleton.
 // Better to run in a seperated thread, as some method may block for seconds
@@ -45,6 +47,10 @@ class Inspector : noncopyable
            const string& help);
   void remove(const string& module, const string& command);
 
+  /// Show TcpClientPool::stats() at /pool/<name>
+  /// @c pool must outlive the Inspector, or be removed with remove("pool", name).
+  void addClientPool(const TcpClientPool* pool);
+
  private:
   typedef std::map<string, Callback> CommandList;
   typedef std::map<string, string> HelpList;
@@ -56,6 +62,7 @@ class Inspector : noncopyable
   std::unique_ptr<ProcessInspector> processInspector_;
   std::unique_ptr<PerformanceInspector> performanceInspector_;
   std::unique_ptr<SystemInspector> systemInspector_;
+  std::unique_ptr<LockInspector> lockInspector_;
   MutexLock mutex_;
   std::map<string, CommandList> modules_ GUARDED_BY(mutex_);
   std::map<string, HelpList> helps_ GUARDED_BY(mutex_);
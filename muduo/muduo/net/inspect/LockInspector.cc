@@ -0,0 +1,43 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+
+#include <muduo/net/inspect/LockInspector.h>
+#include <muduo/base/LockProfiler.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+void LockInspector::registerCommands(Inspector* ins)
+{
+  ins->add("locks", "stats", LockInspector::stats,
+           "contention of named locks, most waited first");
+  ins->add("locks", "enable", LockInspector::enable, "start lock profiling");
+  ins->add("locks", "disable", LockInspector::disable, "stop lock profiling");
+  ins->add("locks", "reset", LockInspector::reset, "clear lock stats");
+}
+
+string LockInspector::stats(HttpRequest::Method, const Inspector::ArgList&)
+{
+  return LockProfiler::report();
+}
+
+string LockInspector::enable(HttpRequest::Method, const Inspector::ArgList&)
+{
+  LockProfiler::setEnabled(true);
+  return "lock profiling enabled\n";
+}
+
+string LockInspector::disable(HttpRequest::Method, const Inspector::ArgList&)
+{
+  LockProfiler::setEnabled(false);
+  return "lock profiling disabled\n";
+}
+
+string LockInspector::reset(HttpRequest::Method, const Inspector::ArgList&)
+{
+  LockProfiler::reset();
+  return "lock stats cleared\n";
+}
@@ -0,0 +1,33 @@
+// Use of this source code is governed by a BSD-style license
+// that can be found in the License file.
+
+// Author: Shuo Chen (chenshuo at chenshuo dot com)
+//
+// This is an internal header file, you should not include this.
+
+#ifndef MUDUO_NET_INSPECT_LOCKINSPECTOR_H
+#define MUDUO_NET_INSPECT_LOCKINSPECTOR_H
+
+#include <muduo/net/inspect/Inspector.h>
+
+namespace muduo
+{
+namespace net
+{
+
+// contention of named MutexLocks, see LockProfiler.h
+class LockInspector : noncopyable
+{
+ public:
+  void registerCommands(Inspector* ins);
+
+  static string stats(HttpRequest::Method, const Inspector::ArgList&);
+  static string enable(HttpRequest::Method, const Inspector::ArgList&);
+  static string disable(HttpRequest::Method, const Inspector::ArgList&);
+  static string reset(HttpRequest::Method, const Inspector::ArgList&);
+};
+
+}  // namespace net
+}  // namespace muduo
+
+#endif  // MUDUO_NET_INSPECT_LOCKINSPECTOR_H
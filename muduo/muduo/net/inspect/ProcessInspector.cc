@@ -10,6 +10,9 @@
 #include <muduo/net/inspect/ProcessInspector.h>
 #include <muduo/base/FileUtil.h>
 #include <muduo/base/ProcessInfo.h>
+#include <muduo/base/Thread.h>
+#include <algorithm>
+#include <map>
 #include <limits.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -114,6 +117,77 @@ int stringPrintf(string* out, const char* fmt, ...)
   return ret;
 }
 
+// of a thread, at a moment.
+struct ThreadSample
+{
+  string comm;
+  char state;
+  ProcessInfo::CpuTime cpu;
+  long voluntarySwitches;
+  long involuntarySwitches;
+  int64_t waitNanoseconds;  // on run queue, from schedstat
+
+  ThreadSample()
+    : state('?'),
+      voluntarySwitches(0),
+      involuntarySwitches(0),
+      waitNanoseconds(0)
+  { }
+};
+
+bool sampleThread(pid_t tid, ThreadSample* sample)
+{
+  char filename[64];
+  string content;
+  snprintf(filename, sizeof filename, "/proc/self/task/%d/stat", tid);
+  if (FileUtil::readFile(filename, 65536, &content) != 0)
+  {
+    return false;
+  }
+  // comm may contain ' ' and ')'.
+  size_t lp = content.find('(');
+  size_t rp = content.rfind(')');
+  if (lp == string::npos || rp == string::npos || rp + 4 > content.size())
+  {
+    return false;
+  }
+  sample->comm = content.substr(lp + 1, rp - lp - 1);
+  sample->state = content[rp + 2];
+  StringPiece data(content);
+  data.remove_prefix(static_cast<int>(rp + 4));
+  sample->cpu = getCpuTime(data);
+
+  snprintf(filename, sizeof filename, "/proc/self/task/%d/status", tid);
+  if (FileUtil::readFile(filename, 65536, &content) == 0)
+  {
+    sample->voluntarySwitches = getLong(content, "\nvoluntary_ctxt_switches:");
+    sample->involuntarySwitches = getLong(content, "nonvoluntary_ctxt_switches:");
+  }
+
+  // "run wait timeslices", only if kernel has CONFIG_SCHEDSTATS.
+  snprintf(filename, sizeof filename, "/proc/self/task/%d/schedstat", tid);
+  if (FileUtil::readFile(filename, 1024, &content) == 0)
+  {
+    StringPiece wait = next(content);
+    sample->waitNanoseconds = strtoll(wait.data(), NULL, 10);
+  }
+  return true;
+}
+
+std::map<pid_t, ThreadSample> sampleThreads()
+{
+  std::map<pid_t, ThreadSample> samples;
+  for (pid_t tid : ProcessInfo::threads())
+  {
+    ThreadSample sample;
+    if (sampleThread(tid, &sample))
+    {
+      samples[tid] = sample;
+    }
+  }
+  return samples;
+}
+
 }  // namespace inspect
 }  // namespace muduo
 
@@ -128,6 +202,8 @@ void ProcessInspector::registerCommands(Inspector* ins)
   ins->add("proc", "status", ProcessInspector::procStatus, "print /proc/self/status");
   // ins->add("proc", "opened_files", ProcessInspector::openedFiles, "count /proc/self/fd");
   ins->add("proc", "threads", ProcessInspector::threads, "list /proc/self/task");
+  ins->add("proc", "threads_cpu", ProcessInspector::threadsCpu,
+           "cpu%, context switches, run queue delay per thread, /seconds to sample. CAUTION: blocking");
 }
 
 string ProcessInspector::overview(HttpRequest::Method, const Inspector::ArgList&)
@@ -237,3 +313,66 @@ string ProcessInspector::threads(HttpRequest::Method, const Inspector::ArgList&)
   return result;
 }
 
+
+// /proc/threads_cpu/<seconds>, sampled twice, sorted by cpu%.
+string ProcessInspector::threadsCpu(HttpRequest::Method, const Inspector::ArgList& args)
+{
+  double seconds = args.empty() ? 1.0 : ::atof(args[0].c_str());
+  seconds = std::min(std::max(seconds, 0.1), 10.0);
+
+  std::map<pid_t, ThreadSample> before = sampleThreads();
+  Timestamp start = Timestamp::now();
+  CurrentThread::sleepUsec(static_cast<int64_t>(seconds * Timestamp::kMicroSecondsPerSecond));
+  std::map<pid_t, ThreadSample> after = sampleThreads();
+  double elapsed = timeDifference(Timestamp::now(), start);
+  std::map<pid_t, string> names = Thread::runningThreads();
+
+  struct Row
+  {
+    pid_t tid;
+    const ThreadSample* sample;
+    double user;
+    double system;
+
+    bool operator<(const Row& rhs) const
+    {
+      return user + system > rhs.user + rhs.system;
+    }
+  };
+  std::vector<Row> rows;
+  for (const auto& it : after)
+  {
+    auto prev = before.find(it.first);
+    if (prev != before.end())
+    {
+      Row row = { it.first,
+                  &it.second,
+                  it.second.cpu.userSeconds - prev->second.cpu.userSeconds,
+                  it.second.cpu.systemSeconds - prev->second.cpu.systemSeconds };
+      rows.push_back(row);
+    }
+  }
+  std::sort(rows.begin(), rows.end());
+
+  string result;
+  result.reserve((rows.size() + 2) * 100);
+  stringPrintf(&result, "sampled %.3fs, %zd threads\n", elapsed, rows.size());
+  result += "  TID NAME                 S   CPU%   USR%   SYS%   VCSW/s  NVCSW/s  RUNQ ms/s\n";
+  for (const Row& row : rows)
+  {
+    const ThreadSample& now = *row.sample;
+    const ThreadSample& prev = before[row.tid];
+    auto name = names.find(row.tid);
+    stringPrintf(&result, "%5d %-20s %c %6.1f %6.1f %6.1f %8.1f %8.1f %10.3f\n",
+                 row.tid,
+                 name != names.end() ? name->second.c_str() : now.comm.c_str(),
+                 now.state,
+                 (row.user + row.system) * 100 / elapsed,
+                 row.user * 100 / elapsed,
+                 row.system * 100 / elapsed,
+                 static_cast<double>(now.voluntarySwitches - prev.voluntarySwitches) / elapsed,
+                 static_cast<double>(now.involuntarySwitches - prev.involuntarySwitches) / elapsed,
+                 static_cast<double>(now.waitNanoseconds - prev.waitNanoseconds) / 1e6 / elapsed);
+  }
+  return result;
+}
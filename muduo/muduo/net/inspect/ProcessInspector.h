@@ -28,6 +28,7 @@ class ProcessInspector : noncopyable
   static string procStatus(HttpRequest::Method, const Inspector::ArgList&);
   static string openedFiles(HttpRequest::Method, const Inspector::ArgList&);
   static string threads(HttpRequest::Method, const Inspector::ArgList&);
+  static string threadsCpu(HttpRequest::Method, const Inspector::ArgList&);
 
   static string username_;
 };
@@ -18,20 +18,24 @@ HEADERS += \
     Callbacks.h \
     Channel.h \
     Connector.h \
+    Coroutine.h \
     Endian.h \
     EventLoop.h \
     EventLoopThread.h \
     EventLoopThreadPool.h \
     InetAddress.h \
+    LogShipper.h \
     Poller.h \
     Socket.h \
     SocketsOps.h \
     TcpClient.h \
+    TcpClientPool.h \
     TcpConnection.h \
     TcpServer.h \
     Timer.h \
     TimerId.h \
     TimerQueue.h \
+    TimingWheel.h \
     ZlibStream.h \
     poller/EPollPoller.h \
     poller/PollPoller.h
@@ -46,14 +50,17 @@ SOURCES += \
     EventLoopThread.cc \
     EventLoopThreadPool.cc \
     InetAddress.cc \
+    LogShipper.cc \
     Poller.cc \
     Socket.cc \
     SocketsOps.cc \
     TcpClient.cc \
+    TcpClientPool.cc \
     TcpConnection.cc \
     TcpServer.cc \
     Timer.cc \
     TimerQueue.cc \
+    TimingWheel.cc \
     poller/DefaultPoller.cc \
     poller/EPollPoller.cc \
     poller/PollPoller.cc
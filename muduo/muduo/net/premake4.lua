@@ -10,15 +10,19 @@ project "net"
         'Buffer.h',
         'Callbacks.h',
         'Channel.h',
+        'Coroutine.h',
         'Endian.h',
         'EventLoop.h',
         'EventLoopThread.h',
         'EventLoopThreadPool.h',
         'InetAddress.h',
+        'LogShipper.h',
         'TcpClient.h',
+        'TcpClientPool.h',
         'TcpConnection.h',
         'TcpServer.h',
         'TimerId.h',
+        'TimingWheel.h',
     }
 
     files {
@@ -30,6 +34,7 @@ project "net"
         'EventLoopThread.cc',
         'EventLoopThreadPool.cc',
         'InetAddress.cc',
+        'LogShipper.cc',
         'Poller.cc',
         'poller/DefaultPoller.cc',
         'poller/EPollPoller.cc',
@@ -37,9 +42,11 @@ project "net"
         'Socket.cc',
         'SocketsOps.cc',
         'TcpClient.cc',
+        'TcpClientPool.cc',
         'TcpConnection.cc',
         'TcpServer.cc',
         'Timer.cc',
         'TimerQueue.cc',
+        'TimingWheel.cc',
      }
 
@@ -9,6 +9,7 @@
 #include <muduo/net/protorpc/RpcChannel.h>
 
 #include <muduo/base/Logging.h>
+#include <muduo/base/ShardedCounter.h>
 #include <muduo/net/protorpc/rpc.pb.h>
 
 #include <google/protobuf/descriptor.h>
@@ -16,8 +17,17 @@
 using namespace muduo;
 using namespace muduo::net;
 
+namespace
+{
+// of all channels, see Inspector /stats/counters/RpcChannel
+ShardedCounter g_callsSent("RpcChannel.calls_sent");
+ShardedCounter g_requestsReceived("RpcChannel.requests_received");
+ShardedCounter g_responsesReceived("RpcChannel.responses_received");
+}  // namespace
+
 RpcChannel::RpcChannel()
   : codec_(std::bind(&RpcChannel::onRpcMessage, this, _1, _2, _3)),
+    mutex_("RpcChannel"),
     services_(NULL)
 {
   LOG_INFO << "RpcChannel::ctor - " << this;
@@ -26,6 +36,7 @@ RpcChannel::RpcChannel()
 RpcChannel::RpcChannel(const TcpConnectionPtr& conn)
   : codec_(std::bind(&RpcChannel::onRpcMessage, this, _1, _2, _3)),
     conn_(conn),
+    mutex_("RpcChannel"),
     services_(NULL)
 {
   LOG_INFO << "RpcChannel::ctor - " << this;
@@ -55,7 +66,8 @@ void RpcChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
 {
   RpcMessage message;
   message.set_type(REQUEST);
-  int64_t id = id_.incrementAndGet();
+  // unique only, orders nothing
+  int64_t id = id_.incrementAndGetRelaxed();
   message.set_id(id);
   message.set_service(method->service()->full_name());
   message.set_method(method->name());
@@ -67,6 +79,7 @@ void RpcChannel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
   outstandings_[id] = out;
   }
   codec_.send(conn_, message);
+  g_callsSent.increment();
 }
 
 void RpcChannel::onMessage(const TcpConnectionPtr& conn,
@@ -85,6 +98,7 @@ void RpcChannel::onRpcMessage(const TcpConnectionPtr& conn,
   RpcMessage& message = *messagePtr;
   if (message.type() == RESPONSE)
   {
+    g_responsesReceived.increment();
     int64_t id = message.id();
     assert(message.has_response() || message.has_error());
 
@@ -115,6 +129,7 @@ void RpcChannel::onRpcMessage(const TcpConnectionPtr& conn,
   }
   else if (message.type() == REQUEST)
   {
+    g_requestsReceived.increment();
     // FIXME: extract to a function
     ErrorCode error = WRONG_PROTO;
     if (services_)
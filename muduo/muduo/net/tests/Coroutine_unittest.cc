@@ -0,0 +1,163 @@
+#include <muduo/net/Coroutine.h>
+#include <muduo/base/Logging.h>
+#include <muduo/net/Endian.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kMessages = 100;
+
+EventLoop* g_loop;
+ThreadPool* g_pool;
+int g_sessions = 0;
+bool g_clientDone = false;
+
+void testFramePool()
+{
+  net::detail::FramePool& pool = net::detail::FramePool::instance();
+  void* p = pool.allocate(100);
+  pool.deallocate(p, 100);
+  void* q = pool.allocate(120);
+  assert(p == q);
+  pool.deallocate(q, 120);
+}
+
+void sendMessage(const TcpConnectionPtr& conn, const string& message)
+{
+  Buffer buf;
+  buf.append(message);
+  buf.prependInt32(static_cast<int32_t>(message.size()));
+  conn->send(&buf);
+}
+
+int32_t parseLength(const string& header)
+{
+  int32_t be32 = 0;
+  memcpy(&be32, header.data(), sizeof be32);
+  return sockets::networkToHost32(be32);
+}
+
+// length prefixed echo
+Task<> serverSession(TcpConnectionPtr conn)
+{
+  CoConnection stream(conn);
+  ++g_sessions;
+  while (true)
+  {
+    string header = co_await stream.readExactly(sizeof(int32_t));
+    if (header.empty())
+    {
+      break;
+    }
+    string body = co_await stream.readExactly(parseLength(header));
+    sendMessage(conn, body);
+    if (!co_await stream.drain())
+    {
+      break;
+    }
+  }
+  printf("server session done\n");
+  --g_sessions;
+}
+
+int sumTo(int n)
+{
+  assert(!g_loop->isInLoopThread());
+  int sum = 0;
+  for (int i = 1; i <= n; ++i)
+  {
+    sum += i;
+  }
+  return sum;
+}
+
+Task<int> sumInPool(int n)
+{
+  int sum = co_await asyncRun(g_pool, std::bind(sumTo, n));
+  assert(g_loop->isInLoopThread());
+  co_return sum;
+}
+
+Task<> clientSession(TcpConnectionPtr conn)
+{
+  CoConnection stream(conn);
+  for (int i = 0; i < kMessages; ++i)
+  {
+    string message(static_cast<size_t>(i * 100 + 1), static_cast<char>('a' + i % 26));
+    sendMessage(conn, message);
+    string header = co_await stream.readExactly(sizeof(int32_t));
+    assert(parseLength(header) == static_cast<int32_t>(message.size()));
+    string echo = co_await stream.readExactly(message.size());
+    assert(echo == message);
+  }
+  printf("%d messages echoed\n", kMessages);
+
+  int sum = co_await sumInPool(100);
+  printf("sum = %d\n", sum);
+  assert(sum == 5050);
+
+  Timestamp start(Timestamp::now());
+  co_await asyncSleep(g_loop, 0.1);
+  double elapsed = timeDifference(Timestamp::now(), start);
+  printf("slept %.3f seconds\n", elapsed);
+  assert(elapsed >= 0.09);
+
+  conn->shutdown();
+  Buffer* buf = co_await stream.readSome();
+  printf("readSome() returns %p after peer closed\n", buf);
+  assert(buf == NULL);
+  assert(stream.closed());
+  g_clientDone = true;
+  g_loop->quit();
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    serverSession(conn).detach();
+  }
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    clientSession(conn).detach();
+  }
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  testFramePool();
+
+  EventLoop loop;
+  g_loop = &loop;
+  ThreadPool pool("CoroutinePool");
+  pool.start(2);
+  g_pool = &pool;
+
+  InetAddress listenAddr(2022, true);
+  TcpServer server(&loop, listenAddr, "CoroutineServer");
+  server.setConnectionCallback(onServerConnection);
+  server.start();
+
+  TcpClient client(&loop, listenAddr, "CoroutineClient");
+  client.setConnectionCallback(onClientConnection);
+  client.connect();
+
+  loop.runAfter(10.0, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  assert(g_clientDone);
+  assert(g_sessions == 0);
+  pool.stop();
+}
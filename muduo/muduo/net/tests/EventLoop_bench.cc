@@ -0,0 +1,161 @@
+// Benchmark of cross-thread task queueing, counts heap allocations made by
+// the calling thread per EventLoop::queueInLoop() and TcpConnection::send().
+
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Timestamp.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/EventLoopThread.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#include <new>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+__thread int64_t t_numAllocs = 0;
+
+void* operator new(size_t size)
+{
+  ++t_numAllocs;
+  void* p = malloc(size ? size : 1);
+  if (p == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+const int kTasks = 100 * 1000;
+
+EventLoop* g_ioLoop;
+TcpConnectionPtr g_conn;
+int64_t g_sum = 0;
+
+void task(int64_t x)
+{
+  g_sum += x;
+}
+
+void sendTask(const TcpConnectionPtr& conn, const string& message)
+{
+  conn->send(message);
+}
+
+// returns after io loop has run all queued tasks.
+void drain()
+{
+  CountDownLatch latch(1);
+  g_ioLoop->queueInLoop(std::bind(&CountDownLatch::countDown, &latch));
+  latch.wait();
+}
+
+template<typename F>
+void bench(const char* name, F func)
+{
+  // first round lets pendingFunctors_ grow to its steady capacity.
+  for (int round = 0; round < 2; ++round)
+  {
+    int64_t allocs = t_numAllocs;
+    Timestamp start(Timestamp::now());
+    for (int i = 0; i < kTasks; ++i)
+    {
+      func(i);
+    }
+    drain();
+    if (round == 1)
+    {
+      double seconds = timeDifference(Timestamp::now(), start);
+      printf("%-36s %6.2f allocs/op %8.1f ns/op\n", name,
+             static_cast<double>(t_numAllocs - allocs) / kTasks,
+             seconds * 1e9 / kTasks);
+    }
+  }
+}
+
+void queueStdFunction(int i)
+{
+  std::function<void()> f(std::bind(task, static_cast<int64_t>(i)));
+  g_ioLoop->queueInLoop(std::move(f));
+}
+
+void queueBind(int i)
+{
+  g_ioLoop->queueInLoop(std::bind(task, static_cast<int64_t>(i)));
+}
+
+void queueSendStdFunction(int)
+{
+  static const string message("hello");
+  std::function<void()> f(std::bind(sendTask, g_conn, message));
+  g_ioLoop->queueInLoop(std::move(f));
+}
+
+void connSend(int)
+{
+  g_conn->send(StringPiece("hello"));
+}
+
+EventLoop* g_loop;
+
+void runBench()
+{
+  printf("sizeof(EventLoop::InlineFunctor) = %zu\n", sizeof(EventLoop::InlineFunctor));
+  bench("queueInLoop(std::function)", queueStdFunction);
+  bench("queueInLoop(bind)", queueBind);
+  bench("queueInLoop(std::function send)", queueSendStdFunction);
+  bench("TcpConnection::send cross-thread", connSend);
+  printf("sum = %" PRId64 "\n", g_sum);
+
+  g_conn->forceClose();
+  g_conn.reset();
+  g_loop->runAfter(0.5, std::bind(&EventLoop::quit, g_loop));
+}
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    g_conn = conn;
+    g_ioLoop = conn->getLoop();
+    g_loop->queueInLoop(runBench);
+  }
+}
+
+void onClientMessage(const TcpConnectionPtr&, Buffer* buf, Timestamp)
+{
+  buf->retrieveAll();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  EventLoop loop;
+  g_loop = &loop;
+  EventLoopThread clientThread;
+
+  InetAddress listenAddr(2019, true);
+  TcpServer server(&loop, listenAddr, "BenchServer");
+  server.setConnectionCallback(onServerConnection);
+  // connections are in io thread, bench runs in loop thread.
+  server.setThreadNum(1);
+  server.start();
+
+  TcpClient client(clientThread.startLoop(), listenAddr, "BenchClient");
+  client.setMessageCallback(onClientMessage);
+  client.connect();
+  loop.loop();
+}
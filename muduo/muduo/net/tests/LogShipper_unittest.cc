@@ -0,0 +1,207 @@
+#include <muduo/net/LogShipper.h>
+#include <muduo/base/CountDownLatch.h>
+#include <muduo/base/CurrentThread.h>
+#include <muduo/base/Logging.h>
+#include <muduo/base/Thread.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/TcpServer.h>
+
+#include <algorithm>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+EventLoop* g_loop;
+TcpServer* g_lateServer;
+string g_received;  // in loop thread, read after g_closeLatch
+CountDownLatch* g_closeLatch;
+AsyncLogging* g_asyncLog;
+int g_mainTid;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (!conn->connected())
+  {
+    g_closeLatch->countDown();
+  }
+}
+
+void onServerMessage(const TcpConnectionPtr& /*conn*/, Buffer* buf, Timestamp)
+{
+  int n = 0;
+  while ((n = LogShipper::decodeFrame(buf->peek(), buf->readableBytes(), &g_received)) > 0)
+  {
+    buf->retrieve(n);
+  }
+  assert(n == 0);
+}
+
+int countLines()
+{
+  return static_cast<int>(std::count(g_received.begin(), g_received.end(), '\n'));
+}
+
+int countLines(const char* prefix)
+{
+  int lines = 0;
+  for (size_t pos = 0; (pos = g_received.find(prefix, pos)) != string::npos; ++pos)
+  {
+    ++lines;
+  }
+  return lines;
+}
+
+// the collector's loop outlives g_asyncLog, it logs to stdout.
+void asyncOutput(const char* msg, int len)
+{
+  if (g_asyncLog == NULL || CurrentThread::tid() == g_mainTid)
+  {
+    fwrite(msg, 1, len, stdout);
+  }
+  else
+  {
+    g_asyncLog->append(msg, len);
+  }
+}
+
+void startLateServer()
+{
+  g_lateServer->start();
+}
+
+// ships through AsyncLogging, compressed if zlib is there, LogShipper logs
+// to the AsyncLogging too, till it is destroyed by it.
+void testAsyncLogging()
+{
+  CountDownLatch closed(1);
+  g_closeLatch = &closed;
+  LogShipper* shipper = NULL;
+  Logger::setLogLevel(Logger::INFO);
+  {
+  AsyncLogging log("logshipper_unittest", "", 1000*1000*1000);
+  g_asyncLog = &log;
+  Logger::setOutput(asyncOutput);
+  LogShipper::Options options;
+  options.compress = true;
+  options.batchBytes = 64*1024;
+  shipper = new LogShipper(InetAddress(2040, true), "LogShipper", options);
+  log.setSink(std::unique_ptr<LogSink>(shipper));
+  log.start();
+  char line[64];
+  for (int i = 0; i < 100000; ++i)
+  {
+    int len = snprintf(line, sizeof line, "shipped line %d\n", i);
+    log.append(line, len);
+  }
+  log.stop();
+  printf("sent %" PRId64 " bytes\n", shipper->sentBytes());
+  }
+  g_asyncLog = NULL;
+  Logger::setLogLevel(Logger::ERROR);
+  closed.wait();
+  printf("received %d lines\n", countLines("shipped line "));
+  assert(countLines("shipped line ") == 100000);
+  assert(g_received.find("shipped line 99999\n") != string::npos);
+  g_received.clear();
+}
+
+// collector is down, frames are spilled, the next shipper sends them.
+void testSpill()
+{
+  char spillFile[64];
+  snprintf(spillFile, sizeof spillFile, "/tmp/logshipper_unittest.%d.spill", getpid());
+  LogShipper::Options options;
+  options.spillFile = spillFile;
+  {
+  LogShipper shipper(InetAddress(2041, true), "Spiller", options);
+  for (int i = 0; i < 1000; ++i)
+  {
+    char line[64];
+    int len = snprintf(line, sizeof line, "spilled line %d\n", i);
+    shipper.append(line, len);
+    if (i % 100 == 99)
+    {
+      shipper.flush();
+    }
+  }
+  }
+  struct stat st;
+  ::stat(spillFile, &st);
+  printf("spill file %" PRId64 " bytes\n", static_cast<int64_t>(st.st_size));
+  assert(st.st_size > 0);
+
+  CountDownLatch closed(1);
+  g_closeLatch = &closed;
+  g_loop->runInLoop(startLateServer);
+  {
+  LogShipper shipper(InetAddress(2041, true), "Drainer", options);
+  for (int i = 0; i < 1000 && shipper.sentBytes() < st.st_size; ++i)
+  {
+    ::usleep(10*1000);
+  }
+  assert(shipper.sentBytes() == st.st_size);
+  }
+  closed.wait();
+  printf("received %d lines\n", countLines());
+  assert(countLines() == 1000);
+  assert(g_received.find("spilled line 0\n") == 0);
+  g_received.clear();
+  ::stat(spillFile, &st);
+  assert(st.st_size == 0);
+
+  // bounded
+  options.maxSpillBytes = 4096;
+  options.batchBytes = 1000;
+  {
+  LogShipper shipper(InetAddress(2042, true), "Dropper", options);
+  string line(100, 'x');
+  for (int i = 0; i < 100; ++i)
+  {
+    shipper.append(line.data(), line.size());
+  }
+  shipper.flush();
+  // frames are spilled in loop thread
+  for (int i = 0; i < 100 && shipper.spilledBytes() + shipper.droppedBytes() < 10000; ++i)
+  {
+    ::usleep(10*1000);
+  }
+  printf("spilled %" PRId64 " dropped %" PRId64 "\n", shipper.spilledBytes(), shipper.droppedBytes());
+  assert(shipper.spilledBytes() <= 4096);
+  assert(shipper.droppedBytes() > 0);
+  }
+  ::unlink(spillFile);
+}
+
+void producer()
+{
+  testAsyncLogging();
+  testSpill();
+  g_loop->quit();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::ERROR);
+  g_mainTid = CurrentThread::tid();
+  EventLoop loop;
+  g_loop = &loop;
+  TcpServer server(&loop, InetAddress(2040, true), "Collector");
+  server.setConnectionCallback(onServerConnection);
+  server.setMessageCallback(onServerMessage);
+  server.start();
+  TcpServer lateServer(&loop, InetAddress(2041, true), "LateCollector");
+  lateServer.setConnectionCallback(onServerConnection);
+  lateServer.setMessageCallback(onServerMessage);
+  g_lateServer = &lateServer;
+
+  Thread thread(producer, "producer");
+  thread.start();
+  loop.loop();
+  thread.join();
+}
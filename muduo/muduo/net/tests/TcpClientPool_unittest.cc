@@ -0,0 +1,131 @@
+#include <muduo/net/TcpClientPool.h>
+#include <muduo/base/Logging.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpServer.h>
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <set>
+
+using namespace muduo;
+using namespace muduo::net;
+
+const int kConnectionsPerEndpoint = 3;
+
+EventLoop* g_loop;
+TcpClientPool* g_pool;
+std::vector<TcpConnectionPtr> g_serverConns;
+bool g_warm = false;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  if (conn->connected())
+  {
+    g_serverConns.push_back(conn);
+  }
+}
+
+void testAcquire()
+{
+  assert(g_pool->numConnected() == 2 * kConnectionsPerEndpoint);
+  g_warm = true;
+
+  // least outstanding spreads requests over every member
+  std::set<int> ids;
+  std::vector<TcpConnectionPtr> conns;
+  for (int i = 0; i < g_pool->size(); ++i)
+  {
+    TcpConnectionPtr conn;
+    int id = g_pool->acquire(&conn);
+    assert(id >= 0 && conn);
+    ids.insert(id);
+    conns.push_back(conn);
+  }
+  printf("%s", g_pool->stats().c_str());
+  assert(static_cast<int>(ids.size()) == g_pool->size());
+  for (int id : ids)
+  {
+    g_pool->release(id);
+  }
+
+  // server kicks one, pool reconnects
+  TcpConnectionPtr kicked(g_serverConns.front());
+  g_serverConns.erase(g_serverConns.begin());
+  kicked->forceClose();
+}
+
+void checkReconnected()
+{
+  printf("%s", g_pool->stats().c_str());
+  assert(g_pool->numConnected() == g_pool->size());
+  g_loop->quit();
+}
+
+void checkUp(TcpClientPool* pool)
+{
+  printf("%s", pool->stats().c_str());
+  assert(pool->numConnected() == pool->size());
+  g_loop->quit();
+}
+
+// setRetryDelay() also paces failed connect attempts, an endpoint that
+// comes up late is connected in a fraction of the 0.5s default.
+void testLateEndpoint()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress addr(2022, true);
+  TcpServer server(&loop, addr, "LateServer");  // bound, not listening yet
+  TcpClientPool pool(&loop, "LatePool");
+  pool.setThreadNum(1);
+  pool.addEndpoint(addr, 2);
+  pool.setRetryDelay(0.05, 0.1);
+  pool.start();
+
+  loop.runAfter(0.8, std::bind(&TcpServer::start, &server));
+  loop.runAfter(1.1, std::bind(checkUp, &pool));
+  loop.runAfter(5.0, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  pool.stop();
+}
+
+void testPool()
+{
+  EventLoop loop;
+  g_loop = &loop;
+
+  InetAddress addr1(2020, true);
+  InetAddress addr2(2021, true);
+  TcpServer server1(&loop, addr1, "PoolServer1");
+  TcpServer server2(&loop, addr2, "PoolServer2");
+  server1.setConnectionCallback(onServerConnection);
+  server2.setConnectionCallback(onServerConnection);
+  server1.start();
+  server2.start();
+
+  TcpClientPool pool(&loop, "TestPool", TcpClientPool::kLeastOutstanding);
+  g_pool = &pool;
+  pool.setThreadNum(2);
+  pool.addEndpoint(addr1, kConnectionsPerEndpoint);
+  pool.addEndpoint(addr2, kConnectionsPerEndpoint);
+  pool.setRetryDelay(0.1, 1.0);
+  // warm up callback is invoked in io thread of pool
+  pool.setWarmUpCallback(std::bind(&EventLoop::runInLoop, &loop, testAcquire));
+  pool.start();
+
+  loop.runAfter(1.5, checkReconnected);
+  loop.runAfter(5.0, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  assert(g_warm);
+  g_serverConns.clear();
+  pool.stop();
+}
+
+int main()
+{
+  Logger::setLogLevel(Logger::WARN);
+  testPool();
+  testLateEndpoint();
+}
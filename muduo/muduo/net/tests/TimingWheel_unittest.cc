@@ -0,0 +1,125 @@
+#include <muduo/net/TimingWheel.h>
+#include <muduo/net/EventLoop.h>
+#include <muduo/net/InetAddress.h>
+#include <muduo/net/TcpClient.h>
+#include <muduo/net/TcpServer.h>
+
+#define __STDC_FORMAT_MACROS
+#include <inttypes.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace muduo;
+using namespace muduo::net;
+
+EventLoop* g_loop;
+TimingWheel* g_wheel;
+int g_expired = 0;
+
+// expire once at deadline
+int64_t once(const char* name, int64_t deadline, int64_t now)
+{
+  printf("%s expired at tick %" PRId64 ", deadline %" PRId64 "\n", name, now, deadline);
+  assert(now == deadline);
+  ++g_expired;
+  return 0;
+}
+
+// owner keeps active until tick 10, then expire 3 ticks later
+int64_t refreshing(int64_t now)
+{
+  int64_t lastActive = now < 10 ? now : 10;
+  if (lastActive + 3 > now)
+  {
+    return lastActive + 3;
+  }
+  printf("refreshing expired at tick %" PRId64 "\n", now);
+  assert(now == 13);
+  ++g_expired;
+  return 0;
+}
+
+int64_t neverCalled(int64_t now)
+{
+  printf("neverCalled at tick %" PRId64 "\n", now);
+  abort();
+  return 0;
+}
+
+void testWheel()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  TimingWheel wheel(&loop, 0.01);
+  g_wheel = &wheel;
+
+  TimingWheel::Entry near, far, refresh, cancelled;
+  near.setExpireCallback(std::bind(once, "near", 4, _1));
+  far.setExpireCallback(std::bind(once, "far", 1 + TimingWheel::kNumSlots + 5, _1));
+  refresh.setExpireCallback(refreshing);
+  cancelled.setExpireCallback(neverCalled);
+
+  wheel.schedule(&near, 4);
+  wheel.schedule(&far, 1 + TimingWheel::kNumSlots + 5);
+  wheel.schedule(&refresh, 2);
+  wheel.schedule(&cancelled, 3);
+  assert(cancelled.linked());
+  cancelled.unlink();
+  assert(!cancelled.linked());
+
+  loop.runAfter(1.5, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  printf("expired %d\n", g_expired);
+  assert(g_expired == 3);
+  assert(!near.linked() && !far.linked() && !refresh.linked());
+}
+
+int g_up = 0;
+int g_down = 0;
+
+void onServerConnection(const TcpConnectionPtr& conn)
+{
+  printf("server %s is %s at %s\n", conn->name().c_str(),
+         conn->connected() ? "UP" : "DOWN",
+         Timestamp::now().toString().c_str());
+  conn->connected() ? ++g_up : ++g_down;
+}
+
+void onClientConnection(const TcpConnectionPtr& conn)
+{
+  if (!conn->connected())
+  {
+    g_loop->quit();
+  }
+}
+
+void testIdleTimeout()
+{
+  EventLoop loop;
+  g_loop = &loop;
+  InetAddress listenAddr(2018, true);
+  TcpServer server(&loop, listenAddr, "IdleServer");
+  server.setConnectionCallback(onServerConnection);
+  server.setIdleTimeout(1.0);
+  server.start();
+
+  TcpClient client(&loop, listenAddr, "IdleClient");
+  client.setConnectionCallback(onClientConnection);
+  client.connect();
+
+  Timestamp start(Timestamp::now());
+  loop.runAfter(5.0, std::bind(&EventLoop::quit, &loop));
+  loop.loop();
+  double elapsed = timeDifference(Timestamp::now(), start);
+  printf("idle connection kicked after %.3f seconds\n", elapsed);
+  assert(g_up == 1 && g_down == 1);
+  assert(elapsed > 0.9 && elapsed < 3.0);
+}
+
+int main()
+{
+  testWheel();
+  testIdleTimeout();
+}